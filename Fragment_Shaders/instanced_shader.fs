@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 ourColor;
+in vec2 TexCoord;
+in float textured;
+
+uniform sampler2D ourTexture;
+
+void main()
+{
+    vec4 color = vec4(ourColor, 1.0);
+    if (textured > 0.5) {
+        color *= texture(ourTexture, TexCoord);
+    }
+    FragColor = color;
+}
@@ -0,0 +1,106 @@
+// BitStream.hpp header for packing values into packets a few bits at a time
+// BITSTREAM_H
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+
+/*
+	Writes values of any width from 1 to 32 bits, lowest bit first, into a byte buffer
+	Writing past capacity is ignored and remembered, check overflowed() before sending
+*/
+class BitWriter {
+public:
+	BitWriter(unsigned char* out, int capacity) : out(out), capacity(capacity), bytes(0), buffer(0), bits(0), overflow(false) {}
+
+	/* writes the low count bits of value*/
+	void write(unsigned int value, int count) {
+		buffer |= (unsigned long long)(value & (count == 32 ? 0xFFFFFFFFu : ((1u << count) - 1))) << bits;
+		bits += count;
+		while (bits >= 8) {
+			put((unsigned char)buffer);
+			buffer >>= 8;
+			bits -= 8;
+		}
+	}
+
+	void writeBit(bool value) {
+		write(value ? 1u : 0u, 1);
+	}
+
+	/* writes out the last partial byte, returns how many bytes were written in total*/
+	int finish() {
+		if (bits > 0) {
+			put((unsigned char)buffer);
+			buffer = 0;
+			bits = 0;
+		}
+		return bytes;
+	}
+
+	bool overflowed() const {
+		return overflow;
+	}
+
+private:
+	unsigned char* out;
+	int capacity;
+	int bytes;
+	unsigned long long buffer;
+	int bits;
+	bool overflow;
+
+	void put(unsigned char byte) {
+		if (bytes < capacity) {
+			out[bytes++] = byte;
+		}
+		else {
+			overflow = true;
+		}
+	}
+};
+
+
+/*
+	Reads back what a BitWriter wrote. Reading past the end gives zeros and sets overflowed()
+*/
+class BitReader {
+public:
+	BitReader(const unsigned char* in, int length) : in(in), length(length), bytes(0), buffer(0), bits(0), overflow(false) {}
+
+	/* reads count bits (1 to 32)*/
+	unsigned int read(int count) {
+		while (bits < count) {
+			unsigned long long byte = 0;
+			if (bytes < length) {
+				byte = in[bytes++];
+			}
+			else {
+				overflow = true;
+			}
+			buffer |= byte << bits;
+			bits += 8;
+		}
+		unsigned int value = (unsigned int)(buffer & (count == 32 ? 0xFFFFFFFFull : ((1ull << count) - 1)));
+		buffer >>= count;
+		bits -= count;
+		return value;
+	}
+
+	bool readBit() {
+		return read(1) != 0;
+	}
+
+	bool overflowed() const {
+		return overflow;
+	}
+
+private:
+	const unsigned char* in;
+	int length;
+	int bytes;
+	unsigned long long buffer;
+	int bits;
+	bool overflow;
+};
+
+#endif
@@ -0,0 +1,38 @@
+// BlockCodec.hpp header for a small dependency free compressor for replay blocks
+// BLOCKCODEC_H
+#ifndef BLOCKCODEC_H
+#define BLOCKCODEC_H
+
+#include <cstddef>
+#include <vector>
+
+
+/*
+	LZ77 with an adaptive binary range coder behind it, in the spirit of LZMA but a few hundred lines
+	Every block is compressed on its own with fresh models, so any block can be decoded without the ones before it
+	A replay block is a few hundred bytes of varint records and keyframes, and is repetitive in a particular way:
+	keyframes repeat some of their bytes (bar x positions, scores, the high bytes of tick) at a distance that
+	stays the same for a while, and records are a handful of recurring byte patterns. So a match can reuse the last
+	distance for the price of one bit, literals are coded in the context of the byte before them, and matches start
+	at 3 bytes
+*/
+
+// shortest and longest match, and how far back a match may reach
+static const int CODEC_MIN_MATCH = 3;
+static const int CODEC_MAX_MATCH = CODEC_MIN_MATCH + 63;
+static const int CODEC_WINDOW = 65535;
+
+/* compresses size bytes from in, appending them to out. Returns the bytes appended*/
+size_t compressBlock(const unsigned char* in, size_t size, std::vector<unsigned char>* out);
+
+/* decompresses a block of rawSize bytes into out. Returns false if in is not a block that long*/
+bool decompressBlock(const unsigned char* in, size_t size, unsigned char* out, size_t rawSize);
+
+/*
+	CRC-32 (the zlib one) of size bytes, carrying on from the checksum of the bytes before them if given one. Stored
+	with every block so one that was damaged on disk, stored or not, is caught instead of played, and so is one the
+	decoder got wrong
+*/
+unsigned int blockChecksum(const unsigned char* in, size_t size, unsigned int checksum = 0);
+
+#endif
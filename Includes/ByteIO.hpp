@@ -0,0 +1,108 @@
+// ByteIO.hpp header for reading and writing little endian values in packets and files
+// BYTEIO_H
+#ifndef BYTEIO_H
+#define BYTEIO_H
+
+#include <cstring>
+
+
+/*
+	Values are written byte by byte in little endian order, so both ends agree whatever the machine
+	Every function moves the pointer past what it wrote or read, callers check the space first
+*/
+
+inline void writeU8(unsigned char*& out, unsigned char value) {
+	*out++ = value;
+}
+
+inline void writeU16(unsigned char*& out, unsigned short value) {
+	out[0] = (unsigned char)(value & 0xFF);
+	out[1] = (unsigned char)(value >> 8);
+	out += 2;
+}
+
+inline void writeU32(unsigned char*& out, unsigned int value) {
+	for (int i = 0; i < 4; i++) {
+		out[i] = (unsigned char)(value >> (8 * i));
+	}
+	out += 4;
+}
+
+inline void writeI64(unsigned char*& out, long long value) {
+	unsigned long long bits = (unsigned long long)value;
+	for (int i = 0; i < 8; i++) {
+		out[i] = (unsigned char)(bits >> (8 * i));
+	}
+	out += 8;
+}
+
+inline void writeF32(unsigned char*& out, float value) {
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeU32(out, bits);
+}
+
+inline unsigned char readU8(const unsigned char*& in) {
+	return *in++;
+}
+
+inline unsigned short readU16(const unsigned char*& in) {
+	unsigned short value = (unsigned short)(in[0] | (in[1] << 8));
+	in += 2;
+	return value;
+}
+
+inline unsigned int readU32(const unsigned char*& in) {
+	unsigned int value = 0;
+	for (int i = 0; i < 4; i++) {
+		value |= (unsigned int)in[i] << (8 * i);
+	}
+	in += 4;
+	return value;
+}
+
+inline long long readI64(const unsigned char*& in) {
+	unsigned long long bits = 0;
+	for (int i = 0; i < 8; i++) {
+		bits |= (unsigned long long)in[i] << (8 * i);
+	}
+	in += 8;
+	return (long long)bits;
+}
+
+inline float readF32(const unsigned char*& in) {
+	unsigned int bits = readU32(in);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// longest varint, a full 64 bit value
+static const int VARINT_MAX_BYTES = 10;
+
+/* writes value 7 bits at a time, lowest first, with the top bit of each byte saying another follows*/
+inline void writeVarint(unsigned char*& out, unsigned long long value) {
+	while (value >= 0x80) {
+		*out++ = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (unsigned char)value;
+}
+
+/* reads a varint without going past end, returns false (leaving in alone) if it is cut off*/
+inline bool readVarint(const unsigned char*& in, const unsigned char* end, unsigned long long* value) {
+	unsigned long long result = 0;
+	const unsigned char* at = in;
+	for (int shift = 0; shift < 7 * VARINT_MAX_BYTES && at < end; shift += 7) {
+		unsigned char byte = *at++;
+		result |= (unsigned long long)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			in = at;
+			return true;
+		}
+	}
+	return false;
+}
+
+#endif
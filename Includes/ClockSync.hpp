@@ -0,0 +1,116 @@
+// ClockSync.hpp header for estimating the remote peer's clock and sizing the input delay from how packets arrive
+// CLOCKSYNC_H
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+
+/*
+	Class which estimates the offset and drift between our clock and the remote peer's, NTP style
+	Every exchange gives four times: we send (t1), they receive (t2), they send (t3), we receive (t4)
+	offset = ((t2 - t1) + (t3 - t4)) / 2 and the round trip is (t4 - t1) - (t3 - t2)
+	Queueing only ever makes a round trip longer and skews its offset, so like NTP's clock filter we trust the exchange
+	with the shortest round trip out of the last WINDOW. Drift is the slope of a least squares line through the offset
+	of the shortest round trip of every second, over the last HISTORY seconds
+	All times are nanoseconds, ours on the InputQueue clock
+*/
+class ClockSync {
+public:
+	// exchanges the clock filter picks the shortest round trip from
+	static const int WINDOW = 8;
+
+	// offsets kept for the drift fit, one per second
+	static const int HISTORY = 16;
+
+	ClockSync();
+
+	/* forgets every sample*/
+	void reset();
+
+	/* one exchange: we sent at sent, they got it at remoteReceived, answered at remoteSent and we got the answer at received*/
+	void addSample(long long sent, long long remoteReceived, long long remoteSent, long long received);
+
+	/* whether we have a sample to go on*/
+	bool synced() const;
+
+	/* remote clock minus ours, at our time localTime*/
+	long long offset(long long localTime) const;
+
+	/* a time on the remote clock, on ours*/
+	long long toLocal(long long remoteTime) const;
+
+	/* round trip of the exchange the offset comes from*/
+	float rttMs() const;
+
+	/* how fast the remote clock runs compared to ours, in parts per million*/
+	float driftPpm() const;
+
+private:
+	struct Sample {
+		long long time;
+		long long offset;
+		long long rtt;
+	};
+
+	Sample window[WINDOW];
+	int windowCount, windowNext;
+	// the shortest round trip in the window
+	Sample best;
+
+	Sample history[HISTORY];
+	int historyCount, historyNext;
+	long long lastHistory;
+	// the shortest round trip since the last history point (rtt -1 when none)
+	Sample candidate;
+	// remote nanoseconds per local nanosecond, minus one
+	double drift;
+
+	/* refits the drift to the history*/
+	void fitDrift();
+};
+
+
+/*
+	Class which sizes the jitter buffer for remote inputs from how their packets arrive
+	The buffer is the input delay itself: a remote input for tick T sits in the tick ring until we reach T, so the
+	sender has to schedule it far enough ahead to cover the one way trip, its variance and the odd lost packet
+	(a lost input rides along in the next packet one tick later)
+	Transit is the one way time worked out with ClockSync, jitter the RFC 3550 estimate (mean difference between the
+	transit of consecutive packets) and loss is spotted from gaps in the packets' sequence numbers. A duplicated packet
+	is not a late one, so duplicates of the last SEEN_WINDOW sequence numbers are ignored altogether
+*/
+class JitterBuffer {
+public:
+	// packets to see before recommending anything
+	static const int MIN_PACKETS = 30;
+
+	// sequence numbers behind the newest we remember having seen, one bit each
+	static const int SEEN_WINDOW = 64;
+
+	JitterBuffer();
+
+	/* forgets every packet*/
+	void reset();
+
+	/* one packet that took transit nanoseconds*/
+	void packet(long long transit, unsigned short sequence);
+
+	/* whether enough packets came in to size the buffer*/
+	bool ready() const;
+
+	/* the input delay, in ticks of tickNs, that covers the remote inputs' transit and jitter*/
+	int targetTicks(long long tickNs) const;
+
+	float transitMs() const;
+	float jitterMs() const;
+	float lossPercent() const;
+
+private:
+	int packets;
+	double transit, jitter, loss;
+	long long lastTransit;
+	unsigned short lastSequence;
+	// bit i set if lastSequence - i arrived
+	unsigned long long seen;
+};
+
+#endif
@@ -0,0 +1,207 @@
+// GpuResources.hpp header for owning opengl objects through checked handles, with deferred deletion and leak accounting
+// GPURESOURCES_H
+#ifndef GPURESOURCES_H
+#define GPURESOURCES_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+
+
+// kinds of opengl objects the manager knows how to create and delete
+enum GpuResourceType { GPU_BUFFER, GPU_VERTEX_ARRAY, GPU_TEXTURE, GPU_PROGRAM, GPU_FRAMEBUFFER, GPU_RENDERBUFFER, GPU_RESOURCE_TYPES };
+
+
+/*
+	Handle to an object owned by a GpuResourceManager
+	The index picks a slot in the pool for TYPE, and the generation must match the slot's, so a handle to something
+	that has been released resolves to 0 instead of to whatever object reused the slot. Generation 0 is the null handle
+*/
+template <GpuResourceType TYPE>
+struct GpuHandle {
+	unsigned int index;
+	unsigned int generation;
+
+	GpuHandle() : index(0), generation(0) {}
+	GpuHandle(unsigned int index, unsigned int generation) : index(index), generation(generation) {}
+
+	bool isNull() const {
+		return generation == 0;
+	}
+};
+
+typedef GpuHandle<GPU_BUFFER> BufferHandle;
+typedef GpuHandle<GPU_VERTEX_ARRAY> VertexArrayHandle;
+typedef GpuHandle<GPU_TEXTURE> TextureHandle;
+typedef GpuHandle<GPU_PROGRAM> ProgramHandle;
+typedef GpuHandle<GPU_FRAMEBUFFER> FramebufferHandle;
+typedef GpuHandle<GPU_RENDERBUFFER> RenderbufferHandle;
+
+
+/*
+	Class which creates and deletes every opengl object we use and keeps count of them
+	Released objects are only deleted FRAMES_IN_FLIGHT frames later (endFrame), since the gpu may still be using them
+	Live counts and byte totals per type let us check that a long running process stays flat
+*/
+class GpuResourceManager {
+public:
+	// how many frames a released object waits before we actually delete it
+	static const int FRAMES_IN_FLIGHT = 3;
+
+	GpuResourceManager();
+
+	/* creates a buffer, binds it to target and uploads bytes of data (data can be nullptr to only allocate)*/
+	BufferHandle createBuffer(GLenum target, size_t bytes, const void* data, GLenum usage);
+
+	/* creates a vertex array object (not bound)*/
+	VertexArrayHandle createVertexArray();
+
+	/* loads an image into a mipmapped texture (see loadTexture in glHelpers), a null handle if it could not be loaded*/
+	TextureHandle loadTexture(const char* path);
+
+	/* takes ownership of an already linked program (from the Shader class)*/
+	ProgramHandle adoptProgram(unsigned int program);
+
+	/* creates a framebuffer object (not bound)*/
+	FramebufferHandle createFramebuffer();
+
+	/* creates a renderbuffer with storage for a width by height image in format (bound to GL_RENDERBUFFER)*/
+	RenderbufferHandle createRenderbuffer(GLenum format, int width, int height, int bytesPerPixel);
+
+	/* the opengl name behind a handle, or 0 if the handle is null or has been released*/
+	template <GpuResourceType TYPE>
+	unsigned int name(GpuHandle<TYPE> handle) const {
+		return nameOf(TYPE, handle.index, handle.generation);
+	}
+
+	/* queues the object for deletion and nulls the handle. Releasing a null or stale handle does nothing*/
+	template <GpuResourceType TYPE>
+	void release(GpuHandle<TYPE>& handle) {
+		releaseSlot(TYPE, handle.index, handle.generation);
+		handle = GpuHandle<TYPE>();
+	}
+
+	/* record a new size for a buffer after respecifying its storage*/
+	void setBytes(BufferHandle handle, size_t bytes);
+
+	/* call once per frame: deletes the objects released FRAMES_IN_FLIGHT frames ago*/
+	void endFrame();
+
+	/* deletes everything that has been released right away (at shutdown, when nothing is in flight any more)*/
+	void flush();
+
+	/* number of objects of a type that currently exist in opengl (including ones waiting for deferred deletion)*/
+	size_t liveCount(GpuResourceType type) const;
+
+	/* bytes of gpu memory we allocated for live objects of a type*/
+	size_t liveBytes(GpuResourceType type) const;
+
+	/* objects released but not deleted yet*/
+	size_t pendingCount() const;
+
+	/* objects of a type deleted so far. When it changes, opengl may hand out a deleted object's name again*/
+	unsigned long long deletedCount(GpuResourceType type) const;
+
+	/* prints every type that still has live objects. Returns the total number of live objects*/
+	size_t reportLeaks() const;
+
+	static const char* typeName(GpuResourceType type);
+
+private:
+	struct Slot {
+		unsigned int name;
+		unsigned int generation;
+		size_t bytes;
+		// the handle has been released, the object is waiting to be deleted
+		bool released;
+	};
+
+	struct PendingDelete {
+		GpuResourceType type;
+		unsigned int index;
+		unsigned long long frame;
+	};
+
+	std::vector<Slot> slots[GPU_RESOURCE_TYPES];
+	std::vector<unsigned int> freeSlots[GPU_RESOURCE_TYPES];
+	std::vector<PendingDelete> pending;
+
+	size_t counts[GPU_RESOURCE_TYPES];
+	size_t bytes[GPU_RESOURCE_TYPES];
+	unsigned long long deletions[GPU_RESOURCE_TYPES];
+
+	unsigned long long frame;
+
+	/* puts a freshly created object in a slot. Returns the slot index and its generation*/
+	void allocate(GpuResourceType type, unsigned int name, size_t size, unsigned int* index, unsigned int* generation);
+
+	unsigned int nameOf(GpuResourceType type, unsigned int index, unsigned int generation) const;
+
+	void releaseSlot(GpuResourceType type, unsigned int index, unsigned int generation);
+
+	/* deletes the opengl object in a slot and returns the slot to the free list*/
+	void destroySlot(GpuResourceType type, unsigned int index);
+};
+
+
+/*
+	Owning wrapper around a handle: releases it when it goes out of scope or is reassigned
+	Move only, so there is always exactly one owner
+*/
+template <GpuResourceType TYPE>
+class GpuResource {
+public:
+	GpuResource() : manager(nullptr) {}
+
+	GpuResource(GpuResourceManager* manager, GpuHandle<TYPE> handle) : manager(manager), handle(handle) {}
+
+	GpuResource(GpuResource&& other) : manager(other.manager), handle(other.handle) {
+		other.handle = GpuHandle<TYPE>();
+	}
+
+	GpuResource& operator=(GpuResource&& other) {
+		if (this != &other) {
+			reset();
+			manager = other.manager;
+			handle = other.handle;
+			other.handle = GpuHandle<TYPE>();
+		}
+		return *this;
+	}
+
+	GpuResource(const GpuResource&) = delete;
+	GpuResource& operator=(const GpuResource&) = delete;
+
+	~GpuResource() {
+		reset();
+	}
+
+	/* the opengl name, or 0 if empty*/
+	unsigned int name() const {
+		return manager != nullptr ? manager->name(handle) : 0;
+	}
+
+	GpuHandle<TYPE> get() const {
+		return handle;
+	}
+
+	/* releases the object (deleted a few frames later by the manager). Empty wrappers never touch the manager*/
+	void reset() {
+		if (manager != nullptr && !handle.isNull()) {
+			manager->release(handle);
+		}
+	}
+
+private:
+	GpuResourceManager* manager;
+	GpuHandle<TYPE> handle;
+};
+
+typedef GpuResource<GPU_BUFFER> OwnedBuffer;
+typedef GpuResource<GPU_VERTEX_ARRAY> OwnedVertexArray;
+typedef GpuResource<GPU_TEXTURE> OwnedTexture;
+typedef GpuResource<GPU_PROGRAM> OwnedProgram;
+typedef GpuResource<GPU_FRAMEBUFFER> OwnedFramebuffer;
+typedef GpuResource<GPU_RENDERBUFFER> OwnedRenderbuffer;
+
+#endif
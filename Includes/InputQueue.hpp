@@ -0,0 +1,80 @@
+// InputQueue.hpp header for turning key events into a timestamped stream of player input
+// INPUTQUEUE_H
+#ifndef INPUTQUEUE_H
+#define INPUTQUEUE_H
+
+#include "../Includes/SpscQueue.hpp"
+#include "../Includes/PongSim.hpp"
+#include <GLFW/glfw3.h>
+
+
+/*
+	One change in what the player wants their bar to do
+	direction is absolute (1 is up, -1 is down and 0 is no movement) rather than a key press, so a dropped event is
+	corrected by the next one instead of leaving the bar stuck
+*/
+struct InputEvent {
+	// steady clock time the key changed, in nanoseconds (see InputQueue::now)
+	long long time;
+	int direction;
+};
+
+
+/*
+	Class which records the player's key presses as they happen (from the glfw key callback) instead of polling once per frame
+	The render thread pushes events and the simulation thread pops them, so presses between frames are never lost
+	and the simulation knows when inside its tick each one happened
+*/
+class InputQueue {
+public:
+	// events waiting for the simulation, more than a few seconds of mashing before it gets dropped
+	static const unsigned int CAPACITY = 256;
+
+	InputQueue();
+
+	/* high resolution timestamp in nanoseconds, on the same clock the simulation thread ticks with*/
+	static long long now();
+
+	/*
+		updates the arrow key state from a glfw key event and queues the new direction if it changed (producer thread only)
+		up wins if both arrows are held, same as polling the keys did
+	*/
+	void keyEvent(int key, int action);
+
+	/* queues a direction change at the given time (producer thread only). Returns false if the queue was full*/
+	bool push(int direction, long long time);
+
+	/* the oldest event without removing it (consumer thread only)*/
+	bool peek(InputEvent& event) const;
+
+	/* removes the oldest event (consumer thread only)*/
+	bool pop(InputEvent& event);
+
+	/*
+		takes the events that happened before tickEnd off the queue and lays them out over a tick of timeDelta seconds
+		spanning tickStart to tickEnd (consumer thread only). Events from before tickStart take effect at the start of the tick
+	*/
+	TickInput collectTick(long long tickStart, long long tickEnd, float timeDelta);
+
+	/* how many events could not be queued because the consumer fell behind*/
+	unsigned int dropped() const;
+
+private:
+	SpscQueue<InputEvent, CAPACITY> events;
+
+	// producer side key state and the last direction we queued
+	bool upHeld, downHeld;
+	int direction;
+	unsigned int droppedEvents;
+
+	// consumer side direction at the end of the last collected tick
+	int tickDirection;
+};
+
+/*
+	glfw key callback that feeds the InputQueue set as the window's user pointer
+	install it before ImGui's glfw backend so ImGui chains it rather than replacing it
+*/
+void input_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+#endif
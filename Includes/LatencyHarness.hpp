@@ -0,0 +1,133 @@
+// LatencyHarness.hpp header for measuring how long a key press takes to show up on screen
+// LATENCYHARNESS_H
+#ifndef LATENCYHARNESS_H
+#define LATENCYHARNESS_H
+
+#include "../Includes/Pong.hpp"
+#include "../Includes/GpuResources.hpp"
+#include "../Includes/InputQueue.hpp"
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+	One combination of the settings that affect input latency
+	swapInterval is passed to glfwSwapInterval (0 is no vsync)
+	frameQueue is how many frames the cpu may get ahead of the gpu before it waits (0 leaves it to the driver)
+	tickRate is the simulation thread's tick rate, or 0 to step the simulation on the render thread once per frame
+*/
+struct LatencyConfig {
+	int swapInterval;
+	int frameQueue;
+	int tickRate;
+};
+
+/*
+	One measured key press, all times in milliseconds after the press was injected
+	gpuMs is when the gpu finished the first frame showing the paddle move, swapMs is when the swap of that frame returned
+	Neither includes the display's own scanout and response time, that needs a photodiode
+*/
+struct LatencySample {
+	LatencyConfig config;
+	float gpuMs;
+	float swapMs;
+	// frames rendered between the press and the frame that showed it
+	int frames;
+};
+
+
+/*
+	Class which measures input to photon latency through the real input, simulation and rendering path
+	An injector thread pushes synthetic key presses into an InputQueue at random points in the frame, exactly like
+	the glfw key callback does. Every frame is rendered offscreen, blitted to the window and swapped as usual, and
+	one marker pixel just past the edge of the player's bar is read back asynchronously along with a gpu timestamp.
+	The first frame where that pixel turns the color of the bar is the frame the press reached
+*/
+class LatencyHarness {
+public:
+	/* pong is used to draw the frames, its objects and the harness's own come from resources*/
+	LatencyHarness(GLFWwindow* window, GpuResourceManager* resources, PongState* pong);
+
+	/* stops the injector thread*/
+	~LatencyHarness();
+
+	/*
+		measures trials key presses under one configuration and appends them to samples
+		Presses that never showed up within TIMEOUT_NS have no sample, they are counted in missed instead
+		Returns false if the window was closed or opengl could not set up the offscreen target
+	*/
+	bool measure(const LatencyConfig& config, int trials, std::vector<LatencySample>& samples, int* missed);
+
+private:
+	// frames whose readback can be in flight at once
+	static const int READBACK_RING = 8;
+
+	// frames after a release before the bar is taken to be at rest again
+	static const int SETTLE_FRAMES = 6;
+
+	// a press that has not shown up after this long is counted as missed
+	static const long long TIMEOUT_NS = 1000000000LL;
+
+	// what the render thread wants the injector to do next
+	enum InjectorCommand { IDLE, PRESS, RELEASE, QUIT };
+
+	struct Readback {
+		OwnedBuffer pbo;
+		unsigned int query;
+		// fence limiting how far the cpu gets ahead, signalled when the frame is done on the gpu
+		GLsync fence;
+		unsigned long long frame;
+		long long swapTime;
+		bool pending;
+	};
+
+	GLFWwindow* window;
+	GpuResourceManager* resources;
+	PongState* pong;
+
+	InputQueue input;
+
+	OwnedFramebuffer fbo;
+	OwnedRenderbuffer colorBuffer;
+	int width, height;
+
+	Readback readbacks[READBACK_RING];
+
+	// gpu timestamps plus this offset are on the InputQueue clock
+	long long gpuToCpu;
+
+	std::thread injector;
+	std::atomic<int> command;
+	std::atomic<int> pressDirection;
+	// time the injector pushed the press, 0 until it has
+	std::atomic<long long> pressTime;
+
+	/* body of the injector thread: waits a random part of a frame, then pushes the requested press or release*/
+	void runInjector();
+
+	/* creates the offscreen target and readback buffers at the window's framebuffer size*/
+	bool setup();
+
+	/* frees the offscreen target and readback buffers*/
+	void teardown();
+
+	/* reads the gpu clock and the cpu clock back to back to line them up*/
+	void calibrate();
+
+	/* waits for the frame that is frameQueue frames older than this one, so the cpu stays at most that far ahead*/
+	void limitQueue(unsigned long long frame, int frameQueue);
+
+	/* returns true with the marker pixel's color if the readback in slot has arrived, without waiting for it*/
+	bool collect(Readback& slot, bool* markerLit, long long* gpuTime);
+};
+
+/*
+	Runs the latency harness over every combination of swap interval (0, 1), frame queue (1, 2, 3, driver) and
+	simulation (render thread, 60, 120 and 240 hz thread), printing a summary per configuration and writing every
+	sample to csvPath. Needs a visible window with a current opengl context. Returns 0 on success
+*/
+int runLatencySweep(GLFWwindow* window, GpuResourceManager* resources, int trials, const char* csvPath);
+
+#endif
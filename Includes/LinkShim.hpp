@@ -0,0 +1,102 @@
+// LinkShim.hpp header for simulating a bad network between the game and its udp socket
+// LINKSHIM_H
+#ifndef LINKSHIM_H
+#define LINKSHIM_H
+
+#include "../Includes/PongSim.hpp"
+#include "../Includes/UdpSocket.hpp"
+#include <vector>
+
+
+// how the jitter is spread around the delay
+enum DelayShape {
+	// anywhere within jitterMs either way
+	DELAY_UNIFORM = 0,
+	// normal, jitterMs is the standard deviation
+	DELAY_NORMAL = 1,
+	// never early, and now and then very late: a pareto tail whose mean is jitterMs
+	DELAY_PARETO = 2
+};
+
+
+/*
+	Network conditions to put on top of the real link, so a match on loopback can behave like one over the internet
+	Every packet we send is held back by delayMs plus jitter shaped by delayShape, and lost with probability lossPercent
+	Losses come in runs averaging lossBurst packets (1 or less is independent loss). reorderPercent of the packets are
+	held back long enough for the next few to overtake them, duplicatePercent are sent twice (each copy with its own
+	delay). bandwidthKbps caps the link: packets queue behind each other, and are dropped once the queue is full
+	seed picks the random run, the same seed gives every packet the same fate
+	Zero for any of them turns it off, so { delay, jitter, loss } still describes a plain link
+*/
+struct LinkConditions {
+	int delayMs;
+	int jitterMs;
+	float lossPercent;
+	int delayShape;
+	float lossBurst;
+	float reorderPercent;
+	float duplicatePercent;
+	int bandwidthKbps;
+	unsigned int seed;
+};
+
+
+/*
+	What the shim did to the packets it was given
+*/
+struct LinkCounters {
+	unsigned int sent, lost, queueDrops, duplicated, reordered;
+};
+
+
+/*
+	Class which holds outgoing packets back according to a LinkConditions before really sending them
+	Every packet draws the same number of random values whatever happens to it, so packet n of a run gets the same
+	fate for the same seed even if the packets before it were timed differently. Only the bandwidth queue depends on
+	the times passed in, and those are the caller's: driven by a simulated clock the shim is fully repeatable
+*/
+class LinkShim {
+public:
+	// the most a capped link queues before it drops, in milliseconds of sending
+	static const int QUEUE_LIMIT_MS = 250;
+
+	// a reordered packet is held back this much longer, enough for the next packet or two to overtake it
+	static const int REORDER_MIN_MS = 10;
+	static const int REORDER_MAX_MS = 50;
+
+	LinkShim();
+
+	/* new conditions, seed makes every drop and delay repeatable*/
+	void configure(const LinkConditions& conditions, unsigned int seed);
+
+	/* queues a packet (or drops it), it goes out on a later flush once its delay has passed. now is on the InputQueue clock*/
+	void send(UdpSocket& socket, const NetAddress& to, const unsigned char* data, int length, long long now);
+
+	/* sends every queued packet whose delay has passed*/
+	void flush(UdpSocket& socket, long long now);
+
+	const LinkCounters& counters() const;
+
+private:
+	struct Delayed {
+		long long release;
+		NetAddress to;
+		int length;
+		unsigned char data[UdpSocket::MAX_PACKET];
+	};
+
+	LinkConditions conditions;
+	SimRandom random;
+	// whether the loss model is in its losing state, and when a capped link is free to send again
+	bool bursting;
+	long long linkFree;
+	std::vector<Delayed> queue;
+	LinkCounters stats;
+
+	/* delayMs plus jitter for one copy of a packet, in milliseconds, from two uniform draws*/
+	float delayMs(float a, float b) const;
+
+	void hold(const NetAddress& to, const unsigned char* data, int length, long long release);
+};
+
+#endif
@@ -0,0 +1,43 @@
+// MappedFile.hpp header for reading a whole file through a read only memory mapping
+// MAPPEDFILE_H
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+
+
+/*
+	Class which maps a file into memory read only
+	The operating system pages the file in as it is touched, so opening a long file costs the same as a short one and
+	jumping into the middle of it reads only the pages around that spot
+*/
+class MappedFile {
+public:
+	MappedFile();
+
+	/* unmaps the file if it is still open*/
+	~MappedFile();
+
+	/* maps the whole file, returns false if it is missing or could not be mapped*/
+	bool open(const char* path);
+
+	void close();
+
+	/* the file's bytes, valid until close (null for an empty file)*/
+	const unsigned char* data() const;
+
+	size_t size() const;
+
+private:
+	const unsigned char* bytes;
+	size_t length;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+};
+
+#endif
@@ -0,0 +1,93 @@
+// MatchServer.hpp header for the authoritative server running many headless matches
+// MATCHSERVER_H
+#ifndef MATCHSERVER_H
+#define MATCHSERVER_H
+
+#include <vector>
+
+
+/*
+	Totals over every shard, read while the server is running
+*/
+struct ServerStats {
+	int matches;
+	int players;
+	unsigned long long packetsIn, packetsOut;
+	// udp payload bytes sent
+	unsigned long long bytesOut;
+	// match ticks, every match counts
+	unsigned long long ticks;
+	// slowest pass over a shard's due timers (stepping the matches due that millisecond and sending their states) since the last call
+	float worstTickMs;
+	unsigned long long matchesFinished;
+	// spectators watching, broadcast states serialized, copies of them sent and copies held back from lagging spectators
+	int spectators;
+	unsigned long long broadcastFrames, broadcastPackets, broadcastSkipped;
+};
+
+
+/*
+	Class which runs pong matches for remote players, with the server deciding everything
+	Players send JOIN and are paired up two at a time, after that they only send their paddle direction and the server
+	steps the match at a fixed tick and sends every player the new state
+	Every match ticks on its own schedule, at the phase it started with, so a shard's work is spread over the whole tick
+	instead of arriving all at once. Ticks, the pause after a goal and idle timeouts are all timers in one hierarchical
+	timer wheel per shard, which schedules and cancels in constant time however many matches there are
+
+	The work is split into shards, one thread per core, each with its own socket bound to the same port (SO_REUSEPORT)
+	so the kernel spreads players across shards by address. A shard only pairs the players that reach it, so it owns
+	its matches outright and shards never share anything but their stat counters
+	Each shard waits on epoll for its socket and a millisecond timer and moves datagrams in batches (recvmmsg, sendmmsg)
+	Systems without epoll run one shard that polls instead
+
+	Spectators get every tick of a match in a broadcast: the shard serializes the state once per tick into a
+	SharedPacket and queues that same packet for every spectator, so a match with a thousand spectators costs one
+	encode and a thousand message headers. A broadcast is a delta against the newest keyframe (a full state every
+	KEYFRAME_TICKS) rather than against what each spectator acknowledged, which is what lets everyone share it
+	A spectator that has not acknowledged anything for SPECTATOR_LAG_TICKS only gets keyframes until it catches up,
+	so a slow link is not flooded with deltas it would drop anyway and skips straight to the latest keyframe
+*/
+class MatchServer {
+public:
+	// ticks per second of every match
+	static const int TICK_RATE = 60;
+
+	// a player we have not heard from in this long forfeits
+	static const int TIMEOUT_MS = 5000;
+
+	// pause after a goal before the ball is served again
+	static const int SERVE_DELAY_MS = 1000;
+
+	// ticks between the full states broadcast to spectators (deltas can reach back at most REPLICATION_WINDOW)
+	static const int KEYFRAME_TICKS = 30;
+
+	// a spectator whose newest acknowledgement is this many ticks old only gets keyframes
+	static const int SPECTATOR_LAG_TICKS = 60;
+
+	MatchServer();
+
+	/* stops the shards if they are still running*/
+	~MatchServer();
+
+	/* binds port and starts shardCount shards (0 is one per core). Returns false if a socket could not be opened*/
+	bool start(unsigned short port, int shardCount, float ballSpeed, float barSpeed, int maxScore);
+
+	/* stops every shard and closes the sockets*/
+	void stop();
+
+	/* adds up the shards' counters, and resets the worst tick time*/
+	ServerStats stats();
+
+	int shardCount() const;
+
+	// one core's matches, socket and thread (only defined inside MatchServer.cpp)
+	struct Shard;
+
+private:
+	std::vector<Shard*> shards;
+
+	/* body of a shard's thread*/
+	static void runShard(Shard* shard);
+};
+
+#endif
@@ -0,0 +1,150 @@
+// Matchmaker.hpp header for pairing players who want a match by skill and latency
+// MATCHMAKER_H
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include "../Includes/MpscQueue.hpp"
+#include "../Includes/SpscQueue.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+	A player asking for a match. skill is a rating (1500 is average), latencyMs the player's ping to the server region
+	submitted is when the request was made, from Matchmaker::now()
+*/
+struct JoinRequest {
+	unsigned long long player;
+	int skill;
+	int latencyMs;
+	long long submitted;
+};
+
+
+/*
+	Two players the matchmaker put together, and when it did
+*/
+struct Pairing {
+	JoinRequest players[2];
+	long long paired;
+};
+
+
+/*
+	Counters read while the matchmaker is running
+	The latency percentiles are over the requests seen since the last call, rounded up to a power of two microseconds
+*/
+struct MatchmakerStats {
+	// requests the pairing thread has taken, requests dropped because its queue was full, and pairings made
+	unsigned long long submitted, rejected, paired;
+	// players waiting in a bucket for someone to play
+	int waiting;
+	// from submit() until the pairing thread took the request off the queue
+	float queueP50Us, queueP99Us, queueMaxUs;
+	// from submit() until the player was paired
+	float waitP50Ms, waitP99Ms;
+};
+
+
+/*
+	Class which pairs players on a thread of its own
+	Any number of threads (the network threads receiving join requests) call submit(), which is a lock-free push onto a
+	bounded multi-producer queue, so a network thread never waits on the matchmaker or on each other beyond one
+	compare and swap. The pairing thread drains the queue in batches and files every request in a bucket by skill
+	(SKILL_STEP rating points wide) and latency band. Someone already waiting in the same bucket is paired at once
+	A player nobody fits is offered the neighbouring buckets as they wait longer: one more skill bucket either side
+	every WIDEN_MS, and one more latency band every second time, so nobody waits forever in a quiet bucket
+	Pairings go out on a single consumer queue, read with nextPairing() by whoever starts the matches
+	The queues are several megabytes, so allocate a Matchmaker with new rather than on the stack
+*/
+class Matchmaker {
+public:
+	// rating points per skill bucket, and the buckets (ratings outside are put in the first or last)
+	static const int SKILL_STEP = 100;
+	static const int SKILL_BUCKETS = 32;
+
+	// latency bands, split at 30, 60, 100 and 160 ms
+	static const int LATENCY_BANDS = 5;
+
+	// waiting this long widens a player's search by one more bucket
+	static const int WIDEN_MS = 2000;
+
+	// join requests waiting to be filed, and pairings waiting to be read
+	static const unsigned int QUEUE_SIZE = 1 << 16;
+	static const unsigned int PAIRING_QUEUE_SIZE = 1 << 16;
+
+	Matchmaker();
+
+	/* stops the pairing thread if it is still running*/
+	~Matchmaker();
+
+	/* starts the pairing thread*/
+	void start();
+
+	/* stops the pairing thread, players still waiting are dropped*/
+	void stop();
+
+	/* asks for a match (any thread). Returns false if the queue is full and the request was dropped*/
+	bool submit(const JoinRequest& request);
+
+	/* takes the next pairing, returns false if there is none (one consumer thread only)*/
+	bool nextPairing(Pairing* pairing);
+
+	/* reads the counters and resets the latency percentiles*/
+	MatchmakerStats stats();
+
+	/* steady clock in nanoseconds, for JoinRequest::submitted*/
+	static long long now();
+
+private:
+	// latency histograms, bucket i counts values below 2^i microseconds
+	static const int HISTOGRAM_SIZE = 40;
+
+	MpscQueue<JoinRequest, QUEUE_SIZE> requests;
+	SpscQueue<Pairing, PAIRING_QUEUE_SIZE> pairings;
+
+	std::thread thread;
+	std::atomic<bool> alive;
+
+	std::atomic<unsigned long long> submitted, rejected, paired;
+	std::atomic<int> waitingCount;
+	std::atomic<unsigned int> queueHistogram[HISTOGRAM_SIZE];
+	std::atomic<unsigned int> waitHistogram[HISTOGRAM_SIZE];
+	std::atomic<long long> queueMaxNs;
+
+	// everything below belongs to the pairing thread
+
+	// a waiting player, and the bucket lists are indices into this pool
+	struct Waiting {
+		JoinRequest request;
+		int next, prev;
+		int bucket;
+	};
+	std::vector<Waiting> pool;
+	int freeList;
+	int waitingPlayers;
+	unsigned long long pairedCount;
+	// oldest and newest waiting player in each bucket
+	std::vector<int> first, last;
+	// pairings the output queue had no room for yet
+	std::vector<Pairing> overflow;
+
+	/* body of the pairing thread*/
+	void run();
+
+	/* files one request, pairing it straight away if its bucket has someone waiting*/
+	void place(const JoinRequest& request, long long now);
+
+	/* pairs players who have waited long enough with someone from a neighbouring bucket*/
+	void widen(long long now);
+
+	/* hands a pairing to the output queue and counts it*/
+	void emit(const JoinRequest& a, const JoinRequest& b, long long now);
+
+	int bucketOf(const JoinRequest& request) const;
+	int addWaiting(const JoinRequest& request, int bucket);
+	void removeWaiting(int index);
+};
+
+#endif
@@ -0,0 +1,103 @@
+// Meshes.hpp header for the constant geometry of pong and the bitmap font lookup table, all generated at compile time
+// MESHES_H
+#ifndef MESHES_H
+#define MESHES_H
+
+#include <cstddef>
+#include <utility>
+
+
+// sizes of the objects in normalized coordinates (the simulation uses the same bar and ball sizes)
+constexpr float BAR_WIDTH = 0.04f;
+constexpr float BAR_HEIGHT = 0.4f;
+constexpr float BALL_SIZE = 0.04f;
+constexpr float DIGIT_SIZE = 0.1f;
+
+// size of one glyph in the bitmap font (Textures/characters.bmp) and the row the digits 0 to 9 sit on
+constexpr float GLYPH_SIZE = 0.0627f;
+constexpr float DIGIT_ROW = 0.75f;
+
+
+/*
+	A rectangle as 4 vertices of STRIDE floats each: bottom left, bottom right, top left, top right
+	Every vertex starts with its position (x, y, z) followed by its color (r, g, b), textured quads add (u, v)
+	The top left corner is at the origin, so a translation moves the quad by its top left corner
+*/
+template <int STRIDE>
+struct QuadMesh {
+	float vertices[4 * STRIDE];
+};
+
+typedef QuadMesh<6> ColorQuad;
+typedef QuadMesh<8> TexturedQuad;
+
+// number of floats in a quad mesh
+template <int STRIDE>
+constexpr int quadLength(const QuadMesh<STRIDE>&) {
+	return 4 * STRIDE;
+}
+
+/*
+	component c of vertex v of a width by height quad with a flat color, texture coordinates cover (u, v, u + size, v + size)
+	bit 0 of the vertex picks the right edge and bit 1 picks the top edge
+*/
+constexpr float quadComponent(int vertex, int c, float width, float height, float r, float g, float b, float u, float v, float size) {
+	return c == 0 ? ((vertex & 1) ? width : 0.0f)
+		: c == 1 ? ((vertex & 2) ? 0.0f : -height)
+		: c == 2 ? 0.0f
+		: c == 3 ? r
+		: c == 4 ? g
+		: c == 5 ? b
+		: c == 6 ? ((vertex & 1) ? u + size : u)
+		: ((vertex & 2) ? v + size : v);
+}
+
+/* expands every float of the quad from its index, so the whole table is a constant expression*/
+template <int STRIDE, std::size_t... I>
+constexpr QuadMesh<STRIDE> makeQuad(float width, float height, float r, float g, float b, float u, float v, float size, std::index_sequence<I...>) {
+	return QuadMesh<STRIDE>{ { quadComponent((int)(I / STRIDE), (int)(I % STRIDE), width, height, r, g, b, u, v, size)... } };
+}
+
+/* a width by height quad in one color*/
+constexpr ColorQuad makeColorQuad(float width, float height, float r, float g, float b) {
+	return makeQuad<6>(width, height, r, g, b, 0.0f, 0.0f, 0.0f, std::make_index_sequence<4 * 6>());
+}
+
+/* a width by height quad mapped onto one square glyph of the bitmap font*/
+constexpr TexturedQuad makeGlyphQuad(float width, float height, float u, float v) {
+	return makeQuad<8>(width, height, 1.0f, 1.0f, 1.0f, u, v, GLYPH_SIZE, std::make_index_sequence<4 * 8>());
+}
+
+// red bar, red ball and a white digit quad showing the glyph for 0 (other digits shift the texture coordinates over)
+constexpr ColorQuad BAR_MESH = makeColorQuad(BAR_WIDTH, BAR_HEIGHT, 1.0f, 0.0f, 0.0f);
+constexpr ColorQuad BALL_MESH = makeColorQuad(BALL_SIZE, BALL_SIZE, 1.0f, 0.0f, 0.0f);
+constexpr TexturedQuad DIGIT_MESH = makeGlyphQuad(DIGIT_SIZE, DIGIT_SIZE, 0.0f, DIGIT_ROW);
+
+// indices of the two triangles that make up every quad
+constexpr unsigned int QUAD_INDICES[6] = {
+	0,1,2, // first triangle
+	2,3,1  // second triangle
+};
+
+static_assert(BAR_MESH.vertices[6] == BAR_WIDTH && BAR_MESH.vertices[1] == -BAR_HEIGHT, "bar mesh corners are out of order");
+static_assert(DIGIT_MESH.vertices[3 * 8 + 7] == DIGIT_ROW + GLYPH_SIZE, "digit mesh texture coordinates are out of order");
+
+
+/*
+	Where each digit's glyph starts in the bitmap font, relative to the glyph for 0
+	Looked up per digit when drawing the score instead of computing it every frame
+*/
+struct GlyphTable {
+	float u[10];
+};
+
+template <std::size_t... DIGITS>
+constexpr GlyphTable makeGlyphTable(std::index_sequence<DIGITS...>) {
+	return GlyphTable{ { (DIGITS * GLYPH_SIZE)... } };
+}
+
+constexpr GlyphTable DIGIT_GLYPHS = makeGlyphTable(std::make_index_sequence<10>());
+
+static_assert(DIGIT_GLYPHS.u[0] == 0.0f && DIGIT_GLYPHS.u[9] == 9 * GLYPH_SIZE, "glyph table is out of order");
+
+#endif
@@ -0,0 +1,79 @@
+// MpscQueue.hpp header for passing values from many threads to one without locks
+// MPSCQUEUE_H
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+
+
+/*
+	Multiple producer, single consumer ring buffer holding up to CAPACITY values (CAPACITY must be a power of two)
+	Every cell carries a sequence number saying whose turn it is: a producer claims the cell at tail with one
+	compare and swap, fills it and hands it over by bumping the sequence. The consumer waits for that bump before
+	reading, so a producer that claimed a cell but has not filled it yet only holds up the values behind it
+	When the ring is full push() fails instead of waiting, so the caller decides what backpressure means
+*/
+template <typename T, unsigned int CAPACITY>
+class MpscQueue {
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+	MpscQueue() : head(0), tail(0) {
+		for (unsigned int i = 0; i < CAPACITY; i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/* adds a value to the back of the queue, returns false if the queue is full (any thread)*/
+	bool push(const T& value) {
+		unsigned int back = tail.load(std::memory_order_relaxed);
+		while (true) {
+			Cell& cell = cells[back & (CAPACITY - 1)];
+			unsigned int sequence = cell.sequence.load(std::memory_order_acquire);
+			int difference = (int)(sequence - back);
+			if (difference == 0) {
+				// the cell is free for this lap, claim it (a failed exchange reloads back and we try the new tail)
+				if (tail.compare_exchange_weak(back, back + 1, std::memory_order_relaxed)) {
+					cell.value = value;
+					cell.sequence.store(back + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0) {
+				// the consumer has not emptied this cell since the last lap
+				return false;
+			}
+			else {
+				// another producer took it first
+				back = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/* removes the front value, returns false if the queue is empty or its front value is still being written (consumer thread only)*/
+	bool pop(T& value) {
+		Cell& cell = cells[head & (CAPACITY - 1)];
+		if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+			return false;
+		}
+		value = cell.value;
+		// free for the producers' next lap
+		cell.sequence.store(head + CAPACITY, std::memory_order_release);
+		head++;
+		return true;
+	}
+
+private:
+	struct Cell {
+		std::atomic<unsigned int> sequence;
+		T value;
+	};
+
+	Cell cells[CAPACITY];
+
+	// the consumer owns head, the producers share tail, each on its own cache line
+	alignas(64) unsigned int head;
+	alignas(64) std::atomic<unsigned int> tail;
+};
+
+#endif
@@ -0,0 +1,57 @@
+// MultiMatchRenderer.hpp header for drawing a grid of many matches at once (spectator / ops dashboard view)
+// MULTIMATCHRENDERER_H
+#ifndef MULTIMATCHRENDERER_H
+#define MULTIMATCHRENDERER_H
+
+#include "../Includes/PongSim.hpp"
+#include "../Includes/GpuResources.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+
+
+/*
+	Class which draws many matches side by side in a grid
+	Every quad of every match (backdrop, bars, ball, score digits) is one instance of a single unit quad,
+	with its cell transform already applied, so the whole grid is one instanced draw call no matter how many matches there are
+*/
+class MultiMatchRenderer {
+public:
+	// quads drawn per match: backdrop, two bars, ball and four score digits
+	static const int QUADS_PER_MATCH = 8;
+
+	// floats per instance: rect (x, y, width, height), texture rect (u, v, width, height), color (r, g, b)
+	static const int INSTANCE_FLOATS = 11;
+
+	// most matches we can draw in one call to draw()
+	int maxMatches;
+
+	// draw calls issued by the last call to draw()
+	unsigned int drawCalls;
+
+	/* constructor that sets up the shared quad, the instance buffer and the font texture (owned through resources)*/
+	MultiMatchRenderer(GpuResourceManager* resources, int maxMatches);
+
+	/*
+		draws count snapshots into a grid with the given number of columns, filling the current viewport
+		matches past maxMatches are not drawn
+	*/
+	void draw(const PongSnapshot* snapshots, int count, int columns);
+
+	/* releases the opengl objects back to the resource manager*/
+	void destroy();
+
+private:
+	OwnedProgram program;
+	OwnedVertexArray quadVAO;
+	OwnedBuffer quadVBO, quadEBO, instanceVBO;
+	OwnedTexture scoreTexture;
+
+	// instance data rebuilt every frame (allocated once for maxMatches)
+	std::vector<float> instances;
+	int instanceCount;
+
+	/* adds one quad in match coordinates, moved and scaled into the cell whose top left corner is cellPos*/
+	void pushQuad(glm::vec2 cellPos, glm::vec2 cellScale, glm::vec2 topLeft, glm::vec2 size, glm::vec4 texRect, glm::vec3 color);
+};
+
+#endif
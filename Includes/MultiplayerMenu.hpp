@@ -0,0 +1,36 @@
+// functions for our multiplayer menu view
+// multiplayerMenu.hpp
+#ifndef MULTIPLAYERMENU_H
+#define MULTIPLAYERMENU_H
+
+#include "../Includes/NetSession.hpp"
+
+/*
+	Settings picked in the multiplayer menu
+	role is 0 to host a match and 1 to join one, host and remotePort are only used when joining
+	link makes our outgoing packets behave like a worse network (handy for testing on one machine)
+	lockstep and inputDelay (ticks) pick lockstep instead of rollback, only the host's choice counts
+*/
+struct MultiplayerSettings {
+	int role;
+	char host[64];
+	int localPort;
+	int remotePort;
+	LinkConditions link;
+	bool lockstep;
+	int inputDelay;
+};
+
+/*
+	Function that builds the multiplayer connection window
+	Returns 1 when the player asks to host or join with the current settings, -1 when they go back to the menu and 0 otherwise
+*/
+int buildMultiplayerMenu(MultiplayerSettings* settings);
+
+/*
+	Function that builds the window shown during a network match: connection state, round trip time and rollback counters
+	Returns true when the player asks to leave the match
+*/
+bool buildNetStatus(const NetStats& stats);
+
+#endif
@@ -0,0 +1,245 @@
+// NetSession.hpp header for two player matches over udp with prediction and rollback
+// NETSESSION_H
+#ifndef NETSESSION_H
+#define NETSESSION_H
+
+#include "../Includes/PongSim.hpp"
+#include "../Includes/UdpSocket.hpp"
+#include "../Includes/InputQueue.hpp"
+#include "../Includes/TripleBuffer.hpp"
+#include "../Includes/StateRing.hpp"
+#include "../Includes/ClockSync.hpp"
+#include "../Includes/LinkShim.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+	Counters the render thread shows while a network match is running
+*/
+struct NetStats {
+	int state;
+	// last round trip time measured from the input packets
+	float rttMs;
+	// next tick we will simulate, and how many ticks of remote input we have without gaps
+	unsigned int tick, confirmedTick;
+	// how often we had to roll back and resimulate, and the longest resimulation so far
+	unsigned int rollbacks;
+	unsigned int lastResimTicks, maxResimTicks;
+	float lastResimMs, maxResimMs;
+	// ticks we skipped because we were too far ahead of the remote player
+	unsigned int stalls;
+	unsigned int packetsSent, packetsReceived;
+	// lockstep instead of rollback, the input delay in ticks we use now and the one the remote player asks for (lockstep only)
+	int lockstep, inputDelay, wantedDelay;
+	// remote clock minus ours and how fast it drifts, then the one way trip, jitter and loss of the remote player's packets
+	float clockOffsetMs, driftPpm;
+	float transitMs, jitterMs, lossPercent;
+	// how many ticks we are ahead of the remote player, we slow down while this is positive
+	float tickAdvantage;
+	// hash chains compared with the remote player's, and how many of them differed (tick of the first one)
+	unsigned int hashesChecked, desyncs, firstDesyncTick;
+	// newest tick our chains matched at, every tick up to it agreed. A desync happened after it, by firstDesyncTick
+	unsigned int agreedTick;
+	// our newest hash chain and the tick it runs up to the start of
+	unsigned int lastHashTick;
+	unsigned long long lastHash;
+	// what the simulated network did to our packets
+	LinkCounters link;
+};
+
+
+/*
+	Class which runs a networked two player match on its own thread
+	Both peers simulate the whole match: the host plays the left bar and the joining player the right bar
+	Every tick each peer sends its recent inputs (repeated until acknowledged, so a lost packet costs nothing) and
+	simulates ahead using a prediction of the remote input (whatever it did last). When the real input for an earlier
+	tick arrives and differs from the prediction, we restore the saved state of that tick and resimulate up to now
+	The match is deterministic given the seed and settings the host sends when the joining player connects
+
+	In lockstep mode nothing is predicted: local input is scheduled inputDelay ticks ahead and a tick is only simulated
+	once both inputs for it are in, so a one way trip shorter than the delay never shows and a longer one stalls the match
+	In both modes the peers hash the confirmed state of every tick into a chain (chainHash) and send the newest chain with
+	their acknowledgements. Chains that agree at a tick agree at every tick before it, so a desync is reported even
+	though only some of them cross the network, and narrowed down to the ticks between the last match and the first miss
+
+	Each peer estimates the other's clock (ClockSync) from the times in the input packets. With it a peer knows which tick
+	the other is on and slows its own ticks down while it is ahead, so both run the same tick at the same moment
+	In lockstep each peer also measures the transit and jitter of the other's packets (JitterBuffer) and tells it the
+	input delay that would cover them, the other side then grows or shrinks its delay to match
+*/
+class NetSession {
+public:
+	enum Role { HOST, JOIN };
+	enum State { CONNECTING, PLAYING, DISCONNECTED, FAILED };
+
+	// simulation ticks per second, the same on both peers
+	static const int TICK_RATE = 60;
+
+	// ticks of saved state and inputs we keep, must cover MAX_PREDICTION both behind and ahead of the current tick
+	static const int RING = 128;
+
+	// furthest we simulate past the last tick we have real remote input for, beyond this we wait for the remote player
+	static const int MAX_PREDICTION = 30;
+
+	// give up on the remote player after this long without a packet
+	static const int TIMEOUT_MS = 5000;
+
+	// longest lockstep input delay, far enough inside RING that scheduled inputs never overwrite unsent ones
+	static const int MAX_INPUT_DELAY = 15;
+
+	NetSession();
+
+	/* stops the thread if it is still running*/
+	~NetSession();
+
+	/* queue the local player's key events are read from (call before start)*/
+	void setInputQueue(InputQueue* input);
+
+	/*
+		lockstep instead of rollback, starting with inputDelay ticks of delay (call before start, the joining player takes the host's choice)
+		the delay adapts to the connection once enough packets have been measured
+	*/
+	void setLockstep(bool lockstep, int inputDelay);
+
+	/*
+		opens the socket on localPort and starts the network thread
+		the host waits for someone to connect (remoteHost is ignored), a joining player connects to remoteHost:remotePort
+		the host's settings are used for the match. Returns false if the socket could not be opened or the host not resolved
+	*/
+	bool start(Role role, unsigned short localPort, const char* remoteHost, unsigned short remotePort, const LinkConditions& conditions,
+		float ballSpeed, float barSpeed, int maxScore);
+
+	/* asks the network thread to finish, waits for it and closes the socket*/
+	void stop();
+
+	/* whether we play the left bar (the host does)*/
+	bool isLeftPlayer() const;
+
+	/* newest state of the match (render thread only). status stays 0 until the end of the match is confirmed by both inputs*/
+	const PongSnapshot& latestSnapshot();
+
+	/* newest counters (render thread only)*/
+	const NetStats& latestStats();
+
+private:
+	Role role;
+	UdpSocket socket;
+	LinkShim shim;
+	NetAddress remote;
+	InputQueue* input;
+
+	std::thread thread;
+	std::atomic<bool> alive;
+
+	TripleBuffer<PongSnapshot> snapshots;
+	TripleBuffer<NetStats> statsBuffer;
+	NetStats stats;
+
+	// match settings, chosen by the host
+	unsigned int seed;
+	float ballSpeed, barSpeed;
+	int maxScore;
+	bool lockstep;
+	int inputDelay;
+
+	// everything below belongs to the network thread
+
+	// the match at the start of tick, when tick is due (InputQueue clock), and the match at the start of every recent tick
+	PongSim sim;
+	unsigned int tick;
+	long long nextTick;
+	StateRing<PongSim, RING> states;
+
+	// inputs per tick. remoteTicks[i] is one more than the tick whose input is in remoteInputs[i] (0 if none)
+	signed char localInputs[RING];
+	signed char remoteInputs[RING];
+	unsigned int remoteTicks[RING];
+	// remote input we actually simulated each tick with, to spot wrong predictions
+	signed char usedRemote[RING];
+
+	// we have every local input before this tick (tick itself, or inputDelay ahead of it in lockstep)
+	unsigned int localSent;
+	// we have every remote input before this tick
+	unsigned int remoteConfirmed;
+	// the remote player has every one of our inputs before this tick
+	unsigned int remoteAcked;
+	// earliest tick whose prediction turned out wrong (or no rollback pending when >= tick)
+	unsigned int rollbackTick;
+	// the tick after the one that ended the match (0 while it is still going)
+	unsigned int endTick;
+	// last remote input we know for sure, our prediction for every tick after it
+	signed char confirmedInput;
+
+	// round trip time bookkeeping, all on the InputQueue clock
+	long long lastReceived;
+	long long echoTime, echoReceived;
+
+	// the remote player's clock, their packets' timing, and the sequence number of our next input packet
+	ClockSync clock;
+	JitterBuffer jitter;
+	unsigned short sequence;
+	// smoothed estimate of how many ticks we are ahead of the remote player
+	float tickAdvantage;
+	// the input delay the remote player asks us for (-1 until it has measured enough), and the tick we last changed ours at
+	int remoteWantedDelay;
+	unsigned int lastAdapt;
+	// the tick we last counted a lockstep stall at, so waiting on one tick counts once
+	unsigned int stallTick;
+
+	// hash chains by tick, slot tick % HASH_RING, a couple of seconds of ticks so the remote chain for a tick still finds
+	// ours. A tick of 0 means empty, the chain starts at tick 1
+	static const int HASH_RING = 128;
+	struct TickHash {
+		unsigned int tick;
+		unsigned long long hash;
+	};
+	TickHash localHashes[HASH_RING];
+	TickHash remoteHashes[HASH_RING];
+	// next tick we hash the state at the start of, our chain up to it, and the newest remote chain we have seen
+	unsigned int nextHashTick;
+	unsigned long long localChain;
+	unsigned int remoteHashTick;
+
+	/* body of the network thread*/
+	void run();
+
+	/* reads every waiting packet*/
+	void receive(long long now);
+
+	/* handles one input packet from the remote player*/
+	void readInputs(const unsigned char* data, int length, long long now);
+
+	/* sends our unacknowledged inputs (and the acknowledgement of theirs)*/
+	void sendInputs(long long now);
+
+	/* sends a connection packet of the given type*/
+	void sendControl(int type, long long now);
+
+	/* the remote input to simulate tick t with: the real one if we have it, otherwise the last one we know*/
+	signed char remoteInputFor(unsigned int t) const;
+
+	/* simulates tick t from the current state, saving the state first*/
+	void simulate(unsigned int t);
+
+	/* restores the state at rollbackTick and simulates back up to the current tick*/
+	void rollback();
+
+	/* moves our lockstep input delay one step towards the one the remote player asks for*/
+	void adaptDelay();
+
+	/* extra wait before the next tick, to let the remote player catch up when we are ahead*/
+	long long syncDelay(long long period) const;
+
+	/* folds every tick whose state can no longer change into our chain*/
+	void updateHashes();
+
+	/* compares our chain at tick t with the remote player's, once we have both*/
+	void compareHash(unsigned int t);
+
+	/* starts the match from the agreed seed and settings*/
+	void beginMatch();
+};
+
+#endif
@@ -0,0 +1,274 @@
+// PongSim.hpp header for the pong simulation (positions, collisions, AI, scoring) without any opengl state
+// PONGSIM_H
+#ifndef PONGSIM_H
+#define PONGSIM_H
+
+#include <glm/glm.hpp>
+#include <type_traits>
+
+
+/*
+	Everything the renderer needs to draw one tick of a match
+	This is copied out of the simulation every tick, so it is kept small and trivially copyable
+*/
+struct PongSnapshot {
+	// top left positions of the bars and the ball
+	glm::vec2 leftBarPos, rightBarPos, ballPos;
+
+	int leftScore, rightScore;
+
+	// same values as PongSim::gameStatus()
+	int status;
+
+	// how many ticks the simulation has stepped since the last total reset
+	unsigned long long tick;
+};
+
+
+/*
+	The player's input over one tick, including exactly when inside the tick it changed
+	direction holds from the start of the tick, then changes[i] takes over changeOffsets[i] seconds into the tick
+	(offsets are in increasing order). Plain data, so it can be stored and sent as is
+*/
+struct TickInput {
+	// more changes than this in one tick are merged into the last one
+	static const int MAX_CHANGES = 8;
+
+	int direction;
+	int changeCount;
+	float changeOffsets[MAX_CHANGES];
+	int changes[MAX_CHANGES];
+
+	/* input that holds one direction for the whole tick*/
+	static TickInput constant(int direction) {
+		TickInput input;
+		input.direction = direction;
+		input.changeCount = 0;
+		return input;
+	}
+
+	/* the direction in effect at the end of the tick*/
+	int finalDirection() const {
+		return changeCount > 0 ? changes[changeCount - 1] : direction;
+	}
+};
+
+
+/*
+	Small random generator (splitmix64) whose whole state is one integer
+	The standard library engines and distributions are not guaranteed to be plain data, this is,
+	so a match including its random state can be saved and restored with a memcpy
+*/
+struct SimRandom {
+	unsigned long long state;
+
+	void seed(unsigned int value) {
+		state = value;
+	}
+
+	/* next number from 0 (inclusive) to 1 (exclusive)*/
+	float next() {
+		state += 0x9E3779B97F4A7C15ULL;
+		unsigned long long z = state;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+		// top 24 bits, exactly what a float can hold
+		return (float)(z >> 40) * (1.0f / 16777216.0f);
+	}
+};
+
+
+// values of PongSim::lastHit, a hit is on the side of the bar or its corner (the ones that return the ball)
+enum BarHit { BAR_HIT_NONE = 0, BAR_HIT_LEFT = 1, BAR_HIT_RIGHT = 2 };
+
+
+/*
+	Class which holds the simulation of a pong match
+	Nothing in here touches opengl or glfw, so a match can be stepped headlessly (exporting, servers, replays)
+	The renderer (PongState) only reads from this state
+	Every member is plain data with a fixed size (checked below), so saving and restoring a match for rollback or seeking
+	is a single memcpy of the object, see StateRing
+*/
+class PongSim {
+public:
+
+	// bar object has a specific height and width (x component is width, y component is height)
+	glm::vec2 barDims;
+
+	// ball object has a specific height and width
+	glm::vec2 ballDims;
+
+	// storing the positions of the top left coordinate of the bars and the ball (just x,y coordinates in normalized image coordinates)
+	// we need the last position of the ball to help with collision detection
+	glm::vec2 leftBarPos, rightBarPos, ballPos, ballLastPos;
+
+	// need to store the velocity vector of the ball (this should be a unit vector when not at rest)
+	glm::vec2 ballVelocity;
+
+	// float from 0 to 10 which represents a multiplier on the ball speed (10 is 10x faster than 1, 0 is no speed)
+	float ballSpeedMultiplier;
+
+	// float from 0 to 10 which represents a multiplier on the speed at which a player can move their bar (10 is 10x faster than 1, 0 is no movement)
+	float barSpeedMultiplier;
+
+	// left player's score
+	int leftScore;
+
+	// right player's score
+	int rightScore;
+
+	// maximum score: when a player hits this, they win
+	int maxScore;
+
+	// need to keep track of timedelta for non-framerate based movement
+	float timeDelta;
+
+	// number of steps since the last total reset
+	unsigned long long tick;
+
+	// which bar sent the ball back in the last step (BAR_HIT_NONE, BAR_HIT_LEFT or BAR_HIT_RIGHT), and the hitDist it was hit at
+	// only there for whoever watches the match (replay analytics), they are not part of the state, the hash or keyframes
+	int lastHit;
+	float lastHitDist;
+
+	/* constructor that places the bars and ball in their starting positions*/
+	PongSim();
+
+	/*
+		Advances the match by one timestep of timeDelta
+		leftDirection moves the player's bar: 1 is up, -1 is down and 0 is no movement
+		The right bar is moved by the AI
+		We return 1 if there was a goal (the ball and bars are already reset for the next point), 0 otherwise
+	*/
+	int step(int leftDirection);
+
+	/*
+		Same as step(leftDirection), but the right bar moves in rightDirection instead of where the AI wants
+		(callers driving the AI themselves pass aiDirection(false))
+	*/
+	int step(int leftDirection, int rightDirection);
+
+	/*
+		Same as step(leftDirection, rightDirection), but the player's bar follows input that may change partway through the tick
+		so a press between ticks moves the bar for exactly as long as the key was held
+	*/
+	int step(const TickInput& leftInput, int rightDirection);
+
+	/* copy out the parts of the state the renderer needs*/
+	PongSnapshot takeSnapshot();
+
+	/*
+		64 bit hash of everything that decides how the match plays out, random state included (see StateHash)
+		Two simulations with equal hashes are (barring a collision) the same bit for bit, so peers can compare them to spot a desync
+		It takes about 15 ns, a fraction of a tick, cheap enough to hash every tick
+	*/
+	unsigned long long stateHash() const;
+
+	// words stateHash() hashes: the dimensions, positions and velocity, multipliers, scores, timeDelta, tick and random state
+	static const int STATE_HASH_WORDS = 12;
+
+	// bytes writeState() takes
+	static const int STATE_BYTES = 54;
+
+	/*
+		Write the state that changes during a match to out (little endian, see ByteIO), so a replay can restart from it
+		The sizes of the bars and ball and timeDelta are left out, they never change within a match, and so are the
+		speed multipliers and maxScore, which come from setGameParameters (a replay carries them as settings).
+		Scores are written as u8 (max score never goes past 255) and tick as u32
+	*/
+	void writeState(unsigned char*& out) const;
+
+	/* read a state written by writeState back in, the rest stays as it is*/
+	void readState(const unsigned char*& in);
+
+	/*
+		writeState, STATE_BYTES of it, with every field xor'd against a prediction made from base, a state written
+		ticks earlier that the reader has too. Fields that held still since base come out as zeros, tick as the
+		difference from base's tick plus ticks, and ballPos is predicted from ballLastPos and one step of the
+		velocity, so only a bounce leaves anything there. What is left is the bars' heights, where the ball was and
+		how fast it goes, about 20 of the 54 bytes, and a compressor takes the zeros for little. Needs the timeDelta
+		and speed multipliers the state was stepped with, it reads back the same way only with them in place
+	*/
+	void writeKeyframe(unsigned char*& out, const unsigned char* base, unsigned int ticks) const;
+
+	/* read a state written by writeKeyframe against the same base back in*/
+	void readKeyframe(const unsigned char*& in, const unsigned char* base, unsigned int ticks);
+
+	/*Function which returns game status
+	  If 0, then the game is still in progress
+	  If 1, then the left player has won
+	  If 2, then the right player has won
+	*/
+	int gameStatus();
+
+	/*
+		Set some values which we need between games
+	*/
+	void setGameParameters(float ballSpeed, float barSpeed, int maxScore);
+
+	/* move the player's bar: 1 is up, -1 is down and 0 is no movement*/
+	void handleMovement(int direction);
+
+	/* move the player's bar through one tick of input, each direction for its share of the timestep*/
+	void handleMovement(const TickInput& input);
+
+	/* move a bar by one timestep in the given direction, keeping it on the screen*/
+	void moveBar(glm::vec2& barPos, int direction);
+
+	/* move a bar for the given number of seconds in the given direction, keeping it on the screen*/
+	void moveBar(glm::vec2& barPos, int direction, float seconds);
+
+	/* handle the movement update for the ball and any possible collisions
+	   We return 1 if there is any goal (to indicate that we need to reset or check for end of game status)
+	   We return 0 if there is no goal -> the game keeps going
+	*/
+	int handleBallMovement();
+
+	/* handle the movement of the AI to hit the ball*/
+	void handleAIMovement();
+
+	/*
+		The direction the AI wants to move a bar this timestep (1 is up, -1 is down and 0 is no movement)
+		leftBar picks which bar the AI is deciding for, so the same AI can play either side
+	*/
+	int aiDirection(bool leftBar);
+
+	/* Reset state of the game after a score
+	   If totalReset is true, then we restart the game from scratch (zero score on both sides)
+	*/
+	void resetGame(bool totalReset);
+
+	/*
+		Setting timedelta for this game object (I will call this in the GLFW render loop)
+	*/
+	void setTimeDelta(float newDelta);
+
+	/*
+		Helper function which sets the ball's initial velocity vector to a random direction
+	*/
+	void setBallInitialDirection();
+
+	/*
+		Reseed the random generator, so matches running side by side do not all play out the same way
+	*/
+	void seed(unsigned int value) {
+		random.seed(value);
+	}
+
+	/*
+		Sampling a random number between 0 and 1
+	*/
+	float sampleRandom() {
+		return random.next();
+	}
+
+private:
+	// random generator to use for random intialization of a ball direction
+	SimRandom random;
+
+};
+
+static_assert(std::is_trivially_copyable<PongSim>::value, "PongSim is saved and restored with memcpy, keep every member plain data");
+
+#endif
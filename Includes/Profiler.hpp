@@ -0,0 +1,136 @@
+// Profiler.hpp header for the in-game performance overlay (cpu phase timings, gpu timer queries, draw counts)
+// PROFILER_H
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "../Includes/GpuResources.hpp"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+
+/*
+	Class which measures where each frame goes and shows it in an ImGui overlay
+	CPU phases are timed with a steady clock, the gpu cost of a frame with GL_TIME_ELAPSED queries kept in a ring
+	so we only ever read results that are already available (we never stall waiting on the gpu)
+	While the overlay is hidden and nothing is being captured, every call returns straight away
+*/
+class Profiler {
+public:
+	// the parts of a frame we time separately
+	// SIM and AI happen on the simulation thread and are reported through addSimTime
+	enum Phase { EVENTS, SIM, AI, DRAW, IMGUI, SWAP, PHASE_COUNT };
+
+	// number of frames kept for the overlay graphs
+	static const int HISTORY = 240;
+
+	// number of timer queries in flight, results normally come back 2-3 frames late
+	static const int QUERY_RING = 4;
+
+	/* one captured frame, these are the rows of the csv dump*/
+	struct FrameRecord {
+		unsigned long long frame;
+		float phaseMs[PHASE_COUNT];
+		// negative until the gpu result arrives
+		float gpuMs;
+		unsigned int drawCalls;
+		unsigned int stateChanges;
+	};
+
+	// whether the overlay is shown (we only measure while it is shown or while capturing)
+	bool visible;
+
+	// whether finished frames are being appended to the capture for the csv dump
+	bool capturing;
+
+	/* constructor only sets up the cpu side, call initQueries() once there is an opengl context*/
+	Profiler();
+
+	/* creates the gpu timer queries*/
+	void initQueries();
+
+	/* frees the gpu timer queries*/
+	void destroyQueries();
+
+	/* start timing a new frame (also starts the gpu timer for it)*/
+	void beginFrame();
+
+	/* start and stop timing a phase of the current frame, a phase can be timed several times per frame and adds up*/
+	void beginPhase(Phase phase);
+	void endPhase(Phase phase);
+
+	/* whether addSimTime is currently recording, so other threads can skip reading the clock. Thread safe*/
+	bool measuringSim() const {
+		return simMeasuring.load(std::memory_order_relaxed);
+	}
+
+	/*
+		time spent in a phase on another thread in nanoseconds, thread safe. Added to whichever frame is current on the
+		render thread
+	*/
+	void addSimTime(Phase phase, unsigned long long ns);
+
+	/* how much rendering work the frame submitted*/
+	void setRenderCounts(unsigned int drawCalls, unsigned int stateChanges);
+
+	/* resource manager whose live object counts and memory the overlay shows (optional)*/
+	void setResources(const GpuResourceManager* resources);
+
+	/* stops the gpu timer for this frame, call right before swapping buffers*/
+	void endGpuWork();
+
+	/* finishes the frame, picking up any gpu results that have arrived*/
+	void endFrame();
+
+	/* builds the overlay window, should be called between ImGui::NewFrame and ImGui::Render*/
+	void drawOverlay();
+
+	/* writes every captured frame to a csv file and clears the capture. Returns false if the file could not be written*/
+	bool dumpCSV(const char* path);
+
+private:
+	typedef std::chrono::steady_clock clock;
+
+	// whether the frame in progress is being measured (decided in beginFrame so a frame is never half measured)
+	bool active;
+
+	unsigned long long frameCount;
+
+	clock::time_point phaseStart[PHASE_COUNT];
+
+	// the frame being measured and the last one finished (which is what the overlay shows)
+	FrameRecord current;
+	FrameRecord last;
+
+	// rolling history for the overlay graphs
+	float phaseHistory[PHASE_COUNT][HISTORY];
+	float gpuHistory[HISTORY];
+	int historyIndex;
+
+	// copy of active the simulation thread can read
+	std::atomic<bool> simMeasuring;
+
+	// results reported by the simulation thread, stored as nanoseconds so we can add them up atomically. A tick's AI
+	// decision takes well under a microsecond, so anything coarser would round it away
+	std::atomic<unsigned long long> simNanos[PHASE_COUNT];
+
+	// gpu timer queries and the frame each one measured
+	unsigned int queries[QUERY_RING];
+	unsigned long long queryFrame[QUERY_RING];
+	bool queryPending[QUERY_RING];
+	bool queryRunning;
+	bool queriesReady;
+
+	// latest gpu time we have a result for
+	float lastGpuMs;
+
+	const GpuResourceManager* resources;
+
+	// frames captured for the csv dump
+	std::vector<FrameRecord> capture;
+
+	/* read back every query whose result is available without blocking*/
+	void collectQueries();
+};
+
+#endif
@@ -0,0 +1,125 @@
+// RenderCommands.hpp header for recording draw commands separately from submitting them to opengl
+// RENDERCOMMANDS_H
+#ifndef RENDERCOMMANDS_H
+#define RENDERCOMMANDS_H
+
+#include <glm/glm.hpp>
+
+class GpuResourceManager;
+
+/*
+	One recorded draw: which program and vertex array to use, the per-instance data to upload, and how many indices to draw
+	The backend only switches program, vertex array or texture when they differ from the previous command
+*/
+struct RenderCommand {
+	// commands are executed in increasing key order, see RenderCommandList::sort
+	unsigned long long sortKey;
+
+	unsigned int program;
+	unsigned int vertexArray;
+
+	// texture bound to unit 0, or 0 for untextured draws
+	unsigned int texture;
+
+	// instance data: where to move the quad and how far to shift its texture coordinates
+	glm::vec2 translation;
+	glm::vec2 textureShift;
+
+	int indexCount;
+};
+
+
+/*
+	Fixed size list of commands filled in by the game every frame
+	There is no allocation after construction, so it can be filled on any thread and replayed as many times as we like
+*/
+class RenderCommandList {
+public:
+	// the pong scene needs 7 commands, this leaves plenty of room
+	static const int CAPACITY = 64;
+
+	RenderCommand commands[CAPACITY];
+	int count;
+
+	RenderCommandList();
+
+	/* empties the list for a new frame*/
+	void clear();
+
+	/*
+		records a draw of indexCount indices from vertexArray with program and texture, moved by translation
+		layer lets a caller force some draws after others regardless of state (lower layers are drawn first)
+		Returns false if the list is full
+	*/
+	bool draw(unsigned int program, unsigned int vertexArray, unsigned int texture, glm::vec2 translation, glm::vec2 textureShift, int indexCount, int layer = 0);
+
+	/*
+		orders the commands by layer, then program, then texture, then vertex array, so draws sharing state end up together
+		commands with equal state keep the order they were recorded in
+	*/
+	void sort();
+};
+
+
+/*
+	Something that can execute a command list
+	Every backend counts how many draw calls and state changes it issued for the last list
+*/
+class RenderBackend {
+public:
+	unsigned int drawCalls;
+	unsigned int stateChanges;
+
+	RenderBackend() : drawCalls(0), stateChanges(0) {}
+	virtual ~RenderBackend() {}
+
+	virtual void execute(const RenderCommandList& list) = 0;
+};
+
+
+/*
+	Backend which submits the commands to opengl
+	Uniform locations are looked up once per program and cached. Commands name programs by their opengl name, which
+	opengl hands out again once a program is deleted, so the cache is dropped whenever resources deletes a program
+*/
+class GLRenderBackend : public RenderBackend {
+public:
+	GLRenderBackend();
+
+	/* the manager owning the programs we draw with (call before execute)*/
+	void setResources(const GpuResourceManager* resources);
+
+	void execute(const RenderCommandList& list);
+
+private:
+	// we only ever see a handful of programs, so a small table searched linearly is enough
+	static const int MAX_PROGRAMS = 8;
+
+	struct ProgramUniforms {
+		unsigned int program;
+		int transformation;
+		int textureShift;
+	};
+
+	ProgramUniforms uniforms[MAX_PROGRAMS];
+	int programCount;
+
+	const GpuResourceManager* resources;
+	// programs resources had deleted when the cache was last known good
+	unsigned long long programDeletions;
+
+	/* uniform locations for program, looked up the first time we see it*/
+	const ProgramUniforms& lookup(unsigned int program);
+};
+
+
+/*
+	Backend which does no opengl work at all and only counts what it would have done
+	Used to measure the cpu cost of building and sorting the scene without a gpu in the way
+*/
+class NullRenderBackend : public RenderBackend {
+public:
+	void execute(const RenderCommandList& list);
+};
+
+#endif
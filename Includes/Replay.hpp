@@ -0,0 +1,345 @@
+// Replay.hpp header for recording matches as their seed, settings and input, and playing them back
+// REPLAY_H
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "../Includes/PongSim.hpp"
+#include "../Includes/SpscQueue.hpp"
+#include "../Includes/MappedFile.hpp"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/*
+	A replay is the match seed and settings followed by the player's input and nothing else. The simulation is
+	deterministic, so stepping a fresh PongSim through the same input plays the match out exactly again, and a
+	ten minute match takes a few kilobytes instead of the megabytes its frames would
+
+	File layout (little endian, see ByteIO), append only:
+	  header   magic u32, version u8, tick rate u16, seed u32, ball speed f32, paddle speed f32, max score u8
+	  blocks   codec u8 (0 stored as is, 1 BlockCodec), first tick varint, records size varint, stored size varint,
+	           blockChecksum of the header so far and the records u32, then the block's records, compressed or not
+	  records  a varint of (ticks since the previous record << 4 | direction << 2 | kind) and then
+	           kind 0  the bar's direction changes at the start of the tick
+	           kind 1  the bar's direction changes partway through the tick, offset u8 follows (256ths of the tick)
+	           kind 2  an event, the direction bits say which: 0 new settings (ball f32, paddle f32, max score u8),
+	                   1 the match was reset, 2 a keyframe (the bar's direction so far u8, then PongSim::writeKeyframe),
+	                   3 how the match ended (left score u8, right score u8, PongSim::stateHash u64), just before the end
+	           kind 3  a mark, the direction bits say which: 0 end of the recording, 1 a state hash (the low 16 bits
+	                   of PongSim::stateHash u16)
+	  direction is stored plus one: 0 down, 1 still, 2 up
+	  index    after the last block: tick u32 of every keyframe and file offset u32 of the block holding it
+	  trailer  index offset u32, keyframes u32, ticks u32, REPLAY_INDEX_MAGIC u32
+	Ticks count the steps the match took, time spent paused or in the menu is not in the replay. Records for a tick
+	apply before it is stepped, in the order they were written. Every REPLAY_KEYFRAME_TICKS ticks a keyframe follows
+	that tick's events, holding the whole state the tick starts from, so a player can jump there without simulating
+	the match up to it. A keyframe is coded against the one before it in its block, or the state the match started
+	from for the first one in a block, so most of it is zeros. Every REPLAY_BLOCK_KEYFRAMES keyframes a new block
+	starts, and the first record of a block counts its ticks from the block's first tick rather than the record
+	before it, so each block can be decompressed and read without the others. Keyframes leave out the settings, so a
+	block that opens on settings other than the header's starts with a settings record repeating them. A file cut
+	short (the game crashed) has no index and plays up to its last whole block, the reader finds its keyframes by
+	walking the blocks instead
+	Playing through a keyframe, a state hash or the result checks the match got to the state stored there, so a replay
+	also proves a build plays its matches the way the one that recorded them did. A state hash is taken every
+	REPLAY_HASH_TICKS ticks, or as often as the recorder was asked to (every tick pins a divergence to its exact tick).
+	16 bits let one in 65536 wrong states through, but a match that went wrong stays wrong, so the next hash catches it
+	Files from before version 9 (no blocks, block checksums that leave out the header, a different stateHash, or
+	keyframes written as they are) are not read
+*/
+static const unsigned int REPLAY_MAGIC = 0x4C505250;
+static const unsigned int REPLAY_INDEX_MAGIC = 0x58444E49;
+static const int REPLAY_VERSION = 9;
+static const int REPLAY_HEADER_SIZE = 20;
+static const int REPLAY_TRAILER_SIZE = 16;
+
+// ticks between keyframes, five seconds at 120 Hz, so a seek simulates at most 600 ticks
+static const int REPLAY_KEYFRAME_TICKS = 600;
+
+// keyframes per block, forty seconds at 120 Hz. Longer blocks compress better, shorter ones lose less in a crash
+static const int REPLAY_BLOCK_KEYFRAMES = 8;
+
+// ticks between state hashes unless the recorder is told otherwise, two and a half seconds at 120 Hz, halfway
+// between keyframes (a keyframe checks the whole state, so no hash is taken on one)
+static const int REPLAY_HASH_TICKS = 300;
+
+enum ReplayRecord { REPLAY_DIRECTION = 0, REPLAY_CHANGE = 1, REPLAY_EVENT = 2, REPLAY_MARK = 3 };
+enum ReplayEvent { REPLAY_SETTINGS = 0, REPLAY_RESET = 1, REPLAY_KEYFRAME = 2, REPLAY_RESULT = 3 };
+enum ReplayMark { REPLAY_END = 0, REPLAY_HASH = 1 };
+
+
+/*
+	The settings a replay starts from
+*/
+struct ReplayHeader {
+	int tickRate;
+	unsigned int seed;
+	float ballSpeed, barSpeed;
+	int maxScore;
+};
+
+/*
+	Where a keyframe is: the tick it starts and the file offset of the block holding it
+*/
+struct ReplayKeyframe {
+	unsigned int tick;
+	unsigned int offset;
+};
+
+/*
+	How a recorded match ended
+*/
+struct ReplayResult {
+	int leftScore, rightScore;
+	unsigned long long stateHash;
+};
+
+/* puts sim in the state a match recorded with header starts from (the recorder and the player both use this)*/
+void startReplayMatch(PongSim& sim, const ReplayHeader& header);
+
+/* adds the path of every .replay file in directory (not its subdirectories) to paths, sorted. False if it cannot be read*/
+bool listReplays(const char* directory, std::vector<std::string>* paths);
+
+
+/*
+	Class which records a match as it is played
+	The simulation thread calls it once per tick, which only appends a few bytes to a block in memory. Finished blocks
+	go to a writer thread through a queue, which compresses and writes them, so the simulation thread never waits on
+	the disk or the compressor, and a crash loses at most the block being recorded
+	Offsets inside a tick are rounded to 256ths of the tick. recordTick() rounds the input it is given in place, and
+	the caller simulates with that, so the live match and its replay see exactly the same input
+*/
+class ReplayWriter {
+public:
+	ReplayWriter();
+
+	/* finishes the recording if it is still open*/
+	~ReplayWriter();
+
+	/* creates the file and starts the writer thread. Returns false if the file could not be created*/
+	bool open(const char* path);
+
+	/* whether blocks are compressed (the default) or stored as they are, call before begin*/
+	void setCompression(bool compress);
+
+	/* ticks between state hashes, 0 for none and 1 for every tick (REPLAY_HASH_TICKS by default), call before begin*/
+	void setHashInterval(int ticks);
+
+	/* writes the header, the match must have just been set up with startReplayMatch (simulation thread only)*/
+	void begin(const ReplayHeader& header);
+
+	/* whether begin() has been called*/
+	bool started() const;
+
+	/* records new settings, if they differ from the last ones (simulation thread only)*/
+	void settings(float ballSpeed, float barSpeed, int maxScore);
+
+	/* records a full reset of the match (simulation thread only)*/
+	void reset();
+
+	/*
+		records the input of the next tick, rounding its offsets first (simulation thread only)
+		sim is the match about to be stepped with it, a keyframe of it is taken every REPLAY_KEYFRAME_TICKS ticks
+	*/
+	void recordTick(TickInput& input, const PongSim& sim);
+
+	/* records how the match ended, once after its last tick (simulation thread only)*/
+	void result(const PongSim& sim);
+
+	/* writes the end record and the keyframe index, waits for everything to reach the disk and closes the file*/
+	void finish();
+
+	/* ticks recorded, and bytes recorded before compression*/
+	unsigned long long ticks() const;
+	unsigned long long bytes() const;
+
+	/* size of the file, once finished*/
+	unsigned long long fileBytes() const;
+
+private:
+	/*
+		Records on their way to the writer thread: a block, or the file header which is written as it is
+	*/
+	struct Block {
+		bool header;
+		unsigned int firstTick;
+		std::vector<unsigned char> bytes;
+		std::vector<unsigned int> keyframeTicks;
+	};
+
+	FILE* file;
+	std::thread thread;
+	std::atomic<bool> alive;
+	SpscQueue<Block*, 64> full;
+	bool compress;
+	int hashTicks;
+
+	// set before the writer thread is told to stop, so it knows to write the index
+	bool ended;
+	unsigned long long finalTicks;
+
+	// belongs to the writer thread
+	std::vector<ReplayKeyframe> index;
+	std::vector<unsigned char> packed;
+	unsigned long long written;
+
+	// everything below belongs to the simulation thread
+	Block* block;
+	// blocks the queue had no room for yet, oldest first
+	std::vector<Block*> waiting;
+	bool begun;
+	unsigned long long tick, lastRecordTick, byteCount;
+	int direction;
+	float timeDelta;
+	float ballSpeed, barSpeed;
+	int maxScore;
+	// what the match started with, a block opening on other settings repeats them
+	ReplayHeader opening;
+	// what the next keyframe is coded against and the tick it was taken: the block's keyframe before it, or the state
+	// the match started from for the first one in a block
+	unsigned char startState[PongSim::STATE_BYTES], keyframeBase[PongSim::STATE_BYTES];
+	unsigned long long keyframeBaseTick;
+
+	/* body of the writer thread*/
+	void run();
+
+	/* compresses a block and writes it out (writer thread)*/
+	void writeBlock(const Block& finished);
+
+	/* appends one record header for the current tick*/
+	void writeRecord(int kind, int value);
+
+	/* appends bytes to the current block*/
+	void append(const unsigned char* bytes, const unsigned char* end);
+
+	/* appends a settings record with the current settings*/
+	void writeSettings();
+
+	/* queues the current block for the writer thread and starts the next one at the current tick*/
+	void closeBlock();
+
+	/* hands waiting blocks to the writer thread, as many as the queue takes*/
+	void handOver();
+
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+};
+
+
+/*
+	Class which plays a replay file back into a PongSim
+	The file is memory mapped, so opening even an hour long replay only reads its header and index. Blocks are
+	decompressed one at a time as play reaches them. seek() decompresses the block holding the nearest keyframe at or
+	before the tick asked for, restores it and simulates the rest of the way, at most REPLAY_KEYFRAME_TICKS ticks, so
+	any point of a replay is a fraction of a millisecond away
+*/
+class ReplayReader {
+public:
+	ReplayReader();
+
+	/* maps the file, returns false if it is missing or not a replay*/
+	bool open(const char* path);
+
+	const ReplayHeader& header() const;
+
+	/* sets sim up as the match started*/
+	void start(PongSim& sim);
+
+	/* applies the records of the next tick and steps sim through it. Returns false once the replay is over*/
+	bool step(PongSim& sim);
+
+	/*
+		puts sim where the match was at the start of tick, as if it had been stepped there from the start
+		Returns false if the replay ends before tick
+	*/
+	bool seek(PongSim& sim, unsigned long long tick);
+
+	/* ticks played so far*/
+	unsigned long long tick() const;
+
+	/* ticks in the whole replay*/
+	unsigned long long length() const;
+
+	/* keyframes in the replay*/
+	const std::vector<ReplayKeyframe>& index() const;
+
+	/* whether the replay ends properly rather than being cut short*/
+	bool complete() const;
+
+	/* whether a block played up to was all there but could not be decoded, the file was changed after it was written*/
+	bool damaged() const;
+
+	/* whether a keyframe, hash or the result played through so far held a different state than the match reached*/
+	bool diverged() const;
+
+	/*
+		the tick of the first keyframe, hash or result that did not match (once diverged), and the last one that did
+		without a hash every tick the match went wrong somewhere after the one and no later than the other
+	*/
+	unsigned long long divergedTick() const;
+	unsigned long long verifiedTick() const;
+
+	/* the stored result, once played up to it. Returns false if there is none (yet)*/
+	bool storedResult(ReplayResult* result) const;
+
+private:
+	MappedFile file;
+	// the file's bytes, and where its blocks stop (the index after them is not a block)
+	const unsigned char* data;
+	size_t dataSize;
+	// the block being read: where it and the next one start in the file, its first tick, the last tick a record in
+	// it can have and its records (straight from the file if stored, decompressed into blockBuffer if not)
+	bool blockLoaded;
+	size_t blockOffset, nextBlock;
+	unsigned long long blockFirstTick, blockLastTick;
+	// what the block's next keyframe is coded against and its tick, as in ReplayWriter
+	unsigned char startState[PongSim::STATE_BYTES], keyframeBase[PongSim::STATE_BYTES];
+	unsigned long long keyframeBaseTick;
+	const unsigned char* records;
+	size_t recordsSize;
+	std::vector<unsigned char> blockBuffer;
+	ReplayHeader info;
+	std::vector<ReplayKeyframe> keyframes;
+	unsigned long long totalTicks;
+	// the sim we are playing into, seeking forward in it can carry on from where it is
+	const PongSim* playing;
+	size_t position;
+	unsigned long long current;
+	// position in the block's records, and the next record: its tick, its varint and where its body starts.
+	// lastRecord is the tick of the one before
+	unsigned long long nextRecord, recordValue, lastRecord;
+	size_t recordBody;
+	bool haveRecord, ended, finished;
+	// what the checks along the way found
+	bool mismatch, haveResult, damagedBlock;
+	unsigned long long firstMismatch, lastMatch;
+	ReplayResult stored;
+	// the bar's direction at the end of the last tick
+	int direction;
+
+	/* reads the record header at position, moving on to the next block at the end of this one. haveRecord is false if there is none*/
+	void peekRecord();
+
+	/* makes the block at offset the one being read, returns false if there is none or it is damaged*/
+	bool loadBlock(size_t offset);
+
+	/* reads the trailer's index, returns false if the file has none*/
+	bool readIndex();
+
+	/* finds the keyframes and the length of a file without an index by walking its blocks*/
+	void scanBlocks();
+
+	/* compares sim with the state a keyframe, hash or result stored for the current tick*/
+	void check(bool same);
+
+	/* restores sim from a keyframe and carries on reading after it, returns false if it is not where the index says*/
+	bool restore(PongSim& sim, const ReplayKeyframe& keyframe);
+
+	ReplayReader(const ReplayReader&) = delete;
+	ReplayReader& operator=(const ReplayReader&) = delete;
+};
+
+#endif
@@ -0,0 +1,65 @@
+// Replication.hpp header for sending match state as small quantized deltas
+// REPLICATION_H
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include "../Includes/PongSim.hpp"
+#include "../Includes/StateRing.hpp"
+
+
+/*
+	What a player needs to draw one tick of a match, quantized
+	Positions cover -POSITION_RANGE to POSITION_RANGE in POSITION_BITS bits (about 0.0002 of the screen per step)
+*/
+struct ReplicatedState {
+	unsigned int tick;
+	unsigned short leftBar, rightBar, ballX, ballY;
+	unsigned char leftScore, rightScore;
+};
+
+static const int POSITION_BITS = 14;
+static const float POSITION_RANGE = 1.5f;
+
+// a delta can only be taken against a state at most this many ticks older
+static const int REPLICATION_WINDOW = 31;
+
+// states the sender and receiver keep to delta against
+static const int REPLICATION_HISTORY = 64;
+
+// largest encoded state, a full one
+static const int REPLICATION_MAX_BYTES = 14;
+
+/* quantizes the parts of the match a player sees*/
+ReplicatedState replicate(const PongSim& sim);
+
+/* converts a quantized position back*/
+float dequantizePosition(unsigned short value);
+
+/*
+	Bit packs state, as a delta against base if base is not null (base must be 1 to REPLICATION_WINDOW ticks older)
+	A delta is one bit per unchanged position, a changed position costs its change in 5, 8 or 11 bits (or all 14) plus 3,
+	and the scores are only included when one of them changed. out needs REPLICATION_MAX_BYTES, returns the bytes used
+*/
+int encodeState(const ReplicatedState* base, const ReplicatedState& state, unsigned char* out);
+
+
+/*
+	Class which decodes states for one player, keeping the recent ones to apply deltas to
+*/
+class ReplicationReceiver {
+public:
+	ReplicationReceiver();
+
+	/* forgets every state (a new match)*/
+	void reset();
+
+	/* decodes one encoded state into state. Returns false if it is malformed or its base is no longer held*/
+	bool receive(const unsigned char* data, int length, ReplicatedState* state);
+
+private:
+	StateRing<ReplicatedState, REPLICATION_HISTORY> history;
+	unsigned int newest;
+	bool any;
+};
+
+#endif
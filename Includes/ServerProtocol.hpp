@@ -0,0 +1,65 @@
+// ServerProtocol.hpp header for the packets between the match server and its players
+// SERVERPROTOCOL_H
+#ifndef SERVERPROTOCOL_H
+#define SERVERPROTOCOL_H
+
+#include "../Includes/ByteIO.hpp"
+#include "../Includes/Replication.hpp"
+
+
+/*
+	Every packet starts with SERVER_MAGIC, a type byte and the player id, a number the client picks so one socket
+	can carry many players (the bot client runs thousands per socket). Players are told apart by address and id
+
+	JOIN   client -> server   asks for a match, repeated until WELCOME arrives
+	WELCOME server -> client  side u8 (0 left, 1 right)
+	INPUT  client -> server   direction i8 (1 up, -1 down, 0 still), held until the next INPUT
+	STATE  server -> client   one ReplicatedState from encodeState, a delta against the newest state the player acknowledged
+	END    server -> client   status u8 (1 left won, 2 right won, 3 the other player left)
+	LEAVE  client -> server   gives up the match
+	ACK    client -> server   tick u32 of the newest state decoded. Sending it every few ticks keeps the deltas small
+
+	Spectators use the same header with an id of their own
+	WATCH     client -> server   match u32, asks to watch that match (or the next one playing), repeated until WATCHING arrives
+	WATCHING  server -> client   match u32 being watched. After that the spectator sends ACK like a player, and LEAVE to stop
+	BROADCAST server -> client   match u32 and one ReplicatedState, the same bytes for every spectator of the match (player id 0)
+	                             Keyframes are full states, every other state is a delta against the newest keyframe
+	END goes to spectators too when their match ends
+*/
+static const unsigned short SERVER_MAGIC = 0x5350;
+
+enum ServerPacket { SERVER_JOIN = 1, SERVER_WELCOME = 2, SERVER_INPUT = 3, SERVER_STATE = 4, SERVER_END = 5, SERVER_LEAVE = 6, SERVER_ACK = 7,
+	SERVER_WATCH = 8, SERVER_WATCHING = 9, SERVER_BROADCAST = 10 };
+
+// magic, type and player id
+static const int SERVER_HEADER_SIZE = 5;
+
+// biggest packet either side sends (a broadcast state with its match)
+static const int SERVER_PACKET_SIZE = SERVER_HEADER_SIZE + 4 + REPLICATION_MAX_BYTES;
+
+// default port of the match server
+static const unsigned short SERVER_PORT = 27016;
+
+// matches end with this status when a player goes quiet or leaves
+static const int SERVER_END_ABANDONED = 3;
+
+/* writes the header, returns the pointer to write the body at*/
+inline unsigned char* writeServerHeader(unsigned char* packet, int type, unsigned short player) {
+	unsigned char* out = packet;
+	writeU16(out, SERVER_MAGIC);
+	writeU8(out, (unsigned char)type);
+	writeU16(out, player);
+	return out;
+}
+
+/* reads the header, returns false if this is not one of our packets*/
+inline bool readServerHeader(const unsigned char*& in, int length, int* type, unsigned short* player) {
+	if (length < SERVER_HEADER_SIZE || readU16(in) != SERVER_MAGIC) {
+		return false;
+	}
+	*type = readU8(in);
+	*player = readU16(in);
+	return true;
+}
+
+#endif
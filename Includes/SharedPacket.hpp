@@ -0,0 +1,62 @@
+// SharedPacket.hpp header for a datagram that is serialized once and sent to many addresses
+// SHAREDPACKET_H
+#ifndef SHAREDPACKET_H
+#define SHAREDPACKET_H
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+
+/*
+	Immutable reference counted datagram, its bytes are allocated in the same block right after it
+	Whoever creates it holds one reference and every DatagramBatch it is queued on holds another until that batch is
+	flushed, so the same bytes go out to every address without being copied again. The last release frees it
+	The count is atomic so a packet can be queued on batches belonging to other threads
+*/
+class SharedPacket {
+public:
+	/* copies data into a new packet with one reference*/
+	static SharedPacket* create(const unsigned char* data, int length) {
+		void* memory = ::operator new(sizeof(SharedPacket) + length);
+		SharedPacket* packet = new (memory) SharedPacket(length);
+		memcpy(packet->bytes(), data, length);
+		return packet;
+	}
+
+	void retain() {
+		references.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/* drops a reference, freeing the packet if it was the last*/
+	void release() {
+		if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			this->~SharedPacket();
+			::operator delete(this);
+		}
+	}
+
+	const unsigned char* data() const {
+		return reinterpret_cast<const unsigned char*>(this + 1);
+	}
+
+	int length() const {
+		return size;
+	}
+
+private:
+	std::atomic<int> references;
+	int size;
+
+	explicit SharedPacket(int length) : references(1), size(length) {}
+	~SharedPacket() {}
+
+	unsigned char* bytes() {
+		return reinterpret_cast<unsigned char*>(this + 1);
+	}
+
+	SharedPacket(const SharedPacket&) = delete;
+	SharedPacket& operator=(const SharedPacket&) = delete;
+};
+
+#endif
@@ -0,0 +1,99 @@
+// SimThread.hpp header for running the pong simulation on its own thread at a fixed tick
+// SIMTHREAD_H
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include "../Includes/PongSim.hpp"
+#include "../Includes/TripleBuffer.hpp"
+#include "../Includes/Profiler.hpp"
+#include "../Includes/InputQueue.hpp"
+#include "../Includes/Replay.hpp"
+#include <atomic>
+#include <thread>
+
+
+/*
+	Class which steps a PongSim on a dedicated thread at a fixed tick rate
+	Every tick it publishes a PongSnapshot through a triple buffer, which the render thread reads without locking
+	so a blocking glfwSwapBuffers never holds up the simulation and the simulation never waits on the gpu
+	Settings and resets from the render thread go through atomics, the player's input through a timestamped InputQueue
+*/
+class SimThread {
+public:
+	// how many times per second we step the simulation
+	int tickRate;
+
+	/* constructor only stores the tick rate, call start() to launch the thread*/
+	SimThread(int tickRate);
+
+	/* stops the thread if it is still running*/
+	~SimThread();
+
+	/* report the time spent in the simulation and the AI to a profiler (call before start)*/
+	void setProfiler(Profiler* profiler);
+
+	/* launches the simulation thread*/
+	void start();
+
+	/* asks the simulation thread to finish and waits for it*/
+	void stop();
+
+	/*
+		queue the player's key events are read from (call before start)
+		each event is applied at the point inside its tick where it happened
+	*/
+	void setInputQueue(InputQueue* input);
+
+	/*
+		record the match to an opened replay (call before start)
+		the match is started over from a fresh seed on the first tick so the replay holds all of it
+	*/
+	void setRecorder(ReplayWriter* recorder);
+
+	/* records how the match ended and closes the recording (call after stop)*/
+	void finishRecording();
+
+	/* while running is false the match is paused (we still publish snapshots so resets show up)*/
+	void setRunning(bool running);
+
+	/* restart the match from scratch on the next tick*/
+	void requestReset();
+
+	/* settings from the menu, applied on the next tick*/
+	void setGameParameters(float ballSpeed, float barSpeed, int maxScore);
+
+	/* the newest snapshot published by the simulation (render thread only)*/
+	const PongSnapshot& latestSnapshot();
+
+private:
+	// the simulation is only ever touched by the simulation thread once it has started
+	PongSim sim;
+
+	TripleBuffer<PongSnapshot> snapshots;
+
+	Profiler* profiler;
+
+	InputQueue* input;
+
+	ReplayWriter* recorder;
+
+	std::thread thread;
+
+	std::atomic<bool> alive;
+	std::atomic<bool> running;
+	std::atomic<bool> resetRequested;
+	std::atomic<float> ballSpeed;
+	std::atomic<float> barSpeed;
+	std::atomic<int> maxScore;
+
+	/* body of the simulation thread*/
+	void run();
+
+	/*
+		apply the settings and reset requests from the render thread, then step the match if we are running
+		the tick covers tickStart to tickEnd on the InputQueue clock, input events up to tickEnd are applied in it
+	*/
+	void tick(long long tickStart, long long tickEnd);
+};
+
+#endif
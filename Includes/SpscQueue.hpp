@@ -0,0 +1,59 @@
+// SpscQueue.hpp header for passing a stream of values from one thread to another without locks
+// SPSCQUEUE_H
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+
+
+/*
+	Single producer, single consumer ring buffer holding up to CAPACITY values (CAPACITY must be a power of two)
+	Unlike TripleBuffer every value pushed is delivered, in order. When the ring is full push() fails instead of waiting
+	head and tail only ever count up, their difference is how many values are waiting
+*/
+template <typename T, unsigned int CAPACITY>
+class SpscQueue {
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+	SpscQueue() : values(), head(0), tail(0) {}
+
+	/* adds a value to the back of the queue, returns false if the queue is full (producer thread only)*/
+	bool push(const T& value) {
+		unsigned int back = tail.load(std::memory_order_relaxed);
+		if (back - head.load(std::memory_order_acquire) == CAPACITY) {
+			return false;
+		}
+		values[back & (CAPACITY - 1)] = value;
+		tail.store(back + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* copies the front value without removing it, returns false if the queue is empty (consumer thread only)*/
+	bool peek(T& value) const {
+		unsigned int front = head.load(std::memory_order_relaxed);
+		if (front == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = values[front & (CAPACITY - 1)];
+		return true;
+	}
+
+	/* removes the front value, returns false if the queue is empty (consumer thread only)*/
+	bool pop(T& value) {
+		if (!peek(value)) {
+			return false;
+		}
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T values[CAPACITY];
+
+	// the consumer owns head and the producer owns tail, each on its own cache line
+	alignas(64) std::atomic<unsigned int> head;
+	alignas(64) std::atomic<unsigned int> tail;
+};
+
+#endif
@@ -0,0 +1,38 @@
+// StateHash.hpp header for a fast hash of simulation state, cheap enough to take every tick
+// STATEHASH_H
+#ifndef STATEHASH_H
+#define STATEHASH_H
+
+
+/*
+	A non cryptographic hash of a short run of 64 bit words, for proving two simulations agree. It catches bugs, not
+	cheaters: anyone can build a state with a given hash
+	Four lanes each add the word xor a secret, its two 32 bit halves multiplied together, and the word of the lane next
+	to them (the accumulate step of xxHash3), then the lanes are mixed down to one value. The lanes never depend on each
+	other, so the cpu runs them side by side, and with SSE2 two lanes go through each instruction. Both paths give the
+	same hash bit for bit, so hashes taken on different machines or builds compare
+	Define PONG_NO_SIMD to build without SSE2
+*/
+#if !defined(PONG_NO_SIMD) && (defined(_M_X64) || defined(__SSE2__))
+#define STATE_HASH_SIMD 1
+#else
+#define STATE_HASH_SIMD 0
+#endif
+
+// words hashed per round, and the most a hash takes
+static const int STATE_HASH_LANES = 4;
+static const int STATE_HASH_MAX_WORDS = 16;
+
+/* hash of count words, count a multiple of STATE_HASH_LANES and at most STATE_HASH_MAX_WORDS*/
+unsigned long long hashWords(const unsigned long long* words, int count);
+
+/* the same without SIMD, whichever way the build went, to check the two agree*/
+unsigned long long hashWordsScalar(const unsigned long long* words, int count);
+
+/*
+	folds the hash of the next tick into a running hash of every tick before it
+	Two chains that agree at a tick agree at every tick up to it, so comparing now and then still checks every tick
+*/
+unsigned long long chainHash(unsigned long long chain, unsigned long long hash);
+
+#endif
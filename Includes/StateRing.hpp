@@ -0,0 +1,53 @@
+// StateRing.hpp header for keeping the last few frames of match state to jump back to
+// STATERING_H
+#ifndef STATERING_H
+#define STATERING_H
+
+#include <cstring>
+#include <type_traits>
+
+
+/*
+	Preallocated ring holding the state of the last N frames (N a power of two)
+	Saving and restoring are one memcpy each, so rolling back or seeking many times a frame costs next to nothing
+	T must be trivially copyable (PongSim is)
+*/
+template <typename T, int N>
+class StateRing {
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "StateRing copies states with memcpy");
+	static_assert(N > 0 && (N & (N - 1)) == 0, "StateRing size must be a power of two");
+
+	StateRing() {
+		memset(frames, 0, sizeof(frames));
+	}
+
+	/* stores state as it was at frame, overwriting whatever frame was N frames before it*/
+	void save(unsigned long long frame, const T& state) {
+		int slot = (int)(frame & (N - 1));
+		memcpy(&states[slot], &state, sizeof(T));
+		// stored as frame + 1 so an empty slot never matches
+		frames[slot] = frame + 1;
+	}
+
+	/* copies the state saved at frame into state, returns false (leaving state alone) if it is no longer held*/
+	bool restore(unsigned long long frame, T* state) const {
+		int slot = (int)(frame & (N - 1));
+		if (frames[slot] != frame + 1) {
+			return false;
+		}
+		memcpy(state, &states[slot], sizeof(T));
+		return true;
+	}
+
+	/* whether the state at frame is still held*/
+	bool holds(unsigned long long frame) const {
+		return frames[frame & (N - 1)] == frame + 1;
+	}
+
+private:
+	T states[N];
+	unsigned long long frames[N];
+};
+
+#endif
@@ -0,0 +1,80 @@
+// TimerWheel.hpp header for scheduling huge numbers of timers in constant time
+// TIMERWHEEL_H
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <vector>
+
+
+/*
+	A timer that went off: when it was due and the value it was scheduled with
+*/
+struct ExpiredTimer {
+	unsigned long long when;
+	unsigned long long data;
+};
+
+
+/*
+	Hierarchical timer wheel (the kernel's classic design): LEVELS wheels of SLOTS slots each, a slot of level n covering
+	SLOTS^n time units. A timer goes in the lowest level whose span reaches its deadline. Whenever the level below wraps
+	around, the next slot of a level is cascaded: its timers move down to finer slots
+	Scheduling and cancelling are O(1), and moving time on costs one slot per time unit plus one cascade per timer per level,
+	where a binary heap pays O(log n) for every timer
+	Timers live in one preallocated pool linked by index, so the steady state allocates nothing
+	Time is in whatever unit the caller counts in (the match server uses milliseconds). Deadlines further than the wheel
+	spans (SLOTS^LEVELS units) are parked at its far end and rescheduled from there
+*/
+class TimerWheel {
+public:
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = 1 << SLOT_BITS;
+	static const int LEVELS = 4;
+
+	/* a wheel whose clock starts at start*/
+	explicit TimerWheel(unsigned long long start = 0);
+
+	/* a timer that goes off at when (or on the next advance, if when has passed). Returns a handle for cancel*/
+	unsigned long long schedule(unsigned long long when, unsigned long long data);
+
+	/* stops a timer that has not gone off yet, returns false if it already went off or was cancelled*/
+	bool cancel(unsigned long long handle);
+
+	/* moves the clock up to now, appending every timer due by then to fired, earliest slot first*/
+	void advance(unsigned long long now, std::vector<ExpiredTimer>& fired);
+
+	/* the next time unit advance will look at*/
+	unsigned long long time() const;
+
+	/* timers scheduled and not yet gone off*/
+	int pending() const;
+
+private:
+	struct Timer {
+		unsigned long long when;
+		unsigned long long data;
+		// neighbours in the slot's list, or in the free list (-1 at the end). slot is -1 while free
+		int next, prev;
+		int slot;
+		// bumped every time the timer is freed, so an old handle can never cancel the timer reusing its place
+		unsigned int generation;
+	};
+
+	std::vector<Timer> timers;
+	int freeList;
+	int count;
+	// first timer in each slot, level by level
+	int heads[LEVELS * SLOTS];
+	unsigned long long current;
+
+	/* links timer index into the slot its deadline falls in*/
+	void insert(int index);
+
+	/* takes timer index out of its slot*/
+	void unlink(int index);
+
+	/* moves every timer in the slot of level that comes up at the current time down the wheel*/
+	void cascade(int level);
+};
+
+#endif
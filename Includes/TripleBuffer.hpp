@@ -0,0 +1,54 @@
+// TripleBuffer.hpp header for handing the latest value from one thread to another without locks
+// TRIPLEBUFFER_H
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+
+/*
+	Single producer, single consumer triple buffer
+	The writer fills writeBuffer() and calls publish(), the reader calls read() to get the newest published value
+	Neither side ever waits on the other: the writer always has a free slot and the reader always has a complete value
+	Values that are published faster than they are read are simply overwritten (we only care about the latest one)
+*/
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : buffers(), middle(1), writeIndex(0), readIndex(2) {}
+
+	/* the slot the writer should fill next (writer thread only)*/
+	T& writeBuffer() {
+		return buffers[writeIndex];
+	}
+
+	/* hands the filled write slot to the reader and takes back whichever slot was waiting in the middle (writer thread only)*/
+	void publish() {
+		unsigned char previous = middle.exchange((unsigned char)(writeIndex | FRESH), std::memory_order_acq_rel);
+		writeIndex = previous & INDEX_MASK;
+	}
+
+	/* the newest published value, or the same value as last time if nothing new was published (reader thread only)*/
+	const T& read() {
+		if (middle.load(std::memory_order_relaxed) & FRESH) {
+			unsigned char previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+			readIndex = previous & INDEX_MASK;
+		}
+		return buffers[readIndex];
+	}
+
+private:
+	// the middle slot has been published but not read yet
+	static const unsigned char FRESH = 4;
+	static const unsigned char INDEX_MASK = 3;
+
+	T buffers[3];
+
+	// index of the slot between the writer and reader, plus the FRESH bit
+	// each index lives on its own cache line so the two threads do not fight over them
+	alignas(64) std::atomic<unsigned char> middle;
+	alignas(64) unsigned char writeIndex;
+	alignas(64) unsigned char readIndex;
+};
+
+#endif
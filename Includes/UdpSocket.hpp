@@ -0,0 +1,139 @@
+// UdpSocket.hpp header for a minimal non-blocking udp socket (winsock on windows, bsd sockets elsewhere)
+// UDPSOCKET_H
+#ifndef UDPSOCKET_H
+#define UDPSOCKET_H
+
+class SharedPacket;
+
+
+/*
+	ipv4 address and port, both in host byte order
+*/
+struct NetAddress {
+	unsigned int ip;
+	unsigned short port;
+
+	NetAddress() : ip(0), port(0) {}
+	NetAddress(unsigned int ip, unsigned short port) : ip(ip), port(port) {}
+
+	bool operator==(const NetAddress& other) const {
+		return ip == other.ip && port == other.port;
+	}
+
+	bool operator!=(const NetAddress& other) const {
+		return !(*this == other);
+	}
+
+	/* resolves a host name or dotted address ("localhost", "192.168.1.20"). Returns false if it could not be resolved*/
+	static bool resolve(const char* host, unsigned short port, NetAddress* address);
+};
+
+
+/*
+	Class which wraps a udp socket bound to a local port
+	Sends and receives never block: receive returns -1 straight away when nothing has arrived
+*/
+class UdpSocket {
+public:
+	// biggest datagram we send or accept
+	static const int MAX_PACKET = 1200;
+
+	UdpSocket();
+
+	/* closes the socket if it is open*/
+	~UdpSocket();
+
+	/* sets up the socket library (winsock needs this once per process). Returns false on failure*/
+	static bool startup();
+
+	/* tears the socket library down again*/
+	static void shutdown();
+
+	/*
+		opens a socket bound to port on every interface (0 picks any free port). Returns false on failure
+		sharePort lets several sockets bind the same port, the kernel then spreads senders across them (linux only)
+	*/
+	bool open(unsigned short port, bool sharePort = false);
+
+	void close();
+
+	bool isOpen() const;
+
+	/* the port we are bound to*/
+	unsigned short localPort() const;
+
+	/* sends one datagram, returns false if it could not be sent*/
+	bool send(const NetAddress& to, const void* data, int length);
+
+	/* receives one datagram into data, returns its length or -1 if nothing is waiting*/
+	int receive(NetAddress* from, void* data, int capacity);
+
+	/* the SOCKET or file descriptor, for polling it*/
+	long long nativeHandle() const;
+
+private:
+	// SOCKET on windows and a file descriptor elsewhere, both fit in this
+	long long handle;
+
+	unsigned short port;
+
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+};
+
+
+
+/*
+	Class which sends and receives up to SIZE datagrams per system call (recvmmsg and sendmmsg on linux)
+	On other systems it falls back to one call per datagram, with the same interface
+	Received datagrams stay valid until the next receive, queued ones are copied in and sent on flush
+	queueShared() sends a SharedPacket without copying it: the message header points straight at the packet's bytes,
+	so one packet fanned out to many addresses costs a header per address and nothing more
+*/
+class DatagramBatch {
+public:
+	static const int SIZE = 64;
+
+	DatagramBatch();
+	~DatagramBatch();
+
+	/* receives the datagrams waiting on socket (at most SIZE), returns how many*/
+	int receive(UdpSocket& socket);
+
+	const unsigned char* data(int i) const;
+	int length(int i) const;
+	const NetAddress& from(int i) const;
+
+	/* queues a datagram, sending the whole batch first if it is full*/
+	void queue(UdpSocket& socket, const NetAddress& to, const unsigned char* data, int length);
+
+	/* queues packet for to without copying it, holding a reference until it is sent*/
+	void queueShared(UdpSocket& socket, const NetAddress& to, SharedPacket* packet);
+
+	/* sends every queued datagram. Ones the socket has no room for are dropped, like the network would*/
+	void flush(UdpSocket& socket);
+
+	/* how many datagrams are queued*/
+	int queued() const;
+
+private:
+	// platform specific message headers, allocated by the constructor
+	struct Headers;
+	Headers* headers;
+
+	unsigned char* inData;
+	int inLengths[SIZE];
+	NetAddress inFrom[SIZE];
+
+	unsigned char* outData;
+	int outLengths[SIZE];
+	NetAddress outTo[SIZE];
+	// the packet each queued datagram points at, null for the ones copied into outData
+	SharedPacket* outShared[SIZE];
+	int outCount;
+
+	DatagramBatch(const DatagramBatch&) = delete;
+	DatagramBatch& operator=(const DatagramBatch&) = delete;
+};
+
+#endif
@@ -0,0 +1,85 @@
+// VideoExport.hpp header for rendering matches offscreen and streaming the frames out as raw video
+// VIDEOEXPORT_H
+#ifndef VIDEOEXPORT_H
+#define VIDEOEXPORT_H
+
+#include "../Includes/Pong.hpp"
+#include "../Includes/GpuResources.hpp"
+#include <glad/glad.h>
+#include <cstdio>
+#include <vector>
+
+
+/*
+	Class which renders into an offscreen framebuffer and streams every frame to a file (or stdout) as raw video
+	Readback goes through two pixel buffer objects: the frame we just rendered is read into one of them
+	while we map the other one (holding the previous frame), so the copy off the gpu overlaps rendering the next frame
+*/
+class VideoExporter {
+public:
+	/*
+		Y4M writes a yuv4mpeg2 stream (4:4:4) which most players and ffmpeg read directly
+		RAW_RGB writes packed rgb24 frames with no header (ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH -r fps -i ...)
+	*/
+	enum Format { Y4M, RAW_RGB };
+
+	// size of the exported frames in pixels
+	int width, height;
+
+	// frames per second written in the Y4M header
+	int fps;
+
+	Format format;
+
+	// how many frames have been written out so far
+	long long framesWritten;
+
+	/* constructor only stores the settings, no opengl work happens until open() (which creates its objects through resources)*/
+	VideoExporter(GpuResourceManager* resources, int width, int height, int fps, Format format);
+
+	/*
+		Creates the offscreen framebuffer and readback buffers, and opens the output
+		path can be "-" to stream to stdout (so the output can be piped straight into an encoder)
+		Returns false if the output could not be opened or the framebuffer is incomplete
+	*/
+	bool open(const char* path);
+
+	/* binds the offscreen framebuffer and clears it, everything drawn after this ends up in the next frame*/
+	void beginFrame();
+
+	/* queues the readback of the frame we just drew and writes out the previous frame*/
+	void endFrame();
+
+	/* writes the last pending frame, releases the opengl objects and closes the output*/
+	void close();
+
+private:
+	GpuResourceManager* resources;
+
+	// offscreen render target
+	OwnedFramebuffer fbo;
+	OwnedRenderbuffer colorBuffer;
+
+	// double buffered pixel buffer objects used for asynchronous readback
+	OwnedBuffer pbos[2];
+
+	// number of frames we have queued a readback for
+	long long framesQueued;
+
+	FILE* out;
+
+	// converted frame waiting to be written (either packed rgb or the three yuv planes)
+	std::vector<unsigned char> frame;
+
+	/* maps the given pixel buffer object and writes its frame to the output*/
+	void writePending(unsigned int pbo);
+};
+
+/*
+	Simulates a match headlessly with a fixed timestep of 1/fps and exports every tick as a video frame
+	Both bars are driven by the AI until one of them wins or maxSeconds of match time has been exported
+	Needs a current opengl context (the window can be hidden). Returns 0 on success
+*/
+int exportMatch(PongState* pong, VideoExporter* exporter, const char* path, float maxSeconds);
+
+#endif
@@ -5,11 +5,19 @@
 
 #include<glad/glad.h>
 #include<GLFW/glfw3.h>
+#include<cstddef>
 
 /*
     Function to adjust the window of opengl as a callback
 */
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
+/*
+    Function to load an rgb image into a mipmapped 2d texture (flipped so the first row is at the bottom, like opengl expects)
+    Returns the texture id, or 0 (and no texture is left behind) if the image could not be loaded
+    If bytes is given it receives the gpu memory the texture takes up, mipmaps included
+*/
+unsigned int loadTexture(const char* path, size_t* bytes = nullptr);
+
 
 #endif
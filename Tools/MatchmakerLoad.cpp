@@ -0,0 +1,142 @@
+#include "../Includes/Matchmaker.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+// MatchmakerLoad.cpp holds a load generator for the matchmaker: network threads submitting join requests at a fixed rate
+// usage: MatchmakerLoad [--rate 100000] [--threads 4] [--seconds 10]
+// rate is join requests per second over all threads. Skills are drawn around 1500 and latencies from 5 to 250 ms
+// A reader thread takes the pairings like a match server would. Prints the matchmaker's counters once a second and
+// exits with 1 if it fell short of the rate, dropped requests or let a request sit in the queue for over QUEUE_LIMIT_US
+
+// the worst queueing delay we accept, in microseconds
+static const float QUEUE_LIMIT_US = 10000.0f;
+
+// producers submit in small bursts, like a network thread handing over one receive batch
+static const long long BURST_NS = 1000000LL;
+
+int main(int argc, char** argv)
+{
+    int rate = 100000;
+    int threads = 4;
+    int seconds = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--rate")) {
+            rate = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--threads")) {
+            threads = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--seconds")) {
+            seconds = atoi(argv[i + 1]);
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    Matchmaker* matchmaker = new Matchmaker();
+    matchmaker->start();
+    std::atomic<bool> running(true);
+    std::atomic<unsigned long long> offered(0);
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; t++) {
+        producers.push_back(std::thread([&, t]() {
+            std::default_random_engine generator(t + 1);
+            std::normal_distribution<float> skill(1500.0f, 300.0f);
+            std::uniform_int_distribution<int> latency(5, 250);
+            double perBurst = (double)rate / threads * BURST_NS / 1000000000.0;
+            double owed = 0.0;
+            unsigned long long player = (unsigned long long)t << 40;
+            long long next = Matchmaker::now();
+            while (running.load(std::memory_order_relaxed)) {
+                owed += perBurst;
+                int burst = (int)owed;
+                owed -= burst;
+                for (int i = 0; i < burst; i++) {
+                    JoinRequest request;
+                    request.player = player++;
+                    request.skill = (int)skill(generator);
+                    request.latencyMs = latency(generator);
+                    request.submitted = Matchmaker::now();
+                    matchmaker->submit(request);
+                }
+                offered.fetch_add(burst, std::memory_order_relaxed);
+                next += BURST_NS;
+                long long wait = next - Matchmaker::now();
+                if (wait > 0) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+                }
+            }
+        }));
+    }
+
+    // how far apart the matchmaker put its pairs
+    std::atomic<unsigned long long> pairings(0), skillGap(0), latencyGap(0);
+    std::thread reader([&]() {
+        Pairing pairing;
+        unsigned long long count = 0, skills = 0, latencies = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            bool any = false;
+            while (matchmaker->nextPairing(&pairing)) {
+                count++;
+                skills += (unsigned long long)abs(pairing.players[0].skill - pairing.players[1].skill);
+                latencies += (unsigned long long)abs(pairing.players[0].latencyMs - pairing.players[1].latencyMs);
+                any = true;
+            }
+            pairings.store(count, std::memory_order_relaxed);
+            skillGap.store(skills, std::memory_order_relaxed);
+            latencyGap.store(latencies, std::memory_order_relaxed);
+            if (!any) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    });
+
+    printf("%d joins/s from %d threads for %d s\n", rate, threads, seconds);
+    MatchmakerStats last = matchmaker->stats();
+    float worstQueueUs = 0.0f;
+    unsigned long long fullRateSeconds = 0;
+    for (int second = 1; second <= seconds; second++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        MatchmakerStats now = matchmaker->stats();
+        unsigned long long joins = now.submitted - last.submitted;
+        printf("%4ds  joins %7llu/s  pairs %7llu/s  waiting %5d  queue p50 %5.0f us p99 %5.0f us max %7.0f us  wait p50 %6.1f ms p99 %6.1f ms  dropped %llu\n",
+            second, joins, now.paired - last.paired, now.waiting, now.queueP50Us, now.queueP99Us, now.queueMaxUs,
+            now.waitP50Ms, now.waitP99Ms, now.rejected);
+        // the first second includes starting the threads
+        if (second > 1 && now.queueMaxUs > worstQueueUs) {
+            worstQueueUs = now.queueMaxUs;
+        }
+        if (joins >= (unsigned long long)rate * 95 / 100) {
+            fullRateSeconds++;
+        }
+        last = now;
+    }
+
+    running.store(false);
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    reader.join();
+    MatchmakerStats totals = matchmaker->stats();
+    matchmaker->stop();
+    delete matchmaker;
+
+    unsigned long long paired = pairings.load();
+    printf("offered %llu joins, %llu taken, %llu dropped, %llu pairings read, mean gap %.0f rating points and %.0f ms\n",
+        offered.load(), totals.submitted, totals.rejected, paired,
+        paired > 0 ? (double)skillGap.load() / paired : 0.0, paired > 0 ? (double)latencyGap.load() / paired : 0.0);
+    bool passed = totals.rejected == 0 && worstQueueUs <= QUEUE_LIMIT_US && fullRateSeconds + 1 >= (unsigned long long)seconds;
+    if (!passed) {
+        printf("FAILED::MATCHMAKER::RATE_OR_QUEUE_LATENCY (worst queueing %.0f us, limit %.0f us)\n", worstQueueUs, QUEUE_LIMIT_US);
+        return 1;
+    }
+    printf("passed, worst queueing %.0f us\n", worstQueueUs);
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "../Includes/NetSession.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+// NetLoopback.cpp holds a two peer determinism check: a host and a joining player in one process, talking over loopback
+// usage: NetLoopback [--ticks 3000] [--lockstep 0|1] [--delay 3] [--latency 0] [--jitter 0] [--loss 0] [--port 27100]
+//                    [--shape uniform|normal|pareto] [--burst 1] [--reorder 0] [--duplicate 0] [--bandwidth 0] [--seed 0]
+// the network options are a LinkConditions put on both peers' packets, --seed repeats the same drops and delays
+// both peers get random key presses and play until they pass --ticks. Each hashes every tick into a chain and they
+// compare chains, the run fails (exit code 1) on any desync or if the chains did not agree up to near the last tick
+
+// longest we let the peers run, in multiples of the time --ticks should take
+static const int TIMEOUT_FACTOR = 4;
+
+int main(int argc, char** argv)
+{
+    int ticks = 3000;
+    bool lockstep = true;
+    int delay = 3;
+    LinkConditions conditions = { 0, 0, 0.0f, DELAY_UNIFORM, 1.0f, 0.0f, 0.0f, 0, 0 };
+    unsigned short port = 27100;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--ticks")) {
+            ticks = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--lockstep")) {
+            lockstep = atoi(argv[i + 1]) != 0;
+        }
+        else if (!strcmp(argv[i], "--delay")) {
+            delay = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--latency")) {
+            conditions.delayMs = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--jitter")) {
+            conditions.jitterMs = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--loss")) {
+            conditions.lossPercent = (float)atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--shape")) {
+            conditions.delayShape = !strcmp(argv[i + 1], "normal") ? DELAY_NORMAL : (!strcmp(argv[i + 1], "pareto") ? DELAY_PARETO : DELAY_UNIFORM);
+        }
+        else if (!strcmp(argv[i], "--burst")) {
+            conditions.lossBurst = (float)atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--reorder")) {
+            conditions.reorderPercent = (float)atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--duplicate")) {
+            conditions.duplicatePercent = (float)atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--bandwidth")) {
+            conditions.bandwidthKbps = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--seed")) {
+            conditions.seed = (unsigned int)strtoul(argv[i + 1], nullptr, 10);
+        }
+        else if (!strcmp(argv[i], "--port")) {
+            port = (unsigned short)atoi(argv[i + 1]);
+        }
+    }
+
+    if (!UdpSocket::startup()) {
+        return 1;
+    }
+    InputQueue hostInput, joinInput;
+    NetSession host, join;
+    host.setInputQueue(&hostInput);
+    join.setInputQueue(&joinInput);
+    host.setLockstep(lockstep, delay);
+    // a score nobody reaches, so the match outlasts the run
+    if (!host.start(NetSession::HOST, port, nullptr, 0, conditions, 1.0f, 5.0f, 1000)
+        || !join.start(NetSession::JOIN, (unsigned short)(port + 1), "127.0.0.1", port, conditions, 1.0f, 5.0f, 1000)) {
+        printf("FAILED::STARTING::LOOPBACK::PORT: %d\n", port);
+        UdpSocket::shutdown();
+        return 1;
+    }
+    const char* shapes[3] = { "uniform", "normal", "pareto" };
+    printf("%s, %d ticks, %d ms latency, %d ms %s jitter, %.1f%% loss in bursts of %.1f, %.1f%% reordered, %.1f%% duplicated, %d kbit/s, seed %u\n",
+        lockstep ? "lockstep" : "rollback", ticks, conditions.delayMs, conditions.jitterMs, shapes[conditions.delayShape % 3],
+        conditions.lossPercent, conditions.lossBurst, conditions.reorderPercent, conditions.duplicatePercent, conditions.bandwidthKbps, conditions.seed);
+
+    // each player changes direction every 20 to 300 ms, seeded so a run can be repeated
+    std::default_random_engine generator(12345);
+    std::uniform_int_distribution<int> direction(-1, 1);
+    std::uniform_int_distribution<int> wait(20, 300);
+    long long now = InputQueue::now();
+    long long hostNext = now, joinNext = now, nextReport = now + 1000000000LL;
+    long long deadline = now + (long long)ticks * TIMEOUT_FACTOR * 1000000000LL / NetSession::TICK_RATE;
+
+    NetStats hostStats, joinStats;
+    while (true) {
+        now = InputQueue::now();
+        if (now >= hostNext) {
+            hostInput.push(direction(generator), now);
+            hostNext = now + wait(generator) * 1000000LL;
+        }
+        if (now >= joinNext) {
+            joinInput.push(direction(generator), now);
+            joinNext = now + wait(generator) * 1000000LL;
+        }
+        hostStats = host.latestStats();
+        joinStats = join.latestStats();
+        if (now >= nextReport) {
+            printf("tick %u / %u, agreed up to %u / %u, desyncs %u / %u, stalls %u / %u, rtt %.1f ms\n",
+                hostStats.tick, joinStats.tick, hostStats.agreedTick, joinStats.agreedTick,
+                hostStats.desyncs, joinStats.desyncs, hostStats.stalls, joinStats.stalls, hostStats.rttMs);
+            nextReport += 1000000000LL;
+        }
+        bool done = hostStats.tick >= (unsigned int)ticks && joinStats.tick >= (unsigned int)ticks;
+        bool broken = hostStats.state > NetSession::PLAYING || joinStats.state > NetSession::PLAYING;
+        if (done || broken || now > deadline) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    // let the last hashes reach the other side before stopping (a pareto tail can take a few times the jitter)
+    std::this_thread::sleep_for(std::chrono::milliseconds(conditions.delayMs + conditions.jitterMs * 4 + LinkShim::REORDER_MAX_MS
+        + (conditions.bandwidthKbps > 0 ? LinkShim::QUEUE_LIMIT_MS : 0) + 200));
+    hostStats = host.latestStats();
+    joinStats = join.latestStats();
+    host.stop();
+    join.stop();
+    UdpSocket::shutdown();
+
+    const NetStats* both[2] = { &hostStats, &joinStats };
+    const char* names[2] = { "host", "join" };
+    for (int i = 0; i < 2; i++) {
+        const NetStats& stats = *both[i];
+        printf("%s: tick %u, chains checked %u, every tick agreed up to %u, desyncs %u, last chain %016llx at tick %u, rollbacks %u, stalls %u\n",
+            names[i], stats.tick, stats.hashesChecked, stats.agreedTick, stats.desyncs, stats.lastHash, stats.lastHashTick,
+            stats.rollbacks, stats.stalls);
+        printf("      link: %u sent, %u lost, %u over the cap, %u reordered, %u duplicated\n", stats.link.sent, stats.link.lost,
+            stats.link.queueDrops, stats.link.reordered, stats.link.duplicated);
+        printf("      input delay %d (asked %d), clock offset %.3f ms, drift %.1f ppm, transit %.1f ms, jitter %.1f ms, loss %.1f%%, ahead %.2f ticks\n",
+            stats.inputDelay, stats.wantedDelay, stats.clockOffsetMs, stats.driftPpm, stats.transitMs, stats.jitterMs, stats.lossPercent, stats.tickAdvantage);
+    }
+
+    // every tick but the last couple of seconds (not settled or still in flight when we stopped) should have agreed
+    unsigned int expected = (unsigned int)ticks > 2 * NetSession::TICK_RATE ? (unsigned int)ticks - 2 * NetSession::TICK_RATE : 0;
+    bool passed = hostStats.desyncs == 0 && joinStats.desyncs == 0
+        && hostStats.agreedTick >= expected && joinStats.agreedTick >= expected;
+    if (hostStats.lastHashTick == joinStats.lastHashTick && hostStats.lastHash != joinStats.lastHash) {
+        passed = false;
+    }
+    if (!passed) {
+        printf("FAILED::LOOPBACK::DESYNC_OR_TOO_FEW_HASHES (expected agreement up to tick %u, rerun with --seed %u for the same network)\n",
+            expected, conditions.seed);
+        return 1;
+    }
+    printf("passed, every tick up to %u agreed on both sides\n", hostStats.agreedTick < joinStats.agreedTick ? hostStats.agreedTick : joinStats.agreedTick);
+    return 0;
+}
@@ -0,0 +1,666 @@
+#include "../Includes/PongSim.hpp"
+#include "../Includes/StateRing.hpp"
+#include "../Includes/Replication.hpp"
+#include "../Includes/TimerWheel.hpp"
+#include "../Includes/Replay.hpp"
+#include "../Includes/BlockCodec.hpp"
+#include "../Includes/StateHash.hpp"
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+// PongBench.cpp holds micro benchmarks for the parts of the game that run many times a frame
+// usage: PongBench [name ...]   runs the named benchmarks, or all of them. Exits with 1 if any misses its budget
+
+// results are added in here so the compiler cannot throw the measured work away
+static volatile unsigned long long sink;
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// one rollback worth of copying: save the newest frame and restore an older one
+static bool benchSnapshot()
+{
+    const int RING = 128;
+    const int ROLLBACK = 16;
+    const long long ITERATIONS = 20000000;
+    const double BUDGET_NS = 100.0;
+
+    StateRing<PongSim, RING>* ring = new StateRing<PongSim, RING>();
+    PongSim sim;
+    sim.setTimeDelta(1.0f / 120.0f);
+    for (unsigned long long frame = 0; frame < RING; frame++) {
+        ring->save(frame, sim);
+        sim.step(sim.aiDirection(true));
+    }
+
+    PongSim restored;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long long frame = RING; frame < RING + ITERATIONS; frame++) {
+        sim.tick = frame;
+        ring->save(frame, sim);
+        ring->restore(frame - ROLLBACK, &restored);
+        sink += restored.tick;
+    }
+    double ns = secondsSince(start) * 1e9 / ITERATIONS;
+    delete ring;
+
+    printf("snapshot: %d byte state, save + restore %.1f ns (budget %.0f ns)\n", (int)sizeof(PongSim), ns, BUDGET_NS);
+    return ns < BUDGET_NS;
+}
+
+// a whole AI against AI match at the server's tick rate, quantized every tick
+static std::vector<ReplicatedState> recordMatch(unsigned int seed)
+{
+    std::vector<ReplicatedState> states;
+    PongSim sim;
+    sim.seed(seed);
+    sim.setGameParameters(1.0f, 5.0f, 10);
+    sim.setTimeDelta(1.0f / 60.0f);
+    sim.resetGame(true);
+    // the AI never misses, so cap the match at ten minutes
+    while (sim.gameStatus() == 0 && states.size() < 36000) {
+        sim.step(sim.aiDirection(true), sim.aiDirection(false));
+        states.push_back(replicate(sim));
+    }
+    return states;
+}
+
+static bool sameState(const ReplicatedState& a, const ReplicatedState& b)
+{
+    return a.tick == b.tick && a.leftBar == b.leftBar && a.rightBar == b.rightBar && a.ballX == b.ballX && a.ballY == b.ballY &&
+        a.leftScore == b.leftScore && a.rightScore == b.rightScore;
+}
+
+// bytes per tick of the state replication at different acknowledgement delays, and how fast it encodes and decodes
+static bool benchReplication()
+{
+    const double BUDGET_NS = 200.0;
+    std::vector<ReplicatedState> states = recordMatch(7);
+    int count = (int)states.size();
+    unsigned char encoded[REPLICATION_MAX_BYTES];
+
+    // the raw float packet this replaced: tick, four floats and two score bytes
+    printf("replication: %d ticks, raw floats 22.00 bytes/tick, full quantized %d bytes/tick\n", count, encodeState(nullptr, states[0], encoded));
+
+    // the base is as old as the acknowledgement delay: the round trip plus however often the player acknowledges
+    const int LAGS[] = { 1, 3, 6, 12, 24 };
+    for (int lag : LAGS) {
+        long long bytes = 0;
+        for (int i = 0; i < count; i++) {
+            bytes += encodeState(i >= lag ? &states[i - lag] : nullptr, states[i], encoded);
+        }
+        printf("replication: base %2d ticks old (%3d ms at 60 hz): %.2f bytes/tick, %.2f kbit/s per player\n",
+            lag, lag * 1000 / 60, (double)bytes / count, (double)bytes * 8 * 60 / count / 1000);
+    }
+
+    // speed: encode every tick against the one six ticks earlier, then decode them all in order
+    const int LAG = 6;
+    const int ROUNDS = 50;
+    std::vector<unsigned char> stream((size_t)count * REPLICATION_MAX_BYTES);
+    std::vector<int> lengths(count);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < count; i++) {
+            lengths[i] = encodeState(i >= LAG ? &states[i - LAG] : nullptr, states[i], &stream[(size_t)i * REPLICATION_MAX_BYTES]);
+        }
+        sink += lengths[round % count];
+    }
+    double encodeNs = secondsSince(start) * 1e9 / ((double)ROUNDS * count);
+
+    ReplicationReceiver* receiver = new ReplicationReceiver();
+    int mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        receiver->reset();
+        for (int i = 0; i < count; i++) {
+            ReplicatedState state;
+            if (!receiver->receive(&stream[(size_t)i * REPLICATION_MAX_BYTES], lengths[i], &state) || !sameState(state, states[i])) {
+                mismatches++;
+            }
+        }
+    }
+    double decodeNs = secondsSince(start) * 1e9 / ((double)ROUNDS * count);
+    delete receiver;
+
+    printf("replication: encode %.1f ns, decode %.1f ns per state (budget %.0f ns), %d mismatches\n", encodeNs, decodeNs, BUDGET_NS, mismatches);
+    return mismatches == 0 && encodeNs < BUDGET_NS && decodeNs < BUDGET_NS;
+}
+
+// the scheduler the timer wheel replaced: a binary heap, cancelling by marking the timer stale and skipping it when it
+// comes up (a heap cannot remove from the middle cheaply)
+class HeapScheduler {
+public:
+    unsigned long long schedule(unsigned long long when, unsigned long long data)
+    {
+        unsigned int index;
+        if (!freeIds.empty()) {
+            index = freeIds.back();
+            freeIds.pop_back();
+        }
+        else {
+            index = (unsigned int)generations.size();
+            generations.push_back(0);
+            live.push_back(false);
+        }
+        live[index] = true;
+        unsigned long long handle = ((unsigned long long)generations[index] << 32) | index;
+        Entry entry = { when, data, handle };
+        heap.push(entry);
+        return handle;
+    }
+
+    bool cancel(unsigned long long handle)
+    {
+        unsigned int index = (unsigned int)handle;
+        if (index >= generations.size() || !live[index] || generations[index] != (unsigned int)(handle >> 32)) {
+            return false;
+        }
+        release(index);
+        return true;
+    }
+
+    void advance(unsigned long long now, std::vector<ExpiredTimer>& fired)
+    {
+        while (!heap.empty() && heap.top().when <= now) {
+            Entry entry = heap.top();
+            heap.pop();
+            unsigned int index = (unsigned int)entry.handle;
+            if (live[index] && generations[index] == (unsigned int)(entry.handle >> 32)) {
+                ExpiredTimer expired = { entry.when, entry.data };
+                fired.push_back(expired);
+                release(index);
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        unsigned long long when, data, handle;
+        bool operator<(const Entry& other) const {
+            return when > other.when;
+        }
+    };
+    std::priority_queue<Entry> heap;
+    std::vector<unsigned int> generations;
+    std::vector<bool> live;
+    std::vector<unsigned int> freeIds;
+
+    void release(unsigned int index)
+    {
+        live[index] = false;
+        generations[index]++;
+        freeIds.push_back(index);
+    }
+};
+
+// the match server's timers at 100k pending, stepped a millisecond at a time for a few simulated seconds:
+// match ticks every 16 or 17 ms at random phases, idle timeouts pushed back (cancel and schedule again) as players'
+// packets arrive, and a one second serve delay after some ticks. Returns the timer operations done, and their time
+template <typename Scheduler>
+static unsigned long long runTimers(Scheduler& scheduler, double* seconds)
+{
+    const int PENDING = 100000;
+    const int MATCHES = PENDING * 6 / 10;
+    const int TIMEOUTS = PENDING - MATCHES;
+    const unsigned long long SIMULATED_MS = 5000;
+    const int REFRESHES_PER_MS = 400;
+    enum { MATCH_TICK, IDLE_TIMEOUT, SERVE_DELAY };
+
+    std::default_random_engine generator(3);
+    std::uniform_int_distribution<int> phase(0, 16);
+    std::uniform_int_distribution<int> player(0, TIMEOUTS - 1);
+    std::uniform_int_distribution<int> serve(0, 599);
+    std::vector<unsigned long long> timeoutHandles(TIMEOUTS);
+    std::vector<ExpiredTimer> fired;
+    fired.reserve(PENDING);
+
+    for (int i = 0; i < MATCHES; i++) {
+        scheduler.schedule(1 + phase(generator), ((unsigned long long)MATCH_TICK << 32) | i);
+    }
+    for (int i = 0; i < TIMEOUTS; i++) {
+        timeoutHandles[i] = scheduler.schedule(5000 + player(generator) % 1000, ((unsigned long long)IDLE_TIMEOUT << 32) | i);
+    }
+
+    unsigned long long operations = PENDING;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (unsigned long long now = 1; now <= SIMULATED_MS; now++) {
+        for (int i = 0; i < REFRESHES_PER_MS; i++) {
+            int index = player(generator);
+            scheduler.cancel(timeoutHandles[index]);
+            timeoutHandles[index] = scheduler.schedule(now + 5000, ((unsigned long long)IDLE_TIMEOUT << 32) | index);
+        }
+        operations += 2 * REFRESHES_PER_MS;
+
+        fired.clear();
+        scheduler.advance(now, fired);
+        for (const ExpiredTimer& timer : fired) {
+            int kind = (int)(timer.data >> 32);
+            // 60 ticks a second is 16.67 ms: two 17 ms gaps for every 16 ms one
+            unsigned long long next = timer.when + (timer.when % 3 == 0 ? 16 : 17);
+            if (kind == MATCH_TICK && serve(generator) == 0) {
+                scheduler.schedule(timer.when + 1000, ((unsigned long long)SERVE_DELAY << 32) | (timer.data & 0xFFFFFFFFu));
+            }
+            else if (kind == MATCH_TICK || kind == SERVE_DELAY) {
+                scheduler.schedule(next, ((unsigned long long)MATCH_TICK << 32) | (timer.data & 0xFFFFFFFFu));
+            }
+            else {
+                // a player nobody heard from, a fresh one takes their place
+                int index = (int)(timer.data & 0xFFFFFFFFu);
+                timeoutHandles[index] = scheduler.schedule(timer.when + 5000, timer.data);
+            }
+            operations += 2;
+            sink += timer.data;
+        }
+    }
+    *seconds = secondsSince(start);
+    return operations;
+}
+
+// timer wheel against a binary heap at 100k pending timers
+static bool benchTimers()
+{
+    const double BUDGET_NS = 50.0;
+
+    TimerWheel* wheel = new TimerWheel();
+    double wheelSeconds;
+    unsigned long long operations = runTimers(*wheel, &wheelSeconds);
+    int pending = wheel->pending();
+    delete wheel;
+
+    HeapScheduler* heap = new HeapScheduler();
+    double heapSeconds;
+    runTimers(*heap, &heapSeconds);
+    delete heap;
+
+    double wheelNs = wheelSeconds * 1e9 / operations;
+    double heapNs = heapSeconds * 1e9 / operations;
+    printf("timers: %d pending, %llu schedules, cancels and expiries\n", pending, operations);
+    printf("timers: wheel %.1f ns, priority_queue %.1f ns per operation (%.1fx, budget %.0f ns)\n", wheelNs, heapNs, heapNs / wheelNs, BUDGET_NS);
+    return wheelNs < BUDGET_NS && wheelNs < heapNs;
+}
+
+// records an AI driven match the way the game does it, returning the live match and the input it was stepped with
+// the left bar is a player who chases the ball, reacting a few times a second at any point inside a tick
+// bytes is the size of the file, and rawBytes what it would be without compression (less the block headers)
+static bool recordReplay(const char* path, const ReplayHeader& header, int ticks, bool compress, PongSim* live,
+    std::vector<TickInput>* inputs, unsigned long long* bytes, unsigned long long* rawBytes = nullptr)
+{
+    std::default_random_engine generator(7);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    startReplayMatch(*live, header);
+    ReplayWriter writer;
+    if (!writer.open(path)) {
+        printf("replay: could not create %s\n", path);
+        return false;
+    }
+    writer.setCompression(compress);
+    writer.begin(header);
+    int held = 0;
+    int games = 0;
+    for (int i = 0; i < ticks; i++) {
+        TickInput input = TickInput::constant(held);
+        int wanted = live->aiDirection(true);
+        if (wanted != held && uniform(generator) < 0.08f) {
+            input.changeCount = 1;
+            input.changeOffsets[0] = uniform(generator) * live->timeDelta;
+            input.changes[0] = wanted;
+            held = wanted;
+        }
+        if (live->gameStatus() != 0) {
+            // every other match on other settings, recorded before the reset like SimThread does, so playback and
+            // seeking are checked across settings changes too
+            games++;
+            float ballSpeed = games % 2 == 0 ? header.ballSpeed : header.ballSpeed * 1.5f;
+            float barSpeed = games % 2 == 0 ? header.barSpeed : header.barSpeed - 1.0f;
+            live->setGameParameters(ballSpeed, barSpeed, header.maxScore);
+            writer.settings(ballSpeed, barSpeed, header.maxScore);
+            writer.reset();
+            live->resetGame(true);
+        }
+        writer.recordTick(input, *live);
+        if (inputs != nullptr) {
+            inputs->push_back(input);
+        }
+        live->step(input, live->aiDirection(false));
+    }
+    writer.result(*live);
+    writer.finish();
+    *bytes = writer.fileBytes();
+    if (rawBytes != nullptr) {
+        *rawBytes = writer.bytes();
+    }
+    return true;
+}
+
+// a ten minute match recorded, then played back from the file
+static bool benchReplay()
+{
+    const int TICK_RATE = 120;
+    const int MATCH_TICKS = TICK_RATE * 60 * 10;
+    const int REPEATS = 20;
+    const double BUDGET_NS = 100.0;
+    const unsigned long long BUDGET_BYTES = 8192;
+    const char* path = "PongBench.replay";
+
+    ReplayHeader header = { TICK_RATE, 1234, 1.0f, 5.0f, 10 };
+    PongSim live;
+    std::vector<TickInput> inputs;
+    unsigned long long bytes, rawBytes;
+    if (!recordReplay(path, header, MATCH_TICKS, true, &live, &inputs, &bytes, &rawBytes)) {
+        return false;
+    }
+
+    ReplayReader reader;
+    PongSim replayed;
+    if (!reader.open(path)) {
+        printf("replay: could not read %s back\n", path);
+        return false;
+    }
+    reader.start(replayed);
+    while (reader.step(replayed)) {
+    }
+    bool same = reader.complete() && !reader.diverged() && reader.tick() == (unsigned long long)MATCH_TICKS &&
+        replayed.stateHash() == live.stateHash();
+    size_t keyframes = reader.index().size();
+    size_t keyframeBytes = keyframes * (1 + 1 + PongSim::STATE_BYTES + 8);
+
+    // the cost on the simulation thread, recording the same input again while the writer thread saves it
+    double seconds = 0.0;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        ReplayWriter timed;
+        timed.open(path);
+        timed.begin(header);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (TickInput& input : inputs) {
+            timed.recordTick(input, live);
+        }
+        seconds += secondsSince(start);
+        timed.finish();
+    }
+    double ns = seconds * 1e9 / ((double)REPEATS * MATCH_TICKS);
+    remove(path);
+
+    printf("replay: %d s match in %llu bytes (budget %llu), %llu before compression of which %llu input and %d keyframes, played back %s\n",
+        MATCH_TICKS / TICK_RATE, bytes, BUDGET_BYTES, rawBytes, rawBytes - keyframeBytes, (int)keyframes, same ? "identically" : "DIFFERENTLY");
+    printf("replay: recording %.1f ns per tick (budget %.0f ns)\n", ns, BUDGET_NS);
+    return same && bytes <= BUDGET_BYTES && ns < BUDGET_NS;
+}
+
+// random jumps around an hour long replay, each checked against playing the match straight through
+static bool benchSeek()
+{
+    const int TICK_RATE = 120;
+    const int MATCH_TICKS = TICK_RATE * 60 * 60;
+    const int SEEKS = 2000;
+    const int ROUNDS = 3;
+    const double BUDGET_US = 1000.0;
+    const char* path = "PongBench.replay";
+
+    ReplayHeader header = { TICK_RATE, 99, 1.0f, 5.0f, 10 };
+    PongSim live;
+    unsigned long long bytes;
+    if (!recordReplay(path, header, MATCH_TICKS, true, &live, nullptr, &bytes)) {
+        return false;
+    }
+
+    // the state at the start of every tick, played straight through
+    std::vector<unsigned long long> hashes;
+    hashes.reserve(MATCH_TICKS + 1);
+    ReplayReader straight;
+    PongSim played;
+    if (!straight.open(path)) {
+        printf("seek: could not read %s back\n", path);
+        return false;
+    }
+    straight.start(played);
+    do {
+        hashes.push_back(played.stateHash());
+    } while (straight.step(played));
+
+    std::default_random_engine generator(3);
+    std::uniform_int_distribution<int> target(0, MATCH_TICKS);
+    std::vector<unsigned long long> targets(SEEKS);
+    for (unsigned long long& tick : targets) {
+        tick = (unsigned long long)target(generator);
+    }
+
+    // the same seeks in the same order several times over, so each does the same work every round, and the best round
+    // of each is its time. A thread swapped out halfway through a seek then does not count as a slow seek
+    std::vector<double> seekUs(SEEKS, 1e9);
+    double openUs = 0.0;
+    int wrong = 0;
+    unsigned long long length = 0;
+    size_t keyframes = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        std::chrono::steady_clock::time_point opening = std::chrono::steady_clock::now();
+        ReplayReader reader;
+        reader.open(path);
+        openUs = round == 0 ? secondsSince(opening) * 1e6 : openUs;
+        length = reader.length();
+        keyframes = reader.index().size();
+        PongSim sim;
+        for (int i = 0; i < SEEKS; i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool reached = reader.seek(sim, targets[i]);
+            double us = secondsSince(start) * 1e6;
+            seekUs[i] = us < seekUs[i] ? us : seekUs[i];
+            if (!reached || sim.stateHash() != hashes[targets[i]]) {
+                wrong++;
+            }
+        }
+    }
+    remove(path);
+    double totalUs = 0.0, worstUs = 0.0;
+    for (double us : seekUs) {
+        totalUs += us;
+        worstUs = us > worstUs ? us : worstUs;
+    }
+
+    printf("seek: %d minute replay of %llu ticks in %llu bytes with %d keyframes, opened in %.0f us\n", MATCH_TICKS / TICK_RATE / 60,
+        length, bytes, (int)keyframes, openUs);
+    printf("seek: %d seeks, mean %.1f us, worst %.1f us (budget %.0f us), %d wrong states\n", SEEKS, totalUs / SEEKS, worstUs, BUDGET_US, wrong);
+    return wrong == 0 && length == (unsigned long long)MATCH_TICKS && worstUs < BUDGET_US;
+}
+
+// plays a replay straight through and seeks around it, for comparing the same match compressed and stored
+static bool playReplay(const char* path, int seeks, double* playNs, double* seekUs, unsigned long long* hash)
+{
+    ReplayReader reader;
+    PongSim sim;
+    if (!reader.open(path)) {
+        return false;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    reader.start(sim);
+    while (reader.step(sim)) {
+    }
+    *playNs = secondsSince(start) * 1e9 / (double)reader.tick();
+    *hash = sim.stateHash();
+    bool clean = reader.complete() && !reader.diverged();
+
+    std::default_random_engine generator(5);
+    std::uniform_int_distribution<unsigned long long> target(0, reader.length());
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < seeks; i++) {
+        clean = reader.seek(sim, target(generator)) && clean;
+        sink += sim.stateHash();
+    }
+    *seekUs = secondsSince(start) * 1e6 / seeks;
+    return clean;
+}
+
+// the block codec on an hour long replay: how much smaller the file gets, and what reading it back costs
+static bool benchCodec()
+{
+    const int TICK_RATE = 120;
+    const int MATCH_TICKS = TICK_RATE * 60 * 60;
+    const int SEEKS = 2000;
+    const int DECODE_REPEATS = 50;
+    const double BUDGET_RATIO = 0.75;
+    const double BUDGET_DECODE_MBS = 10.0;
+    const double BUDGET_PLAY_SLOWDOWN = 2.0;
+    const char* compressedPath = "PongBench.replay";
+    const char* storedPath = "PongBenchStored.replay";
+
+    ReplayHeader header = { TICK_RATE, 4321, 1.0f, 5.0f, 10 };
+    PongSim live;
+    unsigned long long compressedBytes, storedBytes, rawBytes;
+    if (!recordReplay(compressedPath, header, MATCH_TICKS, true, &live, nullptr, &compressedBytes, &rawBytes) ||
+        !recordReplay(storedPath, header, MATCH_TICKS, false, &live, nullptr, &storedBytes)) {
+        return false;
+    }
+
+    double compressedPlayNs, storedPlayNs, compressedSeekUs, storedSeekUs;
+    unsigned long long compressedHash, storedHash;
+    bool played = playReplay(compressedPath, SEEKS, &compressedPlayNs, &compressedSeekUs, &compressedHash) &&
+        playReplay(storedPath, SEEKS, &storedPlayNs, &storedSeekUs, &storedHash);
+    bool same = played && compressedHash == storedHash && compressedHash == live.stateHash();
+
+    // the codec alone, on the stored file cut into pieces the size of an average block
+    std::vector<unsigned char> raw;
+    FILE* stored = fopen(storedPath, "rb");
+    if (stored != nullptr) {
+        raw.resize((size_t)storedBytes);
+        raw.resize(fread(raw.data(), 1, raw.size(), stored));
+        fclose(stored);
+    }
+    remove(compressedPath);
+    remove(storedPath);
+    int blocks = MATCH_TICKS / (REPLAY_KEYFRAME_TICKS * REPLAY_BLOCK_KEYFRAMES) + 1;
+    size_t blockSize = raw.size() / blocks;
+    std::vector<std::vector<unsigned char>> packed(blocks);
+    for (int i = 0; i < blocks; i++) {
+        size_t size = i + 1 < blocks ? blockSize : raw.size() - blockSize * i;
+        compressBlock(raw.data() + blockSize * i, size, &packed[i]);
+    }
+    std::vector<unsigned char> decoded(raw.size());
+    bool decodes = !raw.empty();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int repeat = 0; repeat < DECODE_REPEATS; repeat++) {
+        for (int i = 0; i < blocks; i++) {
+            size_t size = i + 1 < blocks ? blockSize : raw.size() - blockSize * i;
+            decodes = decompressBlock(packed[i].data(), packed[i].size(), decoded.data() + blockSize * i, size) && decodes;
+        }
+    }
+    double decodeMbs = (double)raw.size() * DECODE_REPEATS / secondsSince(start) / 1e6;
+    decodes = decodes && decoded == raw;
+
+    double ratio = (double)compressedBytes / (double)storedBytes;
+    double slowdown = compressedPlayNs / storedPlayNs;
+    printf("codec: %d minute replay %llu bytes compressed, %llu stored (%llu of records), ratio %.3f (budget %.2f), played back %s\n",
+        MATCH_TICKS / TICK_RATE / 60, compressedBytes, storedBytes, rawBytes, ratio, BUDGET_RATIO, same ? "identically" : "DIFFERENTLY");
+    printf("codec: %d blocks of about %d bytes decoded at %.0f MB/s (budget %.0f MB/s)%s\n", blocks, (int)blockSize, decodeMbs, BUDGET_DECODE_MBS,
+        decodes ? "" : ", DECODED WRONG");
+    printf("codec: playback %.1f ns per tick compressed, %.1f stored (%.2fx, budget %.2fx), seeks %.1f us compressed, %.1f us stored\n",
+        compressedPlayNs, storedPlayNs, slowdown, BUDGET_PLAY_SLOWDOWN, compressedSeekUs, storedSeekUs);
+    return same && decodes && ratio <= BUDGET_RATIO && decodeMbs >= BUDGET_DECODE_MBS && slowdown <= BUDGET_PLAY_SLOWDOWN;
+}
+
+// the fnv-1a the state hash used to be, over the same words, to compare with
+static unsigned long long fnvWords(const unsigned long long* words, int count)
+{
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    const unsigned char* bytes = (const unsigned char*)words;
+    for (size_t i = 0; i < count * sizeof(unsigned long long); i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// the state hash taken every tick: what it costs next to the tick itself, and that it notices any one bit changing
+static bool benchHash()
+{
+    const int TICKS = 2000000;
+    const int STATES = 1000;
+    const double BUDGET_NS = 50.0;
+
+    PongSim sim;
+    sim.setTimeDelta(1.0f / 120.0f);
+    sim.seed(11);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TICKS; i++) {
+        sim.step(sim.aiDirection(true));
+    }
+    double stepNs = secondsSince(start) * 1e9 / TICKS;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TICKS; i++) {
+        sim.step(sim.aiDirection(true));
+        sink += sim.stateHash();
+    }
+    double hashNs = secondsSince(start) * 1e9 / TICKS - stepNs;
+
+    // the bare hashes over states the sim went through
+    std::vector<unsigned long long> words(STATES * PongSim::STATE_HASH_WORDS);
+    std::default_random_engine generator(17);
+    for (unsigned long long& word : words) {
+        word = ((unsigned long long)generator() << 32) ^ generator();
+    }
+    const int REPEATS = 2000;
+    unsigned long long (*const hashes[])(const unsigned long long*, int) = { hashWords, hashWordsScalar, fnvWords };
+    double ns[3];
+    for (int h = 0; h < 3; h++) {
+        start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < REPEATS; repeat++) {
+            for (int i = 0; i < STATES; i++) {
+                sink += hashes[h](&words[i * PongSim::STATE_HASH_WORDS], PongSim::STATE_HASH_WORDS);
+            }
+        }
+        ns[h] = secondsSince(start) * 1e9 / ((double)REPEATS * STATES);
+    }
+
+    // both paths agree, and flipping any single bit of a state changes its hash
+    int disagreements = 0, missed = 0;
+    for (int i = 0; i < STATES; i++) {
+        unsigned long long* state = &words[i * PongSim::STATE_HASH_WORDS];
+        unsigned long long hash = hashWords(state, PongSim::STATE_HASH_WORDS);
+        disagreements += hash != hashWordsScalar(state, PongSim::STATE_HASH_WORDS);
+        for (int bit = 0; bit < PongSim::STATE_HASH_WORDS * 64; bit++) {
+            state[bit / 64] ^= 1ULL << (bit % 64);
+            missed += hashWords(state, PongSim::STATE_HASH_WORDS) == hash;
+            state[bit / 64] ^= 1ULL << (bit % 64);
+        }
+    }
+
+    printf("hash: %s, %.1f ns a state (scalar %.1f ns, fnv-1a %.1f ns), %d disagreements, %d of %d single bit flips missed\n",
+        STATE_HASH_SIMD ? "sse2" : "scalar", ns[0], ns[1], ns[2], disagreements, missed, STATES * PongSim::STATE_HASH_WORDS * 64);
+    printf("hash: stateHash() every tick adds %.1f ns to a %.1f ns tick (budget %.0f ns)\n", hashNs, stepNs, BUDGET_NS);
+    return disagreements == 0 && missed == 0 && hashNs < BUDGET_NS;
+}
+
+struct Benchmark {
+    const char* name;
+    bool (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+    { "snapshot", benchSnapshot },
+    { "replication", benchReplication },
+    { "timers", benchTimers },
+    { "replay", benchReplay },
+    { "seek", benchSeek },
+    { "codec", benchCodec },
+    { "hash", benchHash },
+};
+
+int main(int argc, char** argv)
+{
+    bool passed = true;
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], benchmark.name)) {
+                selected = true;
+            }
+        }
+        if (selected && !benchmark.run()) {
+            printf("FAILED::BENCHMARK::OVER_BUDGET: %s\n", benchmark.name);
+            passed = false;
+        }
+    }
+    return passed ? 0 : 1;
+}
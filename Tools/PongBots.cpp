@@ -0,0 +1,416 @@
+#include "../Includes/UdpSocket.hpp"
+#include "../Includes/ServerProtocol.hpp"
+#include "../Includes/Meshes.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+// PongBots.cpp holds a load generator for the match server: thousands of players that join and play like the AI
+// usage: PongBots [--host 127.0.0.1] [--port 27016] [--matches 10000] [--threads 4] [--sockets 16] [--seconds 30] [--ack 6]
+//                 [--spectators 0] [--popular 4]
+// matches * 2 bots are spread over threads * sockets sockets, many bots to a socket. Finished matches are joined again
+// each bot acknowledges every ack-th state it decodes, the server deltas against the newest acknowledged one
+// spectators are spread over the same sockets and all watch the first popular matches of each shard. Every
+// SLOW_EVERY-th spectator is slow and only acknowledges every SLOW_ACK_NS, so the server falls back to keyframes for it
+
+// a bot that has not been welcomed asks again after this long
+static const long long JOIN_RETRY_NS = 500000000LL;
+
+// a bot whose direction has not changed still tells the server it is alive this often
+static const long long KEEPALIVE_NS = 1000000000LL;
+
+// how often each thread looks over all its bots for joins and keepalives
+static const long long MAINTENANCE_NS = 10000000LL;
+
+// how often a spectator acknowledges the newest broadcast state, and how often a slow one does
+static const long long SPECTATOR_ACK_NS = 100000000LL;
+static const long long SLOW_ACK_NS = 2000000000LL;
+static const int SLOW_EVERY = 4;
+
+struct Bot {
+    int side;
+    bool joined;
+    signed char direction;
+    long long lastSent;
+    ReplicationReceiver receiver;
+    int sinceAck;
+};
+
+struct Watcher {
+    bool watching;
+    bool slow;
+    unsigned int match;
+    long long lastSent;
+};
+
+// the broadcasts of one match as seen on one socket, every spectator of that match on the socket shares them
+struct Feed {
+    ReplicationReceiver receiver;
+    unsigned int newest;
+    bool any;
+
+    Feed() : newest(0), any(false) {}
+};
+
+// totals over every thread, read by the main thread once a second
+struct BotCounters {
+    std::atomic<int> joined;
+    std::atomic<unsigned long long> states;
+    std::atomic<unsigned long long> stateBytes;
+    std::atomic<unsigned long long> undecodable;
+    std::atomic<unsigned long long> inputs;
+    std::atomic<unsigned long long> finished;
+    std::atomic<int> watching;
+    std::atomic<unsigned long long> broadcasts, broadcastBytes, keyframes, broadcastUndecodable;
+
+    BotCounters() : joined(0), states(0), stateBytes(0), undecodable(0), inputs(0), finished(0),
+        watching(0), broadcasts(0), broadcastBytes(0), keyframes(0), broadcastUndecodable(0) {}
+};
+
+static long long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// value is the direction of an INPUT, the tick of an ACK or the match of a WATCH
+static void sendPacket(DatagramBatch& batch, UdpSocket& socket, const NetAddress& server, int type, unsigned short id, int value)
+{
+    unsigned char packet[SERVER_PACKET_SIZE];
+    unsigned char* out = writeServerHeader(packet, type, id);
+    if (type == SERVER_INPUT) {
+        writeU8(out, (unsigned char)(signed char)value);
+    }
+    else if (type == SERVER_ACK || type == SERVER_WATCH) {
+        writeU32(out, (unsigned int)value);
+    }
+    batch.queue(socket, server, packet, (int)(out - packet));
+}
+
+// move the bar towards the ball, with a dead zone so it does not jitter
+static int chooseDirection(float barY, float ballY)
+{
+    float barCenter = barY - BAR_HEIGHT / 2.0f;
+    float ballCenter = ballY - BALL_SIZE / 2.0f;
+    if (ballCenter > barCenter + 0.05f) {
+        return 1;
+    }
+    if (ballCenter < barCenter - 0.05f) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+    One thread's worth of bots. Bot i uses socket i % socketCount and player id i, ids only need to be unique per socket
+    Spectator j uses socket j % socketCount and id botCount + j
+*/
+static void runBots(NetAddress server, int botCount, int watcherCount, int popular, int socketCount, int ackInterval, long long end, BotCounters* counters)
+{
+    std::vector<UdpSocket> sockets(socketCount);
+    std::vector<DatagramBatch> batches(socketCount);
+    for (int s = 0; s < socketCount; s++) {
+        if (!sockets[s].open(0)) {
+            return;
+        }
+    }
+    std::vector<Bot> bots(botCount);
+    for (Bot& bot : bots) {
+        bot.side = 0;
+        bot.joined = false;
+        bot.direction = 0;
+        bot.lastSent = 0;
+        bot.sinceAck = 0;
+    }
+    std::vector<Watcher> watchers(watcherCount);
+    for (int j = 0; j < watcherCount; j++) {
+        watchers[j].watching = false;
+        watchers[j].slow = j % SLOW_EVERY == SLOW_EVERY - 1;
+        watchers[j].match = 0;
+        watchers[j].lastSent = 0;
+    }
+    std::vector<std::unordered_map<unsigned int, Feed> > feeds(socketCount);
+
+    long long lastMaintenance = 0;
+    while (true) {
+        long long now = nowNs();
+        if (now >= end) {
+            break;
+        }
+        bool received = false;
+        for (int s = 0; s < socketCount; s++) {
+            int count;
+            do {
+                count = batches[s].receive(sockets[s]);
+                for (int i = 0; i < count; i++) {
+                    const unsigned char* in = batches[s].data(i);
+                    int length = batches[s].length(i);
+                    int type;
+                    unsigned short id;
+                    if (!readServerHeader(in, length, &type, &id)) {
+                        continue;
+                    }
+                    if (type == SERVER_BROADCAST && length >= SERVER_HEADER_SIZE + 4) {
+                        unsigned int match = readU32(in);
+                        std::unordered_map<unsigned int, Feed>::iterator feed = feeds[s].find(match);
+                        if (feed == feeds[s].end()) {
+                            continue;
+                        }
+                        counters->broadcasts.fetch_add(1, std::memory_order_relaxed);
+                        counters->broadcastBytes.fetch_add(length, std::memory_order_relaxed);
+                        // a full state starts with a clear bit (bits are packed from the lowest up)
+                        if ((in[0] & 1) == 0) {
+                            counters->keyframes.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        ReplicatedState state;
+                        if (!feed->second.receiver.receive(in, length - SERVER_HEADER_SIZE - 4, &state)) {
+                            counters->broadcastUndecodable.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        if (!feed->second.any || state.tick > feed->second.newest) {
+                            feed->second.newest = state.tick;
+                            feed->second.any = true;
+                        }
+                        continue;
+                    }
+                    if (id >= botCount) {
+                        if (id - botCount >= watcherCount) {
+                            continue;
+                        }
+                        Watcher& watcher = watchers[id - botCount];
+                        if (type == SERVER_WATCHING && length >= SERVER_HEADER_SIZE + 4 && !watcher.watching) {
+                            watcher.match = readU32(in);
+                            watcher.watching = true;
+                            feeds[s][watcher.match];
+                            counters->watching.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        else if (type == SERVER_END && watcher.watching) {
+                            // the match slot will be reused by another match, whose ticks start again
+                            watcher.watching = false;
+                            watcher.lastSent = 0;
+                            feeds[s].erase(watcher.match);
+                            counters->watching.fetch_sub(1, std::memory_order_relaxed);
+                        }
+                        continue;
+                    }
+                    Bot& bot = bots[id];
+                    if (type == SERVER_WELCOME && length >= SERVER_HEADER_SIZE + 1 && !bot.joined) {
+                        bot.side = readU8(in);
+                        bot.joined = true;
+                        bot.receiver.reset();
+                        bot.sinceAck = 0;
+                        counters->joined.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else if (type == SERVER_STATE && bot.joined) {
+                        ReplicatedState state;
+                        counters->stateBytes.fetch_add(length, std::memory_order_relaxed);
+                        if (!bot.receiver.receive(in, length - SERVER_HEADER_SIZE, &state)) {
+                            counters->undecodable.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        counters->states.fetch_add(1, std::memory_order_relaxed);
+                        if (++bot.sinceAck >= ackInterval) {
+                            bot.sinceAck = 0;
+                            sendPacket(batches[s], sockets[s], server, SERVER_ACK, id, (int)state.tick);
+                        }
+                        unsigned short barY = bot.side == 0 ? state.leftBar : state.rightBar;
+                        int direction = chooseDirection(dequantizePosition(barY), dequantizePosition(state.ballY));
+                        if (direction != bot.direction) {
+                            bot.direction = (signed char)direction;
+                            bot.lastSent = now;
+                            sendPacket(batches[s], sockets[s], server, SERVER_INPUT, id, direction);
+                            counters->inputs.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                    else if (type == SERVER_END && bot.joined) {
+                        // join again straight away so the load stays constant
+                        bot.joined = false;
+                        bot.direction = 0;
+                        bot.lastSent = 0;
+                        counters->joined.fetch_sub(1, std::memory_order_relaxed);
+                        if (bot.side == 0) {
+                            counters->finished.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
+                received = received || count > 0;
+            } while (count == DatagramBatch::SIZE);
+        }
+
+        if (now - lastMaintenance >= MAINTENANCE_NS) {
+            lastMaintenance = now;
+            for (int i = 0; i < botCount; i++) {
+                Bot& bot = bots[i];
+                int s = i % socketCount;
+                if (!bot.joined && now - bot.lastSent >= JOIN_RETRY_NS) {
+                    bot.lastSent = now;
+                    sendPacket(batches[s], sockets[s], server, SERVER_JOIN, (unsigned short)i, 0);
+                }
+                else if (bot.joined && now - bot.lastSent >= KEEPALIVE_NS) {
+                    bot.lastSent = now;
+                    sendPacket(batches[s], sockets[s], server, SERVER_INPUT, (unsigned short)i, bot.direction);
+                }
+            }
+            for (int j = 0; j < watcherCount; j++) {
+                Watcher& watcher = watchers[j];
+                int s = j % socketCount;
+                unsigned short id = (unsigned short)(botCount + j);
+                if (!watcher.watching && now - watcher.lastSent >= JOIN_RETRY_NS) {
+                    watcher.lastSent = now;
+                    sendPacket(batches[s], sockets[s], server, SERVER_WATCH, id, j % popular);
+                }
+                else if (watcher.watching && now - watcher.lastSent >= (watcher.slow ? SLOW_ACK_NS : SPECTATOR_ACK_NS)) {
+                    watcher.lastSent = now;
+                    std::unordered_map<unsigned int, Feed>::iterator feed = feeds[s].find(watcher.match);
+                    if (feed != feeds[s].end() && feed->second.any) {
+                        sendPacket(batches[s], sockets[s], server, SERVER_ACK, id, (int)feed->second.newest);
+                    }
+                }
+            }
+        }
+
+        for (int s = 0; s < socketCount; s++) {
+            batches[s].flush(sockets[s]);
+        }
+        if (!received) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    // give the matches back instead of leaving the server to time them out
+    for (int i = 0; i < botCount; i++) {
+        if (bots[i].joined) {
+            int s = i % socketCount;
+            sendPacket(batches[s], sockets[s], server, SERVER_LEAVE, (unsigned short)i, 0);
+        }
+    }
+    for (int j = 0; j < watcherCount; j++) {
+        if (watchers[j].watching) {
+            int s = j % socketCount;
+            sendPacket(batches[s], sockets[s], server, SERVER_LEAVE, (unsigned short)(botCount + j), 0);
+        }
+    }
+    for (int s = 0; s < socketCount; s++) {
+        batches[s].flush(sockets[s]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* host = "127.0.0.1";
+    unsigned short port = SERVER_PORT;
+    int matches = 10000;
+    int threads = 4;
+    int socketsPerThread = 16;
+    int seconds = 30;
+    int ackInterval = 6;
+    int spectators = 0;
+    int popular = 4;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--host")) {
+            host = argv[i + 1];
+        }
+        else if (!strcmp(argv[i], "--port")) {
+            port = (unsigned short)atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--matches")) {
+            matches = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--threads")) {
+            threads = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--sockets")) {
+            socketsPerThread = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--seconds")) {
+            seconds = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--ack")) {
+            ackInterval = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--spectators")) {
+            spectators = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--popular")) {
+            popular = atoi(argv[i + 1]);
+        }
+    }
+    if (matches < 1 || threads < 1 || socketsPerThread < 1 || ackInterval < 1 || spectators < 0 || popular < 1) {
+        printf("FAILED::BOTS::BAD_ARGUMENTS\n");
+        return 1;
+    }
+
+    if (!UdpSocket::startup()) {
+        return 1;
+    }
+    NetAddress server;
+    if (!NetAddress::resolve(host, port, &server)) {
+        UdpSocket::shutdown();
+        return 1;
+    }
+
+    // bots and spectators per thread must fit in the 16 bit player id
+    int players = matches * 2;
+    int perThread = (players + threads - 1) / threads;
+    int watchersPerThread = (spectators + threads - 1) / threads;
+    if (perThread + watchersPerThread > 65535) {
+        printf("FAILED::BOTS::TOO_MANY_PER_THREAD: %d\n", perThread + watchersPerThread);
+        UdpSocket::shutdown();
+        return 1;
+    }
+
+    BotCounters counters;
+    long long end = nowNs() + seconds * 1000000000LL;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        int count = std::min(perThread, players - t * perThread);
+        int watcherCount = std::max(0, std::min(watchersPerThread, spectators - t * watchersPerThread));
+        if (count > 0) {
+            workers.push_back(std::thread(runBots, server, count, watcherCount, popular, socketsPerThread, ackInterval, end, &counters));
+        }
+    }
+    printf("%d bots for %d matches on %d threads\n", players, matches, (int)workers.size());
+    if (spectators > 0) {
+        printf("%d spectators watching %d matches per shard\n", spectators, popular);
+    }
+
+    unsigned long long lastStates = 0;
+    unsigned long long lastBytes = 0;
+    unsigned long long lastInputs = 0;
+    unsigned long long lastBroadcasts = 0;
+    unsigned long long lastKeyframes = 0;
+    for (int elapsed = 1; elapsed <= seconds; elapsed++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        unsigned long long states = counters.states.load(std::memory_order_relaxed);
+        unsigned long long bytes = counters.stateBytes.load(std::memory_order_relaxed);
+        unsigned long long inputs = counters.inputs.load(std::memory_order_relaxed);
+        // state packet payload per tick, header included
+        double perState = states > lastStates ? (double)(bytes - lastBytes) / (states - lastStates) : 0.0;
+        printf("%4ds  playing %6d  states %8llu/s (%.2f bytes each)  inputs %7llu/s  undecodable %llu  finished %llu\n", elapsed,
+            counters.joined.load(std::memory_order_relaxed), states - lastStates, perState, inputs - lastInputs,
+            counters.undecodable.load(std::memory_order_relaxed), counters.finished.load(std::memory_order_relaxed));
+        if (spectators > 0) {
+            unsigned long long broadcasts = counters.broadcasts.load(std::memory_order_relaxed);
+            unsigned long long keyframes = counters.keyframes.load(std::memory_order_relaxed);
+            printf("       watching %6d  broadcasts %8llu/s (%llu keyframes)  undecodable %llu\n",
+                counters.watching.load(std::memory_order_relaxed), broadcasts - lastBroadcasts, keyframes - lastKeyframes,
+                counters.broadcastUndecodable.load(std::memory_order_relaxed));
+            lastBroadcasts = broadcasts;
+            lastKeyframes = keyframes;
+        }
+        fflush(stdout);
+        lastStates = states;
+        lastBytes = bytes;
+        lastInputs = inputs;
+    }
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    UdpSocket::shutdown();
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "../Includes/MatchServer.hpp"
+#include "../Includes/UdpSocket.hpp"
+#include "../Includes/ServerProtocol.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+// PongServer.cpp holds the entry point of the headless match server
+// usage: PongServer [--port 27016] [--shards n] [--seconds n] [--ball speed] [--paddle speed] [--score max]
+// shards defaults to one per core and seconds to running until ctrl-c. Prints the server's counters once a second
+
+static std::atomic<bool> running(true);
+
+static void handleSignal(int)
+{
+    running.store(false);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned short port = SERVER_PORT;
+    int shards = 0;
+    int seconds = 0;
+    float ballSpeed = 1.0f;
+    float barSpeed = 5.0f;
+    int maxScore = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--port")) {
+            port = (unsigned short)atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--shards")) {
+            shards = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--seconds")) {
+            seconds = atoi(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--ball")) {
+            ballSpeed = (float)atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--paddle")) {
+            barSpeed = (float)atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--score")) {
+            maxScore = atoi(argv[i + 1]);
+        }
+    }
+
+    if (!UdpSocket::startup()) {
+        return 1;
+    }
+    MatchServer server;
+    if (!server.start(port, shards, ballSpeed, barSpeed, maxScore)) {
+        printf("FAILED::STARTING::SERVER::PORT: %d\n", port);
+        UdpSocket::shutdown();
+        return 1;
+    }
+    std::signal(SIGINT, handleSignal);
+    printf("serving on port %d with %d shards\n", port, server.shardCount());
+
+    ServerStats last = server.stats();
+    for (int elapsed = 1; running.load() && (seconds == 0 || elapsed <= seconds); elapsed++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        ServerStats now = server.stats();
+        printf("%4ds  matches %6d  players %6d  in %8llu/s  out %8llu/s %7llu KB/s  match ticks %6llu/s  worst tick %6.2f ms  finished %llu\n",
+            elapsed, now.matches, now.players, now.packetsIn - last.packetsIn, now.packetsOut - last.packetsOut,
+            (now.bytesOut - last.bytesOut) / 1024, now.ticks - last.ticks, now.worstTickMs, now.matchesFinished);
+        if (now.spectators > 0 || now.broadcastFrames > last.broadcastFrames) {
+            // each broadcast state is encoded once and the same bytes go to every spectator
+            printf("       spectators %6d  broadcast states %7llu/s  sent %8llu/s  held back %7llu/s\n", now.spectators,
+                now.broadcastFrames - last.broadcastFrames, now.broadcastPackets - last.broadcastPackets,
+                now.broadcastSkipped - last.broadcastSkipped);
+        }
+        fflush(stdout);
+        last = now;
+    }
+
+    server.stop();
+    UdpSocket::shutdown();
+    return 0;
+}
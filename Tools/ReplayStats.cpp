@@ -0,0 +1,353 @@
+#include "../Includes/Replay.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+// ReplayStats.cpp holds a tool that plays a corpus of replays back headlessly and gathers statistics over all of them
+// usage: ReplayStats <file.replay or directory> [--threads n] [--out directory]
+// Every replay is resimulated and watched tick by tick: points (serve to goal), the bar hits in each rally and where on
+// the bar they landed (PongSim::lastHitDist), how serves turned out, and how often each bar let a ball through
+// Each thread adds up its own replays and the totals are merged at the end, so threads never share a counter
+// Writes flat csv files with one column per field into the out directory (default the current one):
+//   replay_matches.csv       one row per replay
+//   replay_rallies.csv       points by the number of hits in the rally (the last row counts that many or more)
+//   replay_rally_seconds.csv points by rally length in seconds
+//   replay_hits.csv          hits by bar and hitDist (-1 to 1, the sign is the way the game bends the ball)
+//   replay_serves.csv        serves by the bar they went to, and whether it missed, or returned and won or lost the point
+//   replay_summary.csv       totals, including how often the AI (right bar) and the player (left bar) missed
+
+// rallies of this many hits or more share the last row
+static const int MAX_RALLY_HITS = 100;
+
+// rally seconds are counted in steps of RALLY_STEP_SECONDS up to RALLY_BINS of them
+static const float RALLY_STEP_SECONDS = 0.5f;
+static const int RALLY_BINS = 120;
+
+// bins of hitDist between -1 and 1
+static const int HIT_BINS = 20;
+
+enum Bar { LEFT = 0, RIGHT = 1 };
+static const char* BAR_NAMES[] = { "left", "right" };
+
+/*
+	Counters one thread adds its replays to, merged with the others at the end
+*/
+struct Totals {
+    unsigned long long replays, unreadable, ticks, points, unfinishedPoints, rallyHitsTotal;
+    double seconds;
+    unsigned long long rallyHits[MAX_RALLY_HITS + 1];
+    unsigned long long rallySeconds[RALLY_BINS + 1];
+    unsigned long long hits[2][HIT_BINS];
+    unsigned long long returns[2], misses[2];
+    // by the bar the serve went to
+    unsigned long long serves[2], servesMissed[2], servesWon[2], servesLost[2];
+    unsigned long long longestRally;
+
+    void merge(const Totals& other) {
+        replays += other.replays;
+        unreadable += other.unreadable;
+        ticks += other.ticks;
+        seconds += other.seconds;
+        rallyHitsTotal += other.rallyHitsTotal;
+        points += other.points;
+        unfinishedPoints += other.unfinishedPoints;
+        for (int i = 0; i <= MAX_RALLY_HITS; i++) {
+            rallyHits[i] += other.rallyHits[i];
+        }
+        for (int i = 0; i <= RALLY_BINS; i++) {
+            rallySeconds[i] += other.rallySeconds[i];
+        }
+        for (int bar = 0; bar < 2; bar++) {
+            for (int i = 0; i < HIT_BINS; i++) {
+                hits[bar][i] += other.hits[bar][i];
+            }
+            returns[bar] += other.returns[bar];
+            misses[bar] += other.misses[bar];
+            serves[bar] += other.serves[bar];
+            servesMissed[bar] += other.servesMissed[bar];
+            servesWon[bar] += other.servesWon[bar];
+            servesLost[bar] += other.servesLost[bar];
+        }
+        longestRally = other.longestRally > longestRally ? other.longestRally : longestRally;
+    }
+};
+
+/*
+	One row of replay_matches.csv
+*/
+struct MatchRow {
+    bool readable;
+    unsigned long long ticks, points, longestRally, rallyHits;
+    int tickRate;
+    unsigned long long pointsWon[2], returns[2], misses[2];
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the bar a ball moving with velocity x is heading for
+static int receiverOf(const PongSim& sim)
+{
+    return sim.ballVelocity.x < 0.0f ? LEFT : RIGHT;
+}
+
+static void analyze(const char* path, Totals& totals, MatchRow& row)
+{
+    memset(&row, 0, sizeof(row));
+    ReplayReader reader;
+    if (!reader.open(path)) {
+        totals.unreadable++;
+        return;
+    }
+    row.readable = true;
+    row.tickRate = reader.header().tickRate;
+    totals.replays++;
+
+    PongSim sim;
+    reader.start(sim);
+    // the point being played: who the serve went to, whether they got it back, the hits and when it started
+    int receiver = receiverOf(sim);
+    bool served = false;
+    unsigned long long hits = 0, pointStart = 0;
+    while (true) {
+        int leftScore = sim.leftScore, rightScore = sim.rightScore;
+        if (!reader.step(sim)) {
+            break;
+        }
+        if (sim.tick == 1) {
+            // the match was reset, the point being played (if it had started) never finished
+            if (reader.tick() - 1 > pointStart) {
+                totals.unfinishedPoints++;
+            }
+            leftScore = rightScore = 0;
+            receiver = receiverOf(sim);
+            hits = 0;
+            served = false;
+            pointStart = reader.tick() - 1;
+        }
+        if (sim.lastHit != BAR_HIT_NONE) {
+            int bar = sim.lastHit == BAR_HIT_LEFT ? LEFT : RIGHT;
+            int bin = (int)((sim.lastHitDist + 1.0f) * 0.5f * HIT_BINS);
+            bin = bin < 0 ? 0 : (bin >= HIT_BINS ? HIT_BINS - 1 : bin);
+            totals.hits[bar][bin]++;
+            totals.returns[bar]++;
+            row.returns[bar]++;
+            if (hits == 0 && bar == receiver) {
+                served = true;
+            }
+            hits++;
+        }
+        int scorer = sim.leftScore > leftScore ? LEFT : (sim.rightScore > rightScore ? RIGHT : -1);
+        if (scorer >= 0) {
+            int loser = 1 - scorer;
+            totals.points++;
+            row.points++;
+            row.pointsWon[scorer]++;
+            totals.misses[loser]++;
+            row.misses[loser]++;
+            totals.rallyHits[hits < (unsigned long long)MAX_RALLY_HITS ? hits : MAX_RALLY_HITS]++;
+            int bin = (int)((reader.tick() - pointStart) / (float)row.tickRate / RALLY_STEP_SECONDS);
+            totals.rallySeconds[bin < RALLY_BINS ? bin : RALLY_BINS]++;
+            totals.serves[receiver]++;
+            if (!served) {
+                totals.servesMissed[receiver]++;
+            }
+            else if (scorer == receiver) {
+                totals.servesWon[receiver]++;
+            }
+            else {
+                totals.servesLost[receiver]++;
+            }
+            row.rallyHits += hits;
+            totals.rallyHitsTotal += hits;
+            row.longestRally = hits > row.longestRally ? hits : row.longestRally;
+
+            // the step already served the next point
+            receiver = receiverOf(sim);
+            served = false;
+            hits = 0;
+            pointStart = reader.tick();
+        }
+    }
+    if (hits > 0) {
+        totals.unfinishedPoints++;
+    }
+    row.ticks = reader.tick();
+    totals.ticks += row.ticks;
+    totals.seconds += (double)row.ticks / row.tickRate;
+    totals.longestRally = row.longestRally > totals.longestRally ? row.longestRally : totals.longestRally;
+}
+
+static FILE* openCsv(const std::string& directory, const char* name, const char* columns)
+{
+    std::string path = directory + "/" + name;
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        printf("FAILED::REPLAY_STATS::COULD_NOT_CREATE: %s\n", path.c_str());
+        return nullptr;
+    }
+    fprintf(file, "%s\n", columns);
+    return file;
+}
+
+static double ratio(unsigned long long part, unsigned long long whole)
+{
+    return whole > 0 ? (double)part / whole : 0.0;
+}
+
+static bool writeCsvs(const std::string& directory, const std::vector<std::string>& paths, const std::vector<MatchRow>& rows, const Totals& totals)
+{
+    FILE* matches = openCsv(directory, "replay_matches.csv",
+        "file,ticks,seconds,points,left_points,right_points,longest_rally,mean_rally_hits,left_returns,left_misses,right_returns,right_misses");
+    if (matches == nullptr) {
+        return false;
+    }
+    for (size_t i = 0; i < rows.size(); i++) {
+        const MatchRow& row = rows[i];
+        if (!row.readable) {
+            continue;
+        }
+        fprintf(matches, "%s,%llu,%.2f,%llu,%llu,%llu,%llu,%.3f,%llu,%llu,%llu,%llu\n", paths[i].c_str(), row.ticks,
+            (double)row.ticks / row.tickRate, row.points, row.pointsWon[LEFT], row.pointsWon[RIGHT], row.longestRally,
+            ratio(row.rallyHits, row.points), row.returns[LEFT], row.misses[LEFT], row.returns[RIGHT], row.misses[RIGHT]);
+    }
+    fclose(matches);
+
+    FILE* rallies = openCsv(directory, "replay_rallies.csv", "hits,points");
+    if (rallies == nullptr) {
+        return false;
+    }
+    for (int i = 0; i <= MAX_RALLY_HITS; i++) {
+        fprintf(rallies, "%d,%llu\n", i, totals.rallyHits[i]);
+    }
+    fclose(rallies);
+
+    FILE* seconds = openCsv(directory, "replay_rally_seconds.csv", "from_seconds,to_seconds,points");
+    if (seconds == nullptr) {
+        return false;
+    }
+    for (int i = 0; i <= RALLY_BINS; i++) {
+        // the last bin is open ended, its upper bound is left empty
+        if (i < RALLY_BINS) {
+            fprintf(seconds, "%.1f,%.1f,%llu\n", i * RALLY_STEP_SECONDS, (i + 1) * RALLY_STEP_SECONDS, totals.rallySeconds[i]);
+        }
+        else {
+            fprintf(seconds, "%.1f,,%llu\n", i * RALLY_STEP_SECONDS, totals.rallySeconds[i]);
+        }
+    }
+    fclose(seconds);
+
+    FILE* hits = openCsv(directory, "replay_hits.csv", "bar,hit_dist_from,hit_dist_to,hits");
+    if (hits == nullptr) {
+        return false;
+    }
+    for (int bar = 0; bar < 2; bar++) {
+        for (int i = 0; i < HIT_BINS; i++) {
+            fprintf(hits, "%s,%.2f,%.2f,%llu\n", BAR_NAMES[bar], -1.0f + 2.0f * i / HIT_BINS, -1.0f + 2.0f * (i + 1) / HIT_BINS, totals.hits[bar][i]);
+        }
+    }
+    fclose(hits);
+
+    FILE* serves = openCsv(directory, "replay_serves.csv", "receiver,serves,missed,returned_and_won,returned_and_lost");
+    if (serves == nullptr) {
+        return false;
+    }
+    for (int bar = 0; bar < 2; bar++) {
+        fprintf(serves, "%s,%llu,%llu,%llu,%llu\n", BAR_NAMES[bar], totals.serves[bar], totals.servesMissed[bar], totals.servesWon[bar], totals.servesLost[bar]);
+    }
+    fclose(serves);
+
+    FILE* summary = openCsv(directory, "replay_summary.csv", "metric,value");
+    if (summary == nullptr) {
+        return false;
+    }
+    fprintf(summary, "replays,%llu\nunreadable,%llu\nticks,%llu\npoints,%llu\nunfinished_points,%llu\nlongest_rally,%llu\n",
+        totals.replays, totals.unreadable, totals.ticks, totals.points, totals.unfinishedPoints, totals.longestRally);
+    for (int bar = 0; bar < 2; bar++) {
+        fprintf(summary, "%s_returns,%llu\n%s_misses,%llu\n%s_miss_rate,%.5f\n", BAR_NAMES[bar], totals.returns[bar], BAR_NAMES[bar],
+            totals.misses[bar], BAR_NAMES[bar], ratio(totals.misses[bar], totals.returns[bar] + totals.misses[bar]));
+    }
+    fclose(summary);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* target = nullptr;
+    std::string out = ".";
+    int threads = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            out = argv[++i];
+        }
+        else {
+            target = argv[i];
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (target == nullptr) {
+        printf("usage: ReplayStats <file.replay or directory> [--threads n] [--out directory]\n");
+        return 1;
+    }
+    std::vector<std::string> paths;
+    size_t length = strlen(target);
+    if (length > 7 && !strcmp(target + length - 7, ".replay")) {
+        paths.push_back(target);
+    }
+    else if (!listReplays(target, &paths)) {
+        printf("FAILED::REPLAY_STATS::NO_SUCH_FILE_OR_DIRECTORY: %s\n", target);
+        return 1;
+    }
+
+    // every thread has totals of its own (allocated apart so they do not share cache lines), rows are one per replay
+    std::vector<Totals*> perThread;
+    for (int t = 0; t < threads; t++) {
+        Totals* totals = new Totals();
+        memset(totals, 0, sizeof(Totals));
+        perThread.push_back(totals);
+    }
+    std::vector<MatchRow> rows(paths.size());
+    std::atomic<int> next(0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            for (int i = next.fetch_add(1); i < (int)paths.size(); i = next.fetch_add(1)) {
+                analyze(paths[i].c_str(), *perThread[t], rows[i]);
+            }
+        }));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    Totals totals;
+    memset(&totals, 0, sizeof(totals));
+    for (Totals* threadTotals : perThread) {
+        totals.merge(*threadTotals);
+        delete threadTotals;
+    }
+    double wall = secondsSince(start);
+
+    if (!writeCsvs(out, paths, rows, totals)) {
+        return 1;
+    }
+    printf("%llu replays (%llu unreadable), %.1f hours of matches, %llu points in %.2f s on %d threads\n", totals.replays, totals.unreadable,
+        totals.seconds / 3600.0, totals.points, wall, threads);
+    printf("mean rally %.2f hits, longest %llu. left bar missed %.1f%%, right bar (AI) missed %.1f%% of the balls it had to return\n",
+        ratio(totals.rallyHitsTotal, totals.points), totals.longestRally,
+        100.0 * ratio(totals.misses[LEFT], totals.returns[LEFT] + totals.misses[LEFT]),
+        100.0 * ratio(totals.misses[RIGHT], totals.returns[RIGHT] + totals.misses[RIGHT]));
+    printf("csv files written to %s\n", out.c_str());
+    return 0;
+}
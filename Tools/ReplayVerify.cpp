@@ -0,0 +1,260 @@
+#include "../Includes/Replay.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+// ReplayVerify.cpp holds a headless replay player that fast forwards replays and checks they play out as recorded
+// usage: ReplayVerify <file.replay or directory> [--threads n] [--quiet]
+//        ReplayVerify --generate <directory> [--matches 100] [--minutes 10] [--hash-every 300] [--threads n]
+// Every replay is stepped through a PongSim as fast as the cpu goes. Each keyframe, state hash and the stored result
+// (final score and state hash) is compared with the state the match reached, and a replay that differs is reported with
+// the first tick that did not match, and one with a block that no longer decodes or holds a record past its end as damaged. A directory is spread over all
+// cores (or --threads), --quiet only prints the failures
+// --generate records matches of an AI chasing the ball with a few reactions a second, to have a corpus to check. Between
+// matches it changes the settings and resets in the same tick, the way SimThread does after the menu, --hash-every 1 stores a state hash every tick so a divergence in them is reported at its exact tick
+// Exits with 1 if any replay could not be read, was damaged or diverged
+
+struct Verified {
+    bool readable;
+    bool complete;
+    bool diverged;
+    bool damaged;
+    bool hasResult;
+    unsigned long long ticks, verifiedTick, divergedTick;
+    int tickRate;
+    int leftScore, rightScore;
+    double seconds;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Verified verify(const char* path)
+{
+    Verified verified;
+    memset(&verified, 0, sizeof(verified));
+    ReplayReader reader;
+    if (!reader.open(path)) {
+        return verified;
+    }
+    verified.readable = true;
+    verified.tickRate = reader.header().tickRate;
+
+    PongSim sim;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    reader.start(sim);
+    // nothing after a divergence can be trusted, so there is no point playing on
+    while (!reader.diverged() && reader.step(sim)) {
+    }
+    verified.seconds = secondsSince(start);
+
+    ReplayResult result;
+    verified.complete = reader.complete();
+    verified.diverged = reader.diverged();
+    verified.damaged = reader.damaged();
+    verified.hasResult = reader.storedResult(&result);
+    verified.ticks = reader.tick();
+    verified.verifiedTick = reader.verifiedTick();
+    verified.divergedTick = reader.divergedTick();
+    verified.leftScore = sim.leftScore;
+    verified.rightScore = sim.rightScore;
+    return verified;
+}
+
+static void print(const std::string& path, const Verified& verified)
+{
+    if (!verified.readable) {
+        printf("%s: not a replay\n", path.c_str());
+        return;
+    }
+    double matchSeconds = (double)verified.ticks / verified.tickRate;
+    printf("%s: %llu ticks (%.0f s) in %.2f ms, %.0fx real time, ", path.c_str(), verified.ticks, matchSeconds,
+        verified.seconds * 1000.0, verified.seconds > 0.0 ? matchSeconds / verified.seconds : 0.0);
+    if (verified.diverged && verified.divergedTick == verified.verifiedTick + 1) {
+        printf("DIVERGED at tick %llu, the first tick it differs at\n", verified.divergedTick);
+    }
+    else if (verified.diverged) {
+        printf("DIVERGED at tick %llu (last matched at tick %llu)\n", verified.divergedTick, verified.verifiedTick);
+    }
+    else if (verified.damaged) {
+        printf("DAMAGED block after tick %llu, matched up to tick %llu\n", verified.ticks, verified.verifiedTick);
+    }
+    else if (!verified.complete) {
+        printf("cut short, matched up to tick %llu\n", verified.verifiedTick);
+    }
+    else if (!verified.hasResult) {
+        printf("no result stored, matched up to tick %llu\n", verified.verifiedTick);
+    }
+    else {
+        printf("ok, ended %d-%d\n", verified.leftScore, verified.rightScore);
+    }
+}
+
+// settings the generated matches go through, one per match like a player changing them in the menu
+static const float GENERATED_BALL_SPEEDS[] = { 1.0f, 1.5f, 0.75f };
+static const float GENERATED_BAR_SPEEDS[] = { 5.0f, 4.0f, 6.0f };
+static const int GENERATED_MAX_SCORES[] = { 10, 7, 12 };
+static const int GENERATED_SETTINGS = 3;
+
+// records one match into path, the left bar chasing the ball like a player reacting a few times a second
+static bool generate(const std::string& path, unsigned int seed, int ticks, int hashTicks)
+{
+    ReplayHeader header = { 120, seed, 1.0f, 5.0f, 10 };
+    std::default_random_engine generator(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    PongSim sim;
+    startReplayMatch(sim, header);
+    ReplayWriter writer;
+    if (!writer.open(path.c_str())) {
+        return false;
+    }
+    writer.setHashInterval(hashTicks);
+    writer.begin(header);
+    int held = 0;
+    int matches = 0;
+    for (int i = 0; i < ticks; i++) {
+        if (sim.gameStatus() != 0) {
+            // the order SimThread::tick records them in: new settings first, then the reset serving with them
+            int next = ++matches % GENERATED_SETTINGS;
+            sim.setGameParameters(GENERATED_BALL_SPEEDS[next], GENERATED_BAR_SPEEDS[next], GENERATED_MAX_SCORES[next]);
+            writer.settings(GENERATED_BALL_SPEEDS[next], GENERATED_BAR_SPEEDS[next], GENERATED_MAX_SCORES[next]);
+            writer.reset();
+            sim.resetGame(true);
+        }
+        TickInput input = TickInput::constant(held);
+        int wanted = sim.aiDirection(true);
+        if (wanted != held && uniform(generator) < 0.08f) {
+            input.changeCount = 1;
+            input.changeOffsets[0] = uniform(generator) * sim.timeDelta;
+            input.changes[0] = wanted;
+            held = wanted;
+        }
+        writer.recordTick(input, sim);
+        sim.step(input, sim.aiDirection(false));
+    }
+    writer.result(sim);
+    writer.finish();
+    return true;
+}
+
+/* runs work(i) for i from 0 to count on threads threads, each taking the next index as it finishes one*/
+template <typename Work>
+static void parallelFor(int count, int threads, Work work)
+{
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&]() {
+            for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                work(i);
+            }
+        }));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* target = nullptr;
+    const char* generateDirectory = nullptr;
+    int threads = (int)std::thread::hardware_concurrency();
+    int matches = 100;
+    int minutes = 10;
+    int hashTicks = REPLAY_HASH_TICKS;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--generate") && i + 1 < argc) {
+            generateDirectory = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--matches") && i + 1 < argc) {
+            matches = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--minutes") && i + 1 < argc) {
+            minutes = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--hash-every") && i + 1 < argc) {
+            hashTicks = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--quiet")) {
+            quiet = true;
+        }
+        else {
+            target = argv[i];
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    if (generateDirectory != nullptr) {
+        std::atomic<int> failed(0);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        parallelFor(matches, threads, [&](int i) {
+            char name[32];
+            snprintf(name, sizeof(name), "/match%06d.replay", i);
+            if (!generate(std::string(generateDirectory) + name, (unsigned int)i + 1, minutes * 60 * 120, hashTicks)) {
+                failed++;
+            }
+        });
+        printf("recorded %d matches of %d minutes into %s in %.1f s\n", matches - failed.load(), minutes, generateDirectory, secondsSince(start));
+        return failed.load() == 0 ? 0 : 1;
+    }
+
+    if (target == nullptr) {
+        printf("usage: ReplayVerify <file.replay or directory> [--threads n] [--quiet]\n");
+        printf("       ReplayVerify --generate <directory> [--matches 100] [--minutes 10] [--hash-every 300] [--threads n]\n");
+        return 1;
+    }
+    std::vector<std::string> paths;
+    size_t length = strlen(target);
+    if (length > 7 && !strcmp(target + length - 7, ".replay")) {
+        paths.push_back(target);
+    }
+    else if (!listReplays(target, &paths)) {
+        printf("FAILED::REPLAY::NO_SUCH_FILE_OR_DIRECTORY: %s\n", target);
+        return 1;
+    }
+
+    std::vector<Verified> results(paths.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    parallelFor((int)paths.size(), threads, [&](int i) {
+        results[i] = verify(paths[i].c_str());
+    });
+    double wall = secondsSince(start);
+
+    int unreadable = 0, diverged = 0, damaged = 0, cutShort = 0;
+    double matchSeconds = 0.0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        const Verified& verified = results[i];
+        bool failure = !verified.readable || verified.diverged || verified.damaged;
+        if (!quiet || failure) {
+            print(paths[i], verified);
+        }
+        unreadable += !verified.readable;
+        diverged += verified.diverged;
+        damaged += !verified.diverged && verified.damaged;
+        cutShort += verified.readable && !verified.complete && !verified.diverged && !verified.damaged;
+        if (verified.readable) {
+            matchSeconds += (double)verified.ticks / verified.tickRate;
+        }
+    }
+    printf("%d replays, %.1f hours of matches in %.2f s on %d threads (%.0fx real time), %d diverged, %d damaged, %d cut short, %d unreadable\n",
+        (int)paths.size(), matchSeconds / 3600.0, wall, threads, wall > 0.0 ? matchSeconds / wall : 0.0, diverged, damaged, cutShort, unreadable);
+    if (diverged > 0 || damaged > 0 || unreadable > 0) {
+        printf("FAILED::REPLAY::DIVERGED_DAMAGED_OR_UNREADABLE\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,348 @@
+#include "../Includes/BlockCodec.hpp"
+#include <cstring>
+// BlockCodec.cpp holds logic for compressing replay blocks with LZ77 matches and a binary range coder
+
+// probabilities are 11 bit, and move 1/32 of the way towards each bit they see
+static const int PROB_BITS = 11;
+static const unsigned short PROB_INIT = 1 << (PROB_BITS - 1);
+static const int MOVE_BITS = 5;
+static const unsigned int RANGE_TOP = 1u << 24;
+
+// literals are coded in one of these contexts, picked by the top bits of the byte before them
+static const int LITERAL_CONTEXTS = 8;
+
+// match lengths and distance slots are coded as bit trees this many bits deep
+static const int LENGTH_BITS = 6;
+static const int SLOT_BITS = 5;
+
+// reflected CRC-32 polynomial
+static const unsigned int CRC_POLYNOMIAL = 0xEDB88320u;
+
+// the match finder hashes 3 bytes into HASH_SIZE chains and follows each at most SEARCH_DEPTH links
+static const int HASH_BITS = 12;
+static const int HASH_SIZE = 1 << HASH_BITS;
+static const int SEARCH_DEPTH = 32;
+
+/*
+	Adaptive probabilities for every decision the coder makes, the same on both sides
+	state is whether the last thing coded was a literal (0) or a match (1)
+*/
+struct CodecModel {
+    unsigned short isMatch[2];
+    unsigned short isRep[2];
+    unsigned short literal[LITERAL_CONTEXTS][256];
+    unsigned short length[1 << LENGTH_BITS];
+    unsigned short slot[1 << SLOT_BITS];
+
+    void reset() {
+        unsigned short* probs = &isMatch[0];
+        size_t count = sizeof(CodecModel) / sizeof(unsigned short);
+        for (size_t i = 0; i < count; i++) {
+            probs[i] = PROB_INIT;
+        }
+    }
+};
+
+struct RangeEncoder {
+    unsigned long long low;
+    unsigned int range;
+    unsigned char cache;
+    unsigned long long cacheSize;
+    std::vector<unsigned char>* out;
+
+    explicit RangeEncoder(std::vector<unsigned char>* out) : low(0), range(0xFFFFFFFFu), cache(0), cacheSize(1), out(out) {}
+
+    void shiftLow() {
+        // a carry out of low can still reach bytes we are holding back, so runs of 0xFF wait in cache until it is known
+        if ((unsigned int)low < 0xFF000000u || (low >> 32) != 0) {
+            unsigned char carry = (unsigned char)(low >> 32);
+            unsigned char held = cache;
+            do {
+                out->push_back((unsigned char)(held + carry));
+                held = 0xFF;
+            } while (--cacheSize != 0);
+            cache = (unsigned char)(low >> 24);
+        }
+        cacheSize++;
+        low = (low & 0x00FFFFFFu) << 8;
+    }
+
+    void encodeBit(unsigned short& probability, int bit) {
+        unsigned int bound = (range >> PROB_BITS) * probability;
+        if (bit == 0) {
+            range = bound;
+            probability += ((1 << PROB_BITS) - probability) >> MOVE_BITS;
+        }
+        else {
+            low += bound;
+            range -= bound;
+            probability -= probability >> MOVE_BITS;
+        }
+        while (range < RANGE_TOP) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    /* bits with even odds, for the low bits of distances which are close to random*/
+    void encodeDirect(unsigned int value, int bits) {
+        for (int i = bits - 1; i >= 0; i--) {
+            range >>= 1;
+            if ((value >> i) & 1) {
+                low += range;
+            }
+            while (range < RANGE_TOP) {
+                range <<= 8;
+                shiftLow();
+            }
+        }
+    }
+
+    void encodeTree(unsigned short* probabilities, int bits, unsigned int symbol) {
+        unsigned int node = 1;
+        for (int i = bits - 1; i >= 0; i--) {
+            int bit = (symbol >> i) & 1;
+            encodeBit(probabilities[node], bit);
+            node = (node << 1) | bit;
+        }
+    }
+
+    void flush() {
+        for (int i = 0; i < 5; i++) {
+            shiftLow();
+        }
+    }
+};
+
+struct RangeDecoder {
+    const unsigned char* in;
+    const unsigned char* end;
+    unsigned int range;
+    unsigned int code;
+    // set once we had to read past the end, the block was cut short or is not a block
+    bool overrun;
+
+    RangeDecoder(const unsigned char* in, size_t size) : in(in), end(in + size), range(0xFFFFFFFFu), code(0), overrun(false) {
+        for (int i = 0; i < 5; i++) {
+            code = (code << 8) | next();
+        }
+    }
+
+    unsigned char next() {
+        if (in < end) {
+            return *in++;
+        }
+        overrun = true;
+        return 0;
+    }
+
+    int decodeBit(unsigned short& probability) {
+        unsigned int bound = (range >> PROB_BITS) * probability;
+        int bit;
+        if (code < bound) {
+            range = bound;
+            probability += ((1 << PROB_BITS) - probability) >> MOVE_BITS;
+            bit = 0;
+        }
+        else {
+            code -= bound;
+            range -= bound;
+            probability -= probability >> MOVE_BITS;
+            bit = 1;
+        }
+        if (range < RANGE_TOP) {
+            range <<= 8;
+            code = (code << 8) | next();
+        }
+        return bit;
+    }
+
+    unsigned int decodeDirect(int bits) {
+        unsigned int value = 0;
+        for (int i = 0; i < bits; i++) {
+            range >>= 1;
+            unsigned int bit = code >= range ? 1 : 0;
+            code -= range & (0u - bit);
+            value = (value << 1) | bit;
+            if (range < RANGE_TOP) {
+                range <<= 8;
+                code = (code << 8) | next();
+            }
+        }
+        return value;
+    }
+
+    unsigned int decodeTree(unsigned short* probabilities, int bits) {
+        unsigned int node = 1;
+        for (int i = 0; i < bits; i++) {
+            node = (node << 1) | (unsigned int)decodeBit(probabilities[node]);
+        }
+        return node - (1u << bits);
+    }
+};
+
+// number of bits in value, the slot a distance is coded in
+static int bitLength(unsigned int value)
+{
+    int bits = 0;
+    while (value != 0) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+static unsigned int hash3(const unsigned char* bytes)
+{
+    unsigned int value = (unsigned int)bytes[0] | ((unsigned int)bytes[1] << 8) | ((unsigned int)bytes[2] << 16);
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static int matchLength(const unsigned char* in, size_t position, size_t distance, size_t size)
+{
+    size_t limit = size - position;
+    if (limit > (size_t)CODEC_MAX_MATCH) {
+        limit = CODEC_MAX_MATCH;
+    }
+    size_t length = 0;
+    while (length < limit && in[position + length] == in[position + length - distance]) {
+        length++;
+    }
+    return (int)length;
+}
+
+size_t compressBlock(const unsigned char* in, size_t size, std::vector<unsigned char>* out)
+{
+    size_t start = out->size();
+    CodecModel model;
+    model.reset();
+    RangeEncoder encoder(out);
+
+    std::vector<int> head(HASH_SIZE, -1);
+    std::vector<int> previous(size, -1);
+    size_t lastDistance = 0;
+    int state = 0;
+    size_t position = 0;
+    while (position < size) {
+        // the longest match, and a match at the last distance which is much cheaper to code
+        int repLength = lastDistance != 0 && lastDistance <= position ? matchLength(in, position, lastDistance, size) : 0;
+        int bestLength = 0;
+        size_t bestDistance = 0;
+        if (position + CODEC_MIN_MATCH <= size) {
+            int candidate = head[hash3(in + position)];
+            for (int depth = 0; depth < SEARCH_DEPTH && candidate >= 0 && position - candidate <= (size_t)CODEC_WINDOW; depth++) {
+                int length = matchLength(in, position, position - candidate, size);
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = position - candidate;
+                }
+                candidate = previous[candidate];
+            }
+        }
+
+        int taken;
+        if (repLength >= CODEC_MIN_MATCH && repLength + 1 >= bestLength) {
+            encoder.encodeBit(model.isMatch[state], 1);
+            encoder.encodeBit(model.isRep[state], 1);
+            encoder.encodeTree(model.length, LENGTH_BITS, (unsigned int)(repLength - CODEC_MIN_MATCH));
+            taken = repLength;
+            state = 1;
+        }
+        else if (bestLength >= CODEC_MIN_MATCH) {
+            encoder.encodeBit(model.isMatch[state], 1);
+            encoder.encodeBit(model.isRep[state], 0);
+            encoder.encodeTree(model.length, LENGTH_BITS, (unsigned int)(bestLength - CODEC_MIN_MATCH));
+            unsigned int value = (unsigned int)(bestDistance - 1);
+            int slot = bitLength(value);
+            encoder.encodeTree(model.slot, SLOT_BITS, (unsigned int)slot);
+            if (slot >= 2) {
+                encoder.encodeDirect(value & ((1u << (slot - 1)) - 1), slot - 1);
+            }
+            lastDistance = bestDistance;
+            taken = bestLength;
+            state = 1;
+        }
+        else {
+            encoder.encodeBit(model.isMatch[state], 0);
+            int context = position > 0 ? in[position - 1] >> 5 : 0;
+            encoder.encodeTree(model.literal[context], 8, in[position]);
+            taken = 1;
+            state = 0;
+        }
+
+        for (int i = 0; i < taken; i++, position++) {
+            if (position + CODEC_MIN_MATCH <= size) {
+                unsigned int hash = hash3(in + position);
+                previous[position] = head[hash];
+                head[hash] = (int)position;
+            }
+        }
+    }
+    encoder.flush();
+    return out->size() - start;
+}
+
+bool decompressBlock(const unsigned char* in, size_t size, unsigned char* out, size_t rawSize)
+{
+    CodecModel model;
+    model.reset();
+    RangeDecoder decoder(in, size);
+    size_t lastDistance = 0;
+    int state = 0;
+    size_t position = 0;
+    while (position < rawSize) {
+        if (decoder.decodeBit(model.isMatch[state]) == 0) {
+            int context = position > 0 ? out[position - 1] >> 5 : 0;
+            out[position++] = (unsigned char)decoder.decodeTree(model.literal[context], 8);
+            state = 0;
+            continue;
+        }
+        size_t distance = lastDistance;
+        bool rep = decoder.decodeBit(model.isRep[state]) == 1;
+        size_t length = CODEC_MIN_MATCH + decoder.decodeTree(model.length, LENGTH_BITS);
+        if (!rep) {
+            int slot = (int)decoder.decodeTree(model.slot, SLOT_BITS);
+            unsigned int value = slot < 2 ? (unsigned int)slot : ((1u << (slot - 1)) | decoder.decodeDirect(slot - 1));
+            distance = (size_t)value + 1;
+            lastDistance = distance;
+        }
+        if (distance == 0 || distance > position || length > rawSize - position) {
+            return false;
+        }
+        // byte by byte, a match may overlap the bytes it is producing
+        for (size_t i = 0; i < length; i++, position++) {
+            out[position] = out[position - distance];
+        }
+        state = 1;
+    }
+    return !decoder.overrun;
+}
+
+/*
+	The CRC of every byte value, built once. A function local static, so replays checked on several threads at once
+	do not race to build it
+*/
+struct CrcTable {
+    unsigned int entries[256];
+
+    CrcTable() {
+        for (unsigned int i = 0; i < 256; i++) {
+            unsigned int crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC_POLYNOMIAL : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+unsigned int blockChecksum(const unsigned char* in, size_t size, unsigned int checksum)
+{
+    static const CrcTable table;
+    // a byte at a time, blocks are a few hundred bytes
+    unsigned int crc = checksum ^ 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.entries[(crc ^ in[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
@@ -0,0 +1,218 @@
+#include "../Includes/ClockSync.hpp"
+#include <cmath>
+// ClockSync.cpp holds logic for estimating the remote peer's clock and sizing the input delay from how packets arrive
+
+// how often a filtered offset goes into the drift history
+static const long long HISTORY_INTERVAL_NS = 1000000000LL;
+
+// fewest history points, and shortest span of them, we fit a drift to
+static const int MIN_DRIFT_POINTS = 4;
+static const long long MIN_DRIFT_SPAN_NS = 3000000000LL;
+
+// the jitter buffer's running averages move this much of the way to each new packet (RFC 3550 uses 1/16 for jitter)
+static const double TRANSIT_GAIN = 1.0 / 16.0;
+static const double LOSS_GAIN = 1.0 / 64.0;
+
+// jitter above the mean transit the buffer covers, and the loss rate that earns an extra tick
+static const double JITTER_MARGIN = 3.0;
+static const double LOSS_THRESHOLD = 0.01;
+
+ClockSync::ClockSync()
+{
+    reset();
+}
+
+void ClockSync::reset()
+{
+    windowCount = 0;
+    windowNext = 0;
+    best.time = 0;
+    best.offset = 0;
+    best.rtt = 0;
+    historyCount = 0;
+    historyNext = 0;
+    lastHistory = 0;
+    candidate.rtt = -1;
+    drift = 0.0;
+}
+
+void ClockSync::addSample(long long sent, long long remoteReceived, long long remoteSent, long long received)
+{
+    Sample sample;
+    sample.time = received;
+    sample.offset = ((remoteReceived - sent) + (remoteSent - received)) / 2;
+    sample.rtt = (received - sent) - (remoteSent - remoteReceived);
+    if (sample.rtt < 0) {
+        return;
+    }
+    window[windowNext] = sample;
+    windowNext = (windowNext + 1) % WINDOW;
+    if (windowCount < WINDOW) {
+        windowCount++;
+    }
+
+    // the window only spans a few hundred milliseconds, too short for drift to matter when comparing its samples
+    int chosen = 0;
+    for (int i = 1; i < windowCount; i++) {
+        if (window[i].rtt < window[chosen].rtt) {
+            chosen = i;
+        }
+    }
+    best = window[chosen];
+
+    if (candidate.rtt < 0 || sample.rtt < candidate.rtt) {
+        candidate = sample;
+    }
+    if (historyCount == 0 || received - lastHistory >= HISTORY_INTERVAL_NS) {
+        history[historyNext] = candidate;
+        candidate.rtt = -1;
+        historyNext = (historyNext + 1) % HISTORY;
+        if (historyCount < HISTORY) {
+            historyCount++;
+        }
+        lastHistory = received;
+        fitDrift();
+    }
+}
+
+void ClockSync::fitDrift()
+{
+    if (historyCount < MIN_DRIFT_POINTS) {
+        return;
+    }
+    // relative to the first point so the sums stay well inside a double's precision
+    const Sample& origin = history[historyCount < HISTORY ? 0 : historyNext];
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    long long first = origin.time, last = origin.time;
+    for (int i = 0; i < historyCount; i++) {
+        double x = (double)(history[i].time - origin.time);
+        double y = (double)(history[i].offset - origin.offset);
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        if (history[i].time < first) {
+            first = history[i].time;
+        }
+        if (history[i].time > last) {
+            last = history[i].time;
+        }
+    }
+    double n = (double)historyCount;
+    double denominator = n * sumXX - sumX * sumX;
+    if (last - first < MIN_DRIFT_SPAN_NS || denominator <= 0.0) {
+        return;
+    }
+    drift = (n * sumXY - sumX * sumY) / denominator;
+}
+
+bool ClockSync::synced() const
+{
+    return windowCount > 0;
+}
+
+long long ClockSync::offset(long long localTime) const
+{
+    return best.offset + (long long)(drift * (double)(localTime - best.time));
+}
+
+long long ClockSync::toLocal(long long remoteTime) const
+{
+    // the offset barely changes over one offset's worth of time, so evaluating it at the remote time is close enough
+    return remoteTime - offset(remoteTime);
+}
+
+float ClockSync::rttMs() const
+{
+    return (float)best.rtt / 1000000.0f;
+}
+
+float ClockSync::driftPpm() const
+{
+    return (float)(drift * 1000000.0);
+}
+
+JitterBuffer::JitterBuffer()
+{
+    reset();
+}
+
+void JitterBuffer::reset()
+{
+    packets = 0;
+    transit = 0.0;
+    jitter = 0.0;
+    loss = 0.0;
+    lastTransit = 0;
+    lastSequence = 0;
+    seen = 0;
+}
+
+void JitterBuffer::packet(long long transit, unsigned short sequence)
+{
+    if (packets == 0) {
+        this->transit = (double)transit;
+        lastSequence = sequence;
+        seen = 1;
+    }
+    else {
+        short gap = (short)(sequence - lastSequence);
+        if (gap <= 0 && -gap < SEEN_WINDOW && ((seen >> -gap) & 1) != 0) {
+            // a copy of one we already have: neither a loss nor a late packet, and its transit was counted already
+            return;
+        }
+        if (gap > 0) {
+            for (int i = 1; i < gap; i++) {
+                loss += (1.0 - loss) * LOSS_GAIN;
+            }
+            loss -= loss * LOSS_GAIN;
+            lastSequence = sequence;
+            seen = (gap < SEEN_WINDOW ? seen << gap : 0) | 1;
+        }
+        else {
+            if (-gap < SEEN_WINDOW) {
+                seen |= 1ull << -gap;
+            }
+            // overtaken by a later packet and counted as lost then, take one loss back
+            loss = (loss - LOSS_GAIN) / (1.0 - LOSS_GAIN);
+            if (loss < 0.0) {
+                loss = 0.0;
+            }
+        }
+        this->transit += ((double)transit - this->transit) * TRANSIT_GAIN;
+        double difference = (double)(transit - lastTransit);
+        jitter += (std::fabs(difference) - jitter) * TRANSIT_GAIN;
+    }
+    lastTransit = transit;
+    packets++;
+}
+
+bool JitterBuffer::ready() const
+{
+    return packets >= MIN_PACKETS;
+}
+
+int JitterBuffer::targetTicks(long long tickNs) const
+{
+    double covered = transit + JITTER_MARGIN * jitter;
+    int ticks = covered > 0.0 ? (int)std::ceil(covered / (double)tickNs) : 0;
+    if (loss > LOSS_THRESHOLD) {
+        ticks++;
+    }
+    return ticks;
+}
+
+float JitterBuffer::transitMs() const
+{
+    return (float)(transit / 1000000.0);
+}
+
+float JitterBuffer::jitterMs() const
+{
+    return (float)(jitter / 1000000.0);
+}
+
+float JitterBuffer::lossPercent() const
+{
+    return (float)(loss * 100.0);
+}
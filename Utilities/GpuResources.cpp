@@ -0,0 +1,248 @@
+#include "../Includes/GpuResources.hpp"
+#include "../Includes/glHelpers.hpp"
+#include <glad/glad.h>
+#include <iostream>
+// GpuResources.cpp holds logic for creating, tracking and deleting opengl objects
+
+GpuResourceManager::GpuResourceManager()
+{
+    frame = 0;
+    for (int i = 0; i < GPU_RESOURCE_TYPES; i++) {
+        counts[i] = 0;
+        bytes[i] = 0;
+        deletions[i] = 0;
+    }
+}
+
+void GpuResourceManager::allocate(GpuResourceType type, unsigned int name, size_t size, unsigned int* index, unsigned int* generation)
+{
+    std::vector<Slot>& pool = slots[type];
+    if (freeSlots[type].empty()) {
+        Slot slot;
+        // generations start at 1 since 0 marks the null handle
+        slot.generation = 1;
+        pool.push_back(slot);
+        *index = (unsigned int)pool.size() - 1;
+    }
+    else {
+        *index = freeSlots[type].back();
+        freeSlots[type].pop_back();
+    }
+    Slot& slot = pool[*index];
+    slot.name = name;
+    slot.bytes = size;
+    slot.released = false;
+    *generation = slot.generation;
+
+    counts[type]++;
+    bytes[type] += size;
+}
+
+BufferHandle GpuResourceManager::createBuffer(GLenum target, size_t size, const void* data, GLenum usage)
+{
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, (GLsizeiptr)size, data, usage);
+
+    BufferHandle handle;
+    allocate(GPU_BUFFER, buffer, size, &handle.index, &handle.generation);
+    return handle;
+}
+
+VertexArrayHandle GpuResourceManager::createVertexArray()
+{
+    unsigned int vertexArray;
+    glGenVertexArrays(1, &vertexArray);
+
+    VertexArrayHandle handle;
+    allocate(GPU_VERTEX_ARRAY, vertexArray, 0, &handle.index, &handle.generation);
+    return handle;
+}
+
+TextureHandle GpuResourceManager::loadTexture(const char* path)
+{
+    size_t size = 0;
+    unsigned int texture = ::loadTexture(path, &size);
+
+    TextureHandle handle;
+    if (texture == 0) {
+        // a null handle, so the failure shows and nothing is counted for it
+        return handle;
+    }
+    allocate(GPU_TEXTURE, texture, size, &handle.index, &handle.generation);
+    return handle;
+}
+
+ProgramHandle GpuResourceManager::adoptProgram(unsigned int program)
+{
+    ProgramHandle handle;
+    allocate(GPU_PROGRAM, program, 0, &handle.index, &handle.generation);
+    return handle;
+}
+
+FramebufferHandle GpuResourceManager::createFramebuffer()
+{
+    unsigned int framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+
+    FramebufferHandle handle;
+    allocate(GPU_FRAMEBUFFER, framebuffer, 0, &handle.index, &handle.generation);
+    return handle;
+}
+
+RenderbufferHandle GpuResourceManager::createRenderbuffer(GLenum format, int width, int height, int bytesPerPixel)
+{
+    unsigned int renderbuffer;
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+
+    RenderbufferHandle handle;
+    allocate(GPU_RENDERBUFFER, renderbuffer, (size_t)width * height * bytesPerPixel, &handle.index, &handle.generation);
+    return handle;
+}
+
+unsigned int GpuResourceManager::nameOf(GpuResourceType type, unsigned int index, unsigned int generation) const
+{
+    if (generation == 0 || index >= slots[type].size()) {
+        return 0;
+    }
+    const Slot& slot = slots[type][index];
+    if (slot.generation != generation) {
+        return 0;
+    }
+    return slot.name;
+}
+
+void GpuResourceManager::releaseSlot(GpuResourceType type, unsigned int index, unsigned int generation)
+{
+    // null or stale handles (already released) are ignored
+    if (generation == 0 || index >= slots[type].size() || slots[type][index].generation != generation) {
+        return;
+    }
+    Slot& slot = slots[type][index];
+    // bumping the generation right away makes every copy of the handle stale, even before the object is deleted
+    slot.generation++;
+    if (slot.generation == 0) {
+        slot.generation = 1;
+    }
+    slot.released = true;
+
+    PendingDelete deletion;
+    deletion.type = type;
+    deletion.index = index;
+    deletion.frame = frame;
+    pending.push_back(deletion);
+}
+
+void GpuResourceManager::setBytes(BufferHandle handle, size_t size)
+{
+    if (name(handle) == 0) {
+        return;
+    }
+    Slot& slot = slots[GPU_BUFFER][handle.index];
+    bytes[GPU_BUFFER] = bytes[GPU_BUFFER] - slot.bytes + size;
+    slot.bytes = size;
+}
+
+void GpuResourceManager::destroySlot(GpuResourceType type, unsigned int index)
+{
+    Slot& slot = slots[type][index];
+    switch (type) {
+    case GPU_BUFFER:
+        glDeleteBuffers(1, &slot.name);
+        break;
+    case GPU_VERTEX_ARRAY:
+        glDeleteVertexArrays(1, &slot.name);
+        break;
+    case GPU_TEXTURE:
+        glDeleteTextures(1, &slot.name);
+        break;
+    case GPU_PROGRAM:
+        glDeleteProgram(slot.name);
+        break;
+    case GPU_FRAMEBUFFER:
+        glDeleteFramebuffers(1, &slot.name);
+        break;
+    case GPU_RENDERBUFFER:
+        glDeleteRenderbuffers(1, &slot.name);
+        break;
+    default:
+        break;
+    }
+    counts[type]--;
+    bytes[type] -= slot.bytes;
+    deletions[type]++;
+    slot.name = 0;
+    slot.bytes = 0;
+    slot.released = false;
+    freeSlots[type].push_back(index);
+}
+
+void GpuResourceManager::endFrame()
+{
+    frame++;
+    // pending is in release order, so everything old enough to delete is at the front
+    size_t done = 0;
+    while (done < pending.size() && pending[done].frame + FRAMES_IN_FLIGHT <= frame) {
+        destroySlot(pending[done].type, pending[done].index);
+        done++;
+    }
+    if (done > 0) {
+        pending.erase(pending.begin(), pending.begin() + done);
+    }
+}
+
+void GpuResourceManager::flush()
+{
+    for (size_t i = 0; i < pending.size(); i++) {
+        destroySlot(pending[i].type, pending[i].index);
+    }
+    pending.clear();
+}
+
+size_t GpuResourceManager::liveCount(GpuResourceType type) const
+{
+    return counts[type];
+}
+
+size_t GpuResourceManager::liveBytes(GpuResourceType type) const
+{
+    return bytes[type];
+}
+
+size_t GpuResourceManager::pendingCount() const
+{
+    return pending.size();
+}
+
+unsigned long long GpuResourceManager::deletedCount(GpuResourceType type) const
+{
+    return deletions[type];
+}
+
+size_t GpuResourceManager::reportLeaks() const
+{
+    size_t total = 0;
+    for (int i = 0; i < GPU_RESOURCE_TYPES; i++) {
+        if (counts[i] > 0) {
+            std::cout << "GPU::RESOURCE::LEAK: " << counts[i] << " " << typeName((GpuResourceType)i) << " (" << bytes[i] << " bytes)" << std::endl;
+        }
+        total += counts[i];
+    }
+    return total;
+}
+
+const char* GpuResourceManager::typeName(GpuResourceType type)
+{
+    switch (type) {
+    case GPU_BUFFER: return "buffers";
+    case GPU_VERTEX_ARRAY: return "vertex arrays";
+    case GPU_TEXTURE: return "textures";
+    case GPU_PROGRAM: return "programs";
+    case GPU_FRAMEBUFFER: return "framebuffers";
+    case GPU_RENDERBUFFER: return "renderbuffers";
+    default: return "unknown";
+    }
+}
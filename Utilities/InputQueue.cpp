@@ -0,0 +1,106 @@
+#include "../Includes/InputQueue.hpp"
+#include <GLFW/glfw3.h>
+#include <chrono>
+// InputQueue.cpp holds logic for recording key events with timestamps for the simulation thread
+
+InputQueue::InputQueue()
+{
+    upHeld = false;
+    downHeld = false;
+    direction = 0;
+    droppedEvents = 0;
+    tickDirection = 0;
+}
+
+long long InputQueue::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void InputQueue::keyEvent(int key, int action)
+{
+    // stamp the event first, before any other work adds to its latency
+    long long time = now();
+
+    // key repeats do not change what is held
+    if (action == GLFW_REPEAT) {
+        return;
+    }
+    bool pressed = action == GLFW_PRESS;
+    if (key == GLFW_KEY_UP) {
+        upHeld = pressed;
+    }
+    else if (key == GLFW_KEY_DOWN) {
+        downHeld = pressed;
+    }
+    else {
+        return;
+    }
+
+    int newDirection = upHeld ? 1 : (downHeld ? -1 : 0);
+    if (newDirection != direction) {
+        push(newDirection, time);
+    }
+}
+
+bool InputQueue::push(int direction, long long time)
+{
+    InputEvent event;
+    event.time = time;
+    event.direction = direction;
+    if (!events.push(event)) {
+        droppedEvents++;
+        return false;
+    }
+    this->direction = direction;
+    return true;
+}
+
+bool InputQueue::peek(InputEvent& event) const
+{
+    return events.peek(event);
+}
+
+bool InputQueue::pop(InputEvent& event)
+{
+    return events.pop(event);
+}
+
+TickInput InputQueue::collectTick(long long tickStart, long long tickEnd, float timeDelta)
+{
+    TickInput tickInput = TickInput::constant(tickDirection);
+    double tickNanos = (double)(tickEnd - tickStart);
+    InputEvent event;
+    while (peek(event) && event.time < tickEnd) {
+        pop(event);
+        // events from before this tick (we were paused or catching up) take effect right at its start
+        float offset = event.time <= tickStart || tickNanos <= 0.0 ? 0.0f : (float)((event.time - tickStart) / tickNanos * timeDelta);
+        if (offset <= 0.0f && tickInput.changeCount == 0) {
+            tickInput.direction = event.direction;
+        }
+        else if (tickInput.changeCount < TickInput::MAX_CHANGES) {
+            tickInput.changeOffsets[tickInput.changeCount] = offset;
+            tickInput.changes[tickInput.changeCount] = event.direction;
+            tickInput.changeCount++;
+        }
+        else {
+            // out of room, the last change takes whatever direction the player ended up with
+            tickInput.changes[TickInput::MAX_CHANGES - 1] = event.direction;
+        }
+    }
+    tickDirection = tickInput.finalDirection();
+    return tickInput;
+}
+
+unsigned int InputQueue::dropped() const
+{
+    return droppedEvents;
+}
+
+void input_key_callback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/)
+{
+    InputQueue* input = (InputQueue*)glfwGetWindowUserPointer(window);
+    if (input != nullptr) {
+        input->keyEvent(key, action);
+    }
+}
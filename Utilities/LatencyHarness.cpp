@@ -0,0 +1,423 @@
+#include "../Includes/LatencyHarness.hpp"
+#include "../Includes/SimThread.hpp"
+#include "../Includes/Meshes.hpp"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+// LatencyHarness.cpp holds logic for injecting key presses and timing when they reach the screen
+
+// trial states on the render thread
+enum TrialState { SETTLING, WAITING };
+
+LatencyHarness::LatencyHarness(GLFWwindow* window, GpuResourceManager* resources, PongState* pong)
+    : command(IDLE), pressDirection(0), pressTime(0)
+{
+    this->window = window;
+    this->resources = resources;
+    this->pong = pong;
+    width = 0;
+    height = 0;
+    gpuToCpu = 0;
+    for (int i = 0; i < READBACK_RING; i++) {
+        readbacks[i].query = 0;
+        readbacks[i].fence = 0;
+        readbacks[i].frame = 0;
+        readbacks[i].swapTime = 0;
+        readbacks[i].pending = false;
+    }
+    injector = std::thread(&LatencyHarness::runInjector, this);
+}
+
+LatencyHarness::~LatencyHarness()
+{
+    command.store(QUIT);
+    if (injector.joinable()) {
+        injector.join();
+    }
+}
+
+void LatencyHarness::runInjector()
+{
+    // presses land anywhere inside a frame, like real ones do, so we sample every phase of the frame
+    std::default_random_engine generator(1234);
+    std::uniform_int_distribution<int> phase(0, 16667);
+    while (true) {
+        int current = command.load();
+        if (current == QUIT) {
+            return;
+        }
+        if (current == PRESS || current == RELEASE) {
+            std::this_thread::sleep_for(std::chrono::microseconds(phase(generator)));
+            long long time = InputQueue::now();
+            input.push(current == PRESS ? pressDirection.load() : 0, time);
+            if (current == PRESS) {
+                pressTime.store(time);
+            }
+            // the render thread may already have asked for the release, which must not be lost
+            command.compare_exchange_strong(current, IDLE);
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+bool LatencyHarness::setup()
+{
+    glfwGetFramebufferSize(window, &width, &height);
+    if (width <= 0 || height <= 0) {
+        std::cout << "FAILED::LATENCY::WINDOW::HAS::NO::FRAMEBUFFER" << std::endl;
+        return false;
+    }
+
+    fbo = OwnedFramebuffer(resources, resources->createFramebuffer());
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo.name());
+    colorBuffer = OwnedRenderbuffer(resources, resources->createRenderbuffer(GL_RGBA8, width, height, 4));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer.name());
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cout << "FAILED::LATENCY::FRAMEBUFFER::INCOMPLETE" << std::endl;
+        return false;
+    }
+
+    // one pixel per frame, read back through its own buffer so glReadPixels never stalls
+    for (int i = 0; i < READBACK_RING; i++) {
+        Readback& slot = readbacks[i];
+        slot.pbo = OwnedBuffer(resources, resources->createBuffer(GL_PIXEL_PACK_BUFFER, 4, nullptr, GL_STREAM_READ));
+        glGenQueries(1, &slot.query);
+        slot.fence = 0;
+        slot.pending = false;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+void LatencyHarness::teardown()
+{
+    for (int i = 0; i < READBACK_RING; i++) {
+        Readback& slot = readbacks[i];
+        slot.pbo.reset();
+        if (slot.query != 0) {
+            glDeleteQueries(1, &slot.query);
+            slot.query = 0;
+        }
+        if (slot.fence != 0) {
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+        }
+        slot.pending = false;
+    }
+    colorBuffer.reset();
+    fbo.reset();
+}
+
+void LatencyHarness::calibrate()
+{
+    glFinish();
+    long long before = InputQueue::now();
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    long long after = InputQueue::now();
+    gpuToCpu = (before + after) / 2 - (long long)gpuTime;
+}
+
+void LatencyHarness::limitQueue(unsigned long long frame, int frameQueue)
+{
+    if (frameQueue <= 0 || frame < (unsigned long long)frameQueue) {
+        return;
+    }
+    Readback& old = readbacks[(frame - frameQueue) % READBACK_RING];
+    if (old.fence != 0) {
+        glClientWaitSync(old.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL);
+    }
+}
+
+bool LatencyHarness::collect(Readback& slot, bool* markerLit, long long* gpuTime)
+{
+    GLint available = 0;
+    glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+    GLuint64 timestamp = 0;
+    glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &timestamp);
+    *gpuTime = (long long)timestamp + gpuToCpu;
+
+    // the timestamp was queued after the read, so the pixel is already there
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo.name());
+    const unsigned char* pixel = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4, GL_MAP_READ_BIT);
+    // the bars are red on a white background
+    *markerLit = pixel != nullptr && pixel[0] > 200 && pixel[1] < 60 && pixel[2] < 60;
+    if (pixel != nullptr) {
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+bool LatencyHarness::measure(const LatencyConfig& config, int trials, std::vector<LatencySample>& samples, int* missed)
+{
+    if (!setup()) {
+        teardown();
+        return false;
+    }
+    glfwSwapInterval(config.swapInterval);
+    calibrate();
+
+    // a still ball can never wander over the marker pixel
+    SimThread* simThread = nullptr;
+    PongSim inlineSim;
+    if (config.tickRate > 0) {
+        simThread = new SimThread(config.tickRate);
+        simThread->setInputQueue(&input);
+        simThread->setGameParameters(0.0f, 5.0f, 1000);
+        simThread->setRunning(true);
+        simThread->requestReset();
+        simThread->start();
+    }
+    else {
+        inlineSim.setGameParameters(0.0f, 5.0f, 1000);
+        inlineSim.resetGame(true);
+    }
+
+    bool ok = true;
+    int done = 0;
+    *missed = 0;
+    TrialState state = SETTLING;
+    int settle = SETTLE_FRAMES;
+    int markerX = 0, markerY = 0;
+    int direction = 1;
+    unsigned long long frame = 0, armFrame = 0, pressFrame = 0;
+    bool pressSeen = false;
+    long long lastFrameTime = InputQueue::now();
+
+    while (done < trials) {
+        if (glfwWindowShouldClose(window)) {
+            ok = false;
+            break;
+        }
+        glfwPollEvents();
+        limitQueue(frame, config.frameQueue);
+
+        // handle finished readbacks oldest first, stopping at the first that has not arrived
+        unsigned long long oldest = frame > READBACK_RING ? frame - READBACK_RING : 0;
+        for (unsigned long long f = oldest; f < frame; f++) {
+            Readback& slot = readbacks[f % READBACK_RING];
+            if (!slot.pending || slot.frame != f) {
+                continue;
+            }
+            bool lit;
+            long long gpuTime;
+            if (!collect(slot, &lit, &gpuTime)) {
+                break;
+            }
+            slot.pending = false;
+
+            long long pressed = pressTime.load();
+            if (state == WAITING && pressed != 0 && slot.frame >= armFrame && lit) {
+                // a frame that finished before the press cannot be showing it, the marker was wrong so redo the trial
+                if (gpuTime >= pressed) {
+                    LatencySample sample;
+                    sample.config = config;
+                    sample.gpuMs = (gpuTime - pressed) / 1e6f;
+                    sample.swapMs = (slot.swapTime - pressed) / 1e6f;
+                    sample.frames = (int)(slot.frame - pressFrame);
+                    samples.push_back(sample);
+                    done++;
+                }
+                command.store(RELEASE);
+                state = SETTLING;
+                settle = SETTLE_FRAMES;
+            }
+        }
+
+        if (state == WAITING) {
+            long long pressed = pressTime.load();
+            if (pressed != 0 && !pressSeen) {
+                // the first frame whose simulation could have seen the press
+                pressFrame = frame;
+                pressSeen = true;
+            }
+            if (pressed != 0 && InputQueue::now() - pressed > TIMEOUT_NS) {
+                // the trial is used up but left out of the distributions, so it is reported beside them
+                (*missed)++;
+                done++;
+                command.store(RELEASE);
+                state = SETTLING;
+                settle = SETTLE_FRAMES;
+            }
+        }
+
+        // the newest state of the match
+        PongSnapshot snapshot;
+        if (simThread != nullptr) {
+            snapshot = simThread->latestSnapshot();
+        }
+        else {
+            long long now = InputQueue::now();
+            float timeDelta = std::min((now - lastFrameTime) / 1e9f, 0.1f);
+            inlineSim.setTimeDelta(timeDelta);
+            inlineSim.step(input.collectTick(lastFrameTime, now, timeDelta), 0);
+            lastFrameTime = now;
+            snapshot = inlineSim.takeSnapshot();
+        }
+
+        // once the bar has been still for a few frames (and the injector has released), arm the next press
+        if (state == SETTLING && command.load() == IDLE && --settle <= 0) {
+            float top = snapshot.leftBarPos.y, bottom = snapshot.leftBarPos.y - BAR_HEIGHT;
+            if (top > 0.7f) {
+                direction = -1;
+            }
+            else if (bottom < -0.7f) {
+                direction = 1;
+            }
+            else {
+                direction = -direction;
+            }
+            // a couple of pixels past the edge the bar is about to move towards (opengl rows go bottom to top)
+            markerX = (int)((snapshot.leftBarPos.x + BAR_WIDTH * 0.5f + 1.0f) * 0.5f * width);
+            markerY = direction > 0 ? (int)((top + 1.0f) * 0.5f * height) + 2 : (int)((bottom + 1.0f) * 0.5f * height) - 3;
+            markerX = std::min(std::max(markerX, 0), width - 1);
+            markerY = std::min(std::max(markerY, 0), height - 1);
+
+            pressTime.store(0);
+            pressSeen = false;
+            pressDirection.store(direction);
+            armFrame = frame;
+            state = WAITING;
+            command.store(PRESS);
+        }
+
+        // draw offscreen, then show the same frame in the window
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo.name());
+        glViewport(0, 0, width, height);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        pong->draw(snapshot);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.name());
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        // queue the marker pixel and a timestamp of when the gpu got through this frame
+        Readback& slot = readbacks[frame % READBACK_RING];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo.name());
+        glReadPixels(markerX, markerY, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glQueryCounter(slot.query, GL_TIMESTAMP);
+        if (slot.fence != 0) {
+            glDeleteSync(slot.fence);
+        }
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        glfwSwapBuffers(window);
+        slot.swapTime = InputQueue::now();
+        slot.frame = frame;
+        slot.pending = true;
+        frame++;
+        resources->endFrame();
+    }
+
+    // leave the bar released for the next configuration
+    if (state == WAITING) {
+        command.store(RELEASE);
+    }
+    while (command.load() != IDLE) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (simThread != nullptr) {
+        simThread->stop();
+        delete simThread;
+    }
+    glFinish();
+    teardown();
+
+    return ok;
+}
+
+/* percentile of a sorted list of values*/
+static float percentile(const std::vector<float>& sorted, float p)
+{
+    if (sorted.empty()) {
+        return 0.0f;
+    }
+    size_t index = (size_t)(p * (sorted.size() - 1) + 0.5f);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int runLatencySweep(GLFWwindow* window, GpuResourceManager* resources, int trials, const char* csvPath)
+{
+    static const int SWAP_INTERVALS[2] = { 0, 1 };
+    static const int FRAME_QUEUES[4] = { 1, 2, 3, 0 };
+    static const int TICK_RATES[4] = { 0, 60, 120, 240 };
+
+    PongState* pong = new PongState(resources);
+    std::vector<LatencySample> samples;
+    bool ok = true;
+    {
+        LatencyHarness harness(window, resources, pong);
+        printf("%-5s %-6s %-7s %5s %6s | %-31s | %-31s\n", "swap", "queue", "sim", "n", "missed", "gpu done ms  p50   p90   p99   max", "swap done ms p50   p90   p99   max");
+        for (int s = 0; s < 2 && ok; s++) {
+            for (int q = 0; q < 4 && ok; q++) {
+                for (int t = 0; t < 4 && ok; t++) {
+                    LatencyConfig config;
+                    config.swapInterval = SWAP_INTERVALS[s];
+                    config.frameQueue = FRAME_QUEUES[q];
+                    config.tickRate = TICK_RATES[t];
+
+                    size_t first = samples.size();
+                    int missed = 0;
+                    ok = harness.measure(config, trials, samples, &missed);
+
+                    std::vector<float> gpu, swap;
+                    for (size_t i = first; i < samples.size(); i++) {
+                        gpu.push_back(samples[i].gpuMs);
+                        swap.push_back(samples[i].swapMs);
+                    }
+                    std::sort(gpu.begin(), gpu.end());
+                    std::sort(swap.begin(), swap.end());
+
+                    char queue[8], sim[8];
+                    if (config.frameQueue > 0) {
+                        snprintf(queue, sizeof(queue), "%d", config.frameQueue);
+                    }
+                    else {
+                        snprintf(queue, sizeof(queue), "driver");
+                    }
+                    if (config.tickRate > 0) {
+                        snprintf(sim, sizeof(sim), "%dhz", config.tickRate);
+                    }
+                    else {
+                        snprintf(sim, sizeof(sim), "inline");
+                    }
+                    printf("%-5d %-6s %-7s %5d %6d | %12s %5.1f %5.1f %5.1f %5.1f | %12s %5.1f %5.1f %5.1f %5.1f\n",
+                        config.swapInterval, queue, sim, (int)gpu.size(), missed,
+                        "", percentile(gpu, 0.5f), percentile(gpu, 0.9f), percentile(gpu, 0.99f), percentile(gpu, 1.0f),
+                        "", percentile(swap, 0.5f), percentile(swap, 0.9f), percentile(swap, 0.99f), percentile(swap, 1.0f));
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+    pong->destroyState();
+    delete pong;
+
+    FILE* file = fopen(csvPath, "w");
+    if (file == nullptr) {
+        std::cout << "FAILED::LATENCY::WRITING::CSV: " << csvPath << std::endl;
+        return -1;
+    }
+    fprintf(file, "swap_interval,frame_queue,tick_rate,gpu_ms,swap_ms,frames\n");
+    for (size_t i = 0; i < samples.size(); i++) {
+        const LatencySample& sample = samples[i];
+        fprintf(file, "%d,%d,%d,%.3f,%.3f,%d\n", sample.config.swapInterval, sample.config.frameQueue, sample.config.tickRate,
+            sample.gpuMs, sample.swapMs, sample.frames);
+    }
+    fclose(file);
+    return ok ? 0 : -1;
+}
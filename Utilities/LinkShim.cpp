@@ -0,0 +1,151 @@
+#include "../Includes/LinkShim.hpp"
+#include <cmath>
+#include <cstring>
+// LinkShim.cpp holds logic for delaying, dropping, reordering and duplicating outgoing packets like a bad network would
+
+// shape of the pareto tail, heavier the closer to 1
+static const float PARETO_SHAPE = 2.5f;
+
+// udp and ipv4 headers, they take up link capacity too
+static const int PACKET_OVERHEAD = 28;
+
+static const float TWO_PI = 6.28318531f;
+
+LinkShim::LinkShim()
+{
+    LinkConditions none;
+    memset(&none, 0, sizeof(none));
+    configure(none, 0);
+}
+
+void LinkShim::configure(const LinkConditions& conditions, unsigned int seed)
+{
+    this->conditions = conditions;
+    random.seed(seed);
+    bursting = false;
+    linkFree = 0;
+    queue.clear();
+    memset(&stats, 0, sizeof(stats));
+}
+
+float LinkShim::delayMs(float a, float b) const
+{
+    float ms = (float)conditions.delayMs;
+    float jitter = (float)conditions.jitterMs;
+    if (jitter <= 0.0f) {
+        return ms;
+    }
+    switch (conditions.delayShape) {
+    case DELAY_NORMAL:
+        // Box-Muller, 1 - a is never 0 so the log stays finite
+        ms += jitter * sqrtf(-2.0f * logf(1.0f - a)) * cosf(TWO_PI * b);
+        break;
+    case DELAY_PARETO:
+        // u^(-1/shape) - 1 has a mean of 1/(shape - 1), scaled so the mean extra delay is jitterMs
+        ms += jitter * (PARETO_SHAPE - 1.0f) * (powf(1.0f - a, -1.0f / PARETO_SHAPE) - 1.0f);
+        break;
+    default:
+        ms += (a * 2.0f - 1.0f) * jitter;
+        break;
+    }
+    return ms;
+}
+
+void LinkShim::send(UdpSocket& socket, const NetAddress& to, const unsigned char* data, int length, long long now)
+{
+    // the same draws in the same order for every packet, whatever becomes of it
+    float lossDraw = random.next();
+    float delayA = random.next();
+    float delayB = random.next();
+    float reorderDraw = random.next();
+    float reorderAmount = random.next();
+    float duplicateDraw = random.next();
+    float copyA = random.next();
+    float copyB = random.next();
+
+    float lossChance = conditions.lossPercent / 100.0f;
+    bool lost;
+    if (conditions.lossBurst <= 1.0f || lossChance <= 0.0f) {
+        lost = lossDraw < lossChance;
+    }
+    else {
+        // two state (Gilbert) model: a run of losses ends with a chance of 1/lossBurst per packet, and one starts
+        // just often enough for the long run average to stay at lossPercent
+        float leave = 1.0f / conditions.lossBurst;
+        float enter = lossChance < 1.0f ? lossChance * leave / (1.0f - lossChance) : 1.0f;
+        bursting = bursting ? lossDraw >= leave : lossDraw < enter;
+        lost = bursting;
+    }
+    if (lost) {
+        stats.lost++;
+        return;
+    }
+
+    // a capped link sends one packet after the other, the delay starts once the packet is on the wire
+    long long start = now;
+    if (conditions.bandwidthKbps > 0) {
+        if (linkFree < now) {
+            linkFree = now;
+        }
+        if (linkFree - now > QUEUE_LIMIT_MS * 1000000LL) {
+            stats.queueDrops++;
+            return;
+        }
+        linkFree += (long long)(length + PACKET_OVERHEAD) * 8 * 1000000LL / conditions.bandwidthKbps;
+        start = linkFree;
+    }
+
+    float ms = delayMs(delayA, delayB);
+    if (reorderDraw * 100.0f < conditions.reorderPercent) {
+        ms += REORDER_MIN_MS + reorderAmount * (REORDER_MAX_MS - REORDER_MIN_MS);
+        stats.reordered++;
+    }
+    long long release = start + (ms > 0.0f ? (long long)(ms * 1000000.0f) : 0);
+    bool duplicate = duplicateDraw * 100.0f < conditions.duplicatePercent;
+    // nothing to simulate, skip the copy
+    if (release <= now && !duplicate && queue.empty()) {
+        socket.send(to, data, length);
+        stats.sent++;
+        return;
+    }
+    hold(to, data, length, release);
+    if (duplicate) {
+        float copyMs = delayMs(copyA, copyB);
+        hold(to, data, length, start + (copyMs > 0.0f ? (long long)(copyMs * 1000000.0f) : 0));
+        stats.duplicated++;
+    }
+}
+
+void LinkShim::hold(const NetAddress& to, const unsigned char* data, int length, long long release)
+{
+    Delayed delayed;
+    delayed.release = release;
+    delayed.to = to;
+    delayed.length = length;
+    memcpy(delayed.data, data, length);
+    queue.push_back(delayed);
+}
+
+void LinkShim::flush(UdpSocket& socket, long long now)
+{
+    // jitter lets a later packet overtake an earlier one, just like on a real network
+    size_t kept = 0;
+    for (size_t i = 0; i < queue.size(); i++) {
+        if (queue[i].release <= now) {
+            socket.send(queue[i].to, queue[i].data, queue[i].length);
+            stats.sent++;
+        }
+        else {
+            if (kept != i) {
+                queue[kept] = queue[i];
+            }
+            kept++;
+        }
+    }
+    queue.resize(kept);
+}
+
+const LinkCounters& LinkShim::counters() const
+{
+    return stats;
+}
@@ -0,0 +1,711 @@
+#include "../Includes/MatchServer.hpp"
+#include "../Includes/PongSim.hpp"
+#include "../Includes/UdpSocket.hpp"
+#include "../Includes/ServerProtocol.hpp"
+#include "../Includes/TimerWheel.hpp"
+#include "../Includes/SharedPacket.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+// MatchServer.cpp holds logic for stepping many matches per shard and talking to their players in batches
+
+// if a match falls this many ticks behind it skips ahead instead of fast forwarding
+static const int MAX_CATCHUP_TICKS = 5;
+
+// players are dropped after this long without a packet
+static const long long TIMEOUT_NS = MatchServer::TIMEOUT_MS * 1000000LL;
+
+static const long long TICK_NS = 1000000000LL / MatchServer::TICK_RATE;
+
+// the shard's timer wheel counts milliseconds since the shard started
+static const long long WHEEL_UNIT_NS = 1000000LL;
+
+// what a timer is for, in the top bits of its data. The rest is the match index
+enum TimerKind { TIMER_TICK = 1, TIMER_IDLE = 2, TIMER_WAITING = 3 };
+
+struct ServerPlayer {
+    NetAddress address;
+    unsigned short id;
+    signed char direction;
+    long long lastHeard;
+    // newest state the player has told us it decoded, states are sent as deltas against it
+    unsigned int ackedTick;
+    bool acked;
+};
+
+struct Spectator {
+    NetAddress address;
+    unsigned short id;
+    int match;
+    // where it sits in its match's list, so it can be taken out without a search
+    int slot;
+    long long lastHeard;
+    // newest state it acknowledged, and the tick it started watching at
+    unsigned int ackedTick, watchedTick;
+    bool acked;
+};
+
+struct ServerMatch {
+    PongSim sim;
+    ServerPlayer players[2];
+    // states recently sent to both players, for deltas
+    StateRing<ReplicatedState, REPLICATION_HISTORY> history;
+    // indices into the shard's spectators, and the keyframe the broadcasts are deltas against
+    std::vector<int> spectators;
+    ReplicatedState keyframe;
+    bool hasKeyframe;
+    bool active;
+    // when the next tick is due (each match keeps the phase it started with), and its timers in the shard's wheel
+    long long nextTickNs;
+    unsigned long long tickTimer, idleTimer;
+};
+
+struct MatchServer::Shard {
+    int index;
+    UdpSocket socket;
+    std::thread thread;
+    std::atomic<bool> alive;
+
+    float ballSpeed, barSpeed;
+    int maxScore;
+
+    // published once per tick for stats(), nothing else is shared with other threads
+    std::atomic<int> matchCount, playerCount;
+    std::atomic<unsigned long long> packetsIn, packetsOut, bytesOut, ticks, finished;
+    std::atomic<int> spectatorCount;
+    std::atomic<unsigned long long> broadcastFrames, broadcastPackets, broadcastSkipped;
+    std::atomic<long long> worstTickNs;
+
+    // everything below belongs to the shard's thread
+    std::vector<ServerMatch> matches;
+    std::vector<int> freeMatches;
+    // player key to match index * 2 + side
+    std::unordered_map<unsigned long long, int> players;
+    std::vector<Spectator> spectators;
+    std::vector<int> freeSpectators;
+    // spectator key to index in spectators
+    std::unordered_map<unsigned long long, int> spectatorKeys;
+    bool hasWaiting;
+    ServerPlayer waiting;
+    unsigned long long waitingTimer;
+    // match ticks, serve delays and idle timeouts
+    TimerWheel timers;
+    long long epochNs;
+    std::vector<ExpiredTimer> fired;
+    DatagramBatch batch;
+    unsigned int nextSeed;
+    unsigned long long localIn, localOut, localBytesOut, localTicks, localFinished;
+    unsigned long long localFrames, localBroadcast, localSkipped;
+
+    Shard() : alive(false), matchCount(0), playerCount(0), packetsIn(0), packetsOut(0), bytesOut(0), ticks(0), finished(0),
+        spectatorCount(0), broadcastFrames(0), broadcastPackets(0), broadcastSkipped(0), worstTickNs(0) {
+        index = 0;
+        ballSpeed = 1.0f;
+        barSpeed = 5.0f;
+        maxScore = 10;
+        hasWaiting = false;
+        waitingTimer = 0;
+        epochNs = 0;
+        nextSeed = 1;
+        localIn = localOut = localBytesOut = localTicks = localFinished = 0;
+        localFrames = localBroadcast = localSkipped = 0;
+    }
+};
+
+static long long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// players are told apart by where they send from and the id they picked
+static unsigned long long playerKey(const NetAddress& address, unsigned short id)
+{
+    return ((unsigned long long)address.ip << 32) | ((unsigned long long)address.port << 16) | id;
+}
+
+// the first wheel time at or after ns
+static unsigned long long wheelTime(const MatchServer::Shard& shard, long long ns)
+{
+    long long since = ns - shard.epochNs;
+    return since > 0 ? (unsigned long long)((since + WHEEL_UNIT_NS - 1) / WHEEL_UNIT_NS) : 0;
+}
+
+static unsigned long long scheduleTimer(MatchServer::Shard& shard, long long ns, int kind, int index)
+{
+    return shard.timers.schedule(wheelTime(shard, ns), ((unsigned long long)kind << 32) | (unsigned int)index);
+}
+
+static void sendTo(MatchServer::Shard& shard, const NetAddress& to, const unsigned char* packet, int length)
+{
+    shard.batch.queue(shard.socket, to, packet, length);
+    shard.localOut++;
+    shard.localBytesOut += length;
+}
+
+static void sendWelcome(MatchServer::Shard& shard, const ServerPlayer& player, int side)
+{
+    unsigned char packet[SERVER_PACKET_SIZE];
+    unsigned char* out = writeServerHeader(packet, SERVER_WELCOME, player.id);
+    writeU8(out, (unsigned char)side);
+    sendTo(shard, player.address, packet, (int)(out - packet));
+}
+
+static void sendEnd(MatchServer::Shard& shard, const NetAddress& to, unsigned short id, int status)
+{
+    unsigned char packet[SERVER_PACKET_SIZE];
+    unsigned char* out = writeServerHeader(packet, SERVER_END, id);
+    writeU8(out, (unsigned char)status);
+    sendTo(shard, to, packet, (int)(out - packet));
+}
+
+static void sendWatching(MatchServer::Shard& shard, const Spectator& spectator)
+{
+    unsigned char packet[SERVER_PACKET_SIZE];
+    unsigned char* out = writeServerHeader(packet, SERVER_WATCHING, spectator.id);
+    writeU32(out, (unsigned int)spectator.match);
+    sendTo(shard, spectator.address, packet, (int)(out - packet));
+}
+
+static void removeSpectator(MatchServer::Shard& shard, int index)
+{
+    Spectator& spectator = shard.spectators[index];
+    std::vector<int>& list = shard.matches[spectator.match].spectators;
+    int moved = list.back();
+    list[spectator.slot] = moved;
+    shard.spectators[moved].slot = spectator.slot;
+    list.pop_back();
+    shard.spectatorKeys.erase(playerKey(spectator.address, spectator.id));
+    shard.freeSpectators.push_back(index);
+}
+
+static void endMatch(MatchServer::Shard& shard, int index, int status)
+{
+    ServerMatch& match = shard.matches[index];
+    for (int side = 0; side < 2; side++) {
+        sendEnd(shard, match.players[side].address, match.players[side].id, status);
+        shard.players.erase(playerKey(match.players[side].address, match.players[side].id));
+    }
+    // spectators are told too, and can ask to watch another match
+    while (!match.spectators.empty()) {
+        const Spectator& spectator = shard.spectators[match.spectators.back()];
+        sendEnd(shard, spectator.address, spectator.id, status);
+        removeSpectator(shard, match.spectators.back());
+    }
+    match.active = false;
+    shard.timers.cancel(match.tickTimer);
+    shard.timers.cancel(match.idleTimer);
+    shard.freeMatches.push_back(index);
+    shard.localFinished++;
+}
+
+static void join(MatchServer::Shard& shard, const ServerPlayer& player)
+{
+    unsigned long long key = playerKey(player.address, player.id);
+    std::unordered_map<unsigned long long, int>::iterator found = shard.players.find(key);
+    if (found != shard.players.end()) {
+        // already playing, our welcome must have been lost
+        sendWelcome(shard, player, found->second & 1);
+        return;
+    }
+    if (shard.hasWaiting && playerKey(shard.waiting.address, shard.waiting.id) == key) {
+        shard.waiting.lastHeard = player.lastHeard;
+        return;
+    }
+    if (!shard.hasWaiting) {
+        shard.waiting = player;
+        shard.hasWaiting = true;
+        shard.waitingTimer = scheduleTimer(shard, player.lastHeard + TIMEOUT_NS, TIMER_WAITING, 0);
+        return;
+    }
+
+    // two players waiting: start a match, reusing a finished one's slot if there is one
+    int index;
+    if (shard.freeMatches.empty()) {
+        index = (int)shard.matches.size();
+        shard.matches.push_back(ServerMatch());
+    }
+    else {
+        index = shard.freeMatches.back();
+        shard.freeMatches.pop_back();
+    }
+    ServerMatch& match = shard.matches[index];
+    match.sim = PongSim();
+    match.sim.seed(shard.nextSeed++);
+    match.sim.setGameParameters(shard.ballSpeed, shard.barSpeed, shard.maxScore);
+    match.sim.setTimeDelta(1.0f / MatchServer::TICK_RATE);
+    match.sim.resetGame(true);
+    match.players[0] = shard.waiting;
+    match.players[1] = player;
+    match.history = StateRing<ReplicatedState, REPLICATION_HISTORY>();
+    match.spectators.clear();
+    match.hasKeyframe = false;
+    for (int side = 0; side < 2; side++) {
+        match.players[side].direction = 0;
+        match.players[side].acked = false;
+    }
+    match.active = true;
+    shard.hasWaiting = false;
+    shard.timers.cancel(shard.waitingTimer);
+    // the first tick one period from now, so matches that start at different moments tick at different moments
+    match.nextTickNs = player.lastHeard + TICK_NS;
+    match.tickTimer = scheduleTimer(shard, match.nextTickNs, TIMER_TICK, index);
+    match.idleTimer = scheduleTimer(shard, player.lastHeard + TIMEOUT_NS, TIMER_IDLE, index);
+
+    for (int side = 0; side < 2; side++) {
+        shard.players[playerKey(match.players[side].address, match.players[side].id)] = index * 2 + side;
+        sendWelcome(shard, match.players[side], side);
+    }
+}
+
+static void watch(MatchServer::Shard& shard, const NetAddress& from, unsigned short id, unsigned int wanted, long long now)
+{
+    unsigned long long key = playerKey(from, id);
+    std::unordered_map<unsigned long long, int>::iterator found = shard.spectatorKeys.find(key);
+    if (found != shard.spectatorKeys.end()) {
+        // already watching, our reply must have been lost
+        shard.spectators[found->second].lastHeard = now;
+        sendWatching(shard, shard.spectators[found->second]);
+        return;
+    }
+    // the match asked for, or the next one being played. With none the spectator simply asks again later
+    int count = (int)shard.matches.size();
+    for (int i = 0; i < count; i++) {
+        int index = (int)((wanted + (unsigned int)i) % (unsigned int)count);
+        ServerMatch& match = shard.matches[index];
+        if (!match.active) {
+            continue;
+        }
+        int slot;
+        if (shard.freeSpectators.empty()) {
+            slot = (int)shard.spectators.size();
+            shard.spectators.push_back(Spectator());
+        }
+        else {
+            slot = shard.freeSpectators.back();
+            shard.freeSpectators.pop_back();
+        }
+        Spectator& spectator = shard.spectators[slot];
+        spectator.address = from;
+        spectator.id = id;
+        spectator.match = index;
+        spectator.slot = (int)match.spectators.size();
+        spectator.lastHeard = now;
+        spectator.ackedTick = 0;
+        spectator.watchedTick = (unsigned int)match.sim.tick;
+        spectator.acked = false;
+        match.spectators.push_back(slot);
+        shard.spectatorKeys[key] = slot;
+        // the next broadcast is a keyframe, so the newcomer can start straight away
+        match.hasKeyframe = false;
+        sendWatching(shard, spectator);
+        return;
+    }
+}
+
+static void handleSpectatorPacket(MatchServer::Shard& shard, const NetAddress& from, unsigned short id, int type, const unsigned char* in, int length, long long now)
+{
+    std::unordered_map<unsigned long long, int>::iterator found = shard.spectatorKeys.find(playerKey(from, id));
+    if (found == shard.spectatorKeys.end()) {
+        return;
+    }
+    Spectator& spectator = shard.spectators[found->second];
+    spectator.lastHeard = now;
+    if (type == SERVER_ACK && length >= SERVER_HEADER_SIZE + 4) {
+        unsigned int tick = readU32(in);
+        if ((!spectator.acked || tick > spectator.ackedTick) && tick <= (unsigned int)shard.matches[spectator.match].sim.tick) {
+            spectator.ackedTick = tick;
+            spectator.acked = true;
+        }
+    }
+    else if (type == SERVER_LEAVE) {
+        removeSpectator(shard, found->second);
+    }
+}
+
+static void handlePacket(MatchServer::Shard& shard, const NetAddress& from, const unsigned char* data, int length, long long now)
+{
+    const unsigned char* in = data;
+    int type;
+    unsigned short id;
+    if (!readServerHeader(in, length, &type, &id)) {
+        return;
+    }
+    shard.localIn++;
+
+    if (type == SERVER_JOIN) {
+        ServerPlayer player;
+        player.address = from;
+        player.id = id;
+        player.direction = 0;
+        player.lastHeard = now;
+        player.ackedTick = 0;
+        player.acked = false;
+        join(shard, player);
+        return;
+    }
+    if (type == SERVER_WATCH) {
+        if (length >= SERVER_HEADER_SIZE + 4) {
+            watch(shard, from, id, readU32(in), now);
+        }
+        return;
+    }
+
+    std::unordered_map<unsigned long long, int>::iterator found = shard.players.find(playerKey(from, id));
+    if (found == shard.players.end()) {
+        handleSpectatorPacket(shard, from, id, type, in, length, now);
+        return;
+    }
+    int index = found->second >> 1;
+    ServerPlayer& player = shard.matches[index].players[found->second & 1];
+    player.lastHeard = now;
+    if (type == SERVER_INPUT && length >= SERVER_HEADER_SIZE + 1) {
+        int direction = (signed char)readU8(in);
+        player.direction = (signed char)(direction > 0 ? 1 : (direction < 0 ? -1 : 0));
+    }
+    else if (type == SERVER_ACK && length >= SERVER_HEADER_SIZE + 4) {
+        unsigned int tick = readU32(in);
+        if ((!player.acked || tick > player.ackedTick) && tick <= (unsigned int)shard.matches[index].sim.tick) {
+            player.ackedTick = tick;
+            player.acked = true;
+        }
+    }
+    else if (type == SERVER_LEAVE) {
+        endMatch(shard, index, SERVER_END_ABANDONED);
+    }
+}
+
+static void receiveAll(MatchServer::Shard& shard, long long now)
+{
+    int count;
+    do {
+        count = shard.batch.receive(shard.socket);
+        for (int i = 0; i < count; i++) {
+            handlePacket(shard, shard.batch.from(i), shard.batch.data(i), shard.batch.length(i), now);
+        }
+    } while (count == DatagramBatch::SIZE);
+}
+
+// idle timers are not moved every time a packet arrives: when one goes off we look at when the players were last
+// heard from, and either end the match or set it again for the earliest moment one of them could time out
+static void checkIdle(MatchServer::Shard& shard, int index, long long now)
+{
+    ServerMatch& match = shard.matches[index];
+    long long oldest = match.players[0].lastHeard < match.players[1].lastHeard ? match.players[0].lastHeard : match.players[1].lastHeard;
+    if (now - oldest > TIMEOUT_NS) {
+        endMatch(shard, index, SERVER_END_ABANDONED);
+    }
+    else {
+        match.idleTimer = scheduleTimer(shard, oldest + TIMEOUT_NS + 1, TIMER_IDLE, index);
+    }
+}
+
+static void checkWaiting(MatchServer::Shard& shard, long long now)
+{
+    if (now - shard.waiting.lastHeard > TIMEOUT_NS) {
+        shard.hasWaiting = false;
+    }
+    else {
+        shard.waitingTimer = scheduleTimer(shard, shard.waiting.lastHeard + TIMEOUT_NS + 1, TIMER_WAITING, 0);
+    }
+}
+
+/* serializes state once and queues the same bytes for every spectator of the match*/
+static void broadcast(MatchServer::Shard& shard, int index, const ReplicatedState& state, long long now)
+{
+    ServerMatch& match = shard.matches[index];
+    bool keyframe = !match.hasKeyframe || state.tick - match.keyframe.tick >= (unsigned int)MatchServer::KEYFRAME_TICKS;
+    if (keyframe) {
+        match.keyframe = state;
+        match.hasKeyframe = true;
+    }
+    unsigned char packet[SERVER_PACKET_SIZE];
+    unsigned char* out = writeServerHeader(packet, SERVER_BROADCAST, 0);
+    writeU32(out, (unsigned int)index);
+    out += encodeState(keyframe ? nullptr : &match.keyframe, state, out);
+    SharedPacket* shared = SharedPacket::create(packet, (int)(out - packet));
+    shard.localFrames++;
+
+    // backwards, so a spectator that timed out can be swapped out of the list without skipping anyone
+    for (int i = (int)match.spectators.size() - 1; i >= 0; i--) {
+        int spectatorIndex = match.spectators[i];
+        Spectator& spectator = shard.spectators[spectatorIndex];
+        if (now - spectator.lastHeard > TIMEOUT_NS) {
+            // in case it is still there and only its acknowledgements got lost, it can ask to watch again
+            sendEnd(shard, spectator.address, spectator.id, SERVER_END_ABANDONED);
+            removeSpectator(shard, spectatorIndex);
+            continue;
+        }
+        unsigned int since = spectator.acked ? spectator.ackedTick : spectator.watchedTick;
+        if (!keyframe && state.tick - since > (unsigned int)MatchServer::SPECTATOR_LAG_TICKS) {
+            shard.localSkipped++;
+            continue;
+        }
+        shard.batch.queueShared(shard.socket, spectator.address, shared);
+        shard.localOut++;
+        shard.localBroadcast++;
+        shard.localBytesOut += shared->length();
+    }
+    shared->release();
+}
+
+static void tickMatch(MatchServer::Shard& shard, int index, long long now)
+{
+    ServerMatch& match = shard.matches[index];
+    bool goal = match.sim.step(match.players[0].direction, match.players[1].direction) != 0;
+    ReplicatedState state = replicate(match.sim);
+    match.history.save(state.tick, state);
+
+    for (int side = 0; side < 2; side++) {
+        ServerPlayer& player = match.players[side];
+        // a delta against what the player last acknowledged, or everything if that is too old
+        ReplicatedState base;
+        bool haveBase = player.acked && state.tick - player.ackedTick <= (unsigned int)REPLICATION_WINDOW &&
+            state.tick != player.ackedTick && match.history.restore(player.ackedTick, &base);
+        unsigned char packet[SERVER_PACKET_SIZE];
+        unsigned char* out = writeServerHeader(packet, SERVER_STATE, player.id);
+        out += encodeState(haveBase ? &base : nullptr, state, out);
+        sendTo(shard, player.address, packet, (int)(out - packet));
+    }
+    if (!match.spectators.empty()) {
+        broadcast(shard, index, state, now);
+    }
+    shard.localTicks++;
+
+    int status = match.sim.gameStatus();
+    if (status != 0) {
+        endMatch(shard, index, status);
+        return;
+    }
+    // after a goal the ball waits at the centre for the serve delay before the match carries on
+    match.nextTickNs += goal ? MatchServer::SERVE_DELAY_MS * 1000000LL : TICK_NS;
+    if (match.nextTickNs < now - MAX_CATCHUP_TICKS * TICK_NS) {
+        match.nextTickNs = now;
+    }
+    match.tickTimer = scheduleTimer(shard, match.nextTickNs, TIMER_TICK, index);
+}
+
+/* handles every timer due by now. Returns how many match ticks that was*/
+static int runTimers(MatchServer::Shard& shard, long long now)
+{
+    int ticks = 0;
+    shard.fired.clear();
+    shard.timers.advance((unsigned long long)((now - shard.epochNs) / WHEEL_UNIT_NS), shard.fired);
+    for (const ExpiredTimer& timer : shard.fired) {
+        int index = (int)(timer.data & 0xFFFFFFFFu);
+        int kind = (int)(timer.data >> 32);
+        // a match ended earlier in this batch can still have a timer in it
+        if (kind != TIMER_WAITING && !shard.matches[index].active) {
+            continue;
+        }
+        switch (kind) {
+        case TIMER_TICK:
+            tickMatch(shard, index, now);
+            ticks++;
+            break;
+        case TIMER_IDLE:
+            checkIdle(shard, index, now);
+            break;
+        case TIMER_WAITING:
+            checkWaiting(shard, now);
+            break;
+        }
+    }
+    return ticks;
+}
+
+/* makes this tick's counters visible to stats()*/
+static void publishCounters(MatchServer::Shard& shard, long long tickNs)
+{
+    shard.matchCount.store((int)(shard.matches.size() - shard.freeMatches.size()), std::memory_order_relaxed);
+    shard.playerCount.store((int)shard.players.size() + (shard.hasWaiting ? 1 : 0), std::memory_order_relaxed);
+    shard.packetsIn.store(shard.localIn, std::memory_order_relaxed);
+    shard.packetsOut.store(shard.localOut, std::memory_order_relaxed);
+    shard.bytesOut.store(shard.localBytesOut, std::memory_order_relaxed);
+    shard.ticks.store(shard.localTicks, std::memory_order_relaxed);
+    shard.finished.store(shard.localFinished, std::memory_order_relaxed);
+    shard.spectatorCount.store((int)shard.spectatorKeys.size(), std::memory_order_relaxed);
+    shard.broadcastFrames.store(shard.localFrames, std::memory_order_relaxed);
+    shard.broadcastPackets.store(shard.localBroadcast, std::memory_order_relaxed);
+    shard.broadcastSkipped.store(shard.localSkipped, std::memory_order_relaxed);
+    long long worst = shard.worstTickNs.load(std::memory_order_relaxed);
+    while (tickNs > worst && !shard.worstTickNs.compare_exchange_weak(worst, tickNs, std::memory_order_relaxed)) {
+    }
+}
+
+MatchServer::MatchServer()
+{
+}
+
+MatchServer::~MatchServer()
+{
+    stop();
+}
+
+bool MatchServer::start(unsigned short port, int shardCount, float ballSpeed, float barSpeed, int maxScore)
+{
+    stop();
+#ifdef __linux__
+    if (shardCount <= 0) {
+        shardCount = (int)std::thread::hardware_concurrency();
+    }
+    if (shardCount <= 0) {
+        shardCount = 1;
+    }
+#else
+    // without SO_REUSEPORT only one socket can own the port
+    shardCount = 1;
+#endif
+    for (int i = 0; i < shardCount; i++) {
+        Shard* shard = new Shard();
+        shard->index = i;
+        shard->ballSpeed = ballSpeed;
+        shard->barSpeed = barSpeed;
+        shard->maxScore = maxScore;
+        shards.push_back(shard);
+        if (!shard->socket.open(port, true)) {
+            stop();
+            return false;
+        }
+    }
+    for (Shard* shard : shards) {
+        shard->alive.store(true);
+        shard->thread = std::thread(&MatchServer::runShard, shard);
+    }
+    return true;
+}
+
+void MatchServer::stop()
+{
+    for (Shard* shard : shards) {
+        shard->alive.store(false);
+    }
+    for (Shard* shard : shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+        delete shard;
+    }
+    shards.clear();
+}
+
+ServerStats MatchServer::stats()
+{
+    ServerStats total;
+    total.matches = 0;
+    total.players = 0;
+    total.packetsIn = 0;
+    total.packetsOut = 0;
+    total.bytesOut = 0;
+    total.ticks = 0;
+    total.worstTickMs = 0.0f;
+    total.matchesFinished = 0;
+    total.spectators = 0;
+    total.broadcastFrames = 0;
+    total.broadcastPackets = 0;
+    total.broadcastSkipped = 0;
+    for (Shard* shard : shards) {
+        total.matches += shard->matchCount.load(std::memory_order_relaxed);
+        total.players += shard->playerCount.load(std::memory_order_relaxed);
+        total.packetsIn += shard->packetsIn.load(std::memory_order_relaxed);
+        total.packetsOut += shard->packetsOut.load(std::memory_order_relaxed);
+        total.bytesOut += shard->bytesOut.load(std::memory_order_relaxed);
+        total.ticks += shard->ticks.load(std::memory_order_relaxed);
+        total.matchesFinished += shard->finished.load(std::memory_order_relaxed);
+        total.spectators += shard->spectatorCount.load(std::memory_order_relaxed);
+        total.broadcastFrames += shard->broadcastFrames.load(std::memory_order_relaxed);
+        total.broadcastPackets += shard->broadcastPackets.load(std::memory_order_relaxed);
+        total.broadcastSkipped += shard->broadcastSkipped.load(std::memory_order_relaxed);
+        float worst = shard->worstTickNs.exchange(0, std::memory_order_relaxed) / 1000000.0f;
+        if (worst > total.worstTickMs) {
+            total.worstTickMs = worst;
+        }
+    }
+    return total;
+}
+
+int MatchServer::shardCount() const
+{
+    return (int)shards.size();
+}
+
+void MatchServer::runShard(Shard* shard)
+{
+    shard->epochNs = nowNs();
+    shard->timers = TimerWheel();
+#ifdef __linux__
+    // one shard per core, and keep it there so its matches stay in that core's cache
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(shard->index % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    int epoll = epoll_create1(0);
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (epoll < 0 || timer < 0) {
+        std::cout << "FAILED::CREATING::EPOLL::SHARD: " << shard->index << std::endl;
+        if (epoll >= 0) {
+            close(epoll);
+        }
+        return;
+    }
+    // the timer wheel's resolution, every match ticks on its own schedule within it
+    itimerspec interval;
+    interval.it_interval.tv_sec = 0;
+    interval.it_interval.tv_nsec = WHEEL_UNIT_NS;
+    interval.it_value = interval.it_interval;
+    timerfd_settime(timer, 0, &interval, nullptr);
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = 0;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, (int)shard->socket.nativeHandle(), &event);
+    event.data.u32 = 1;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event);
+
+    while (shard->alive.load(std::memory_order_relaxed)) {
+        epoll_event ready[2];
+        // the timeout only matters for noticing stop()
+        int count = epoll_wait(epoll, ready, 2, 100);
+        long long now = nowNs();
+        for (int i = 0; i < count; i++) {
+            if (ready[i].data.u32 == 0) {
+                receiveAll(*shard, now);
+            }
+            else {
+                unsigned long long expirations = 0;
+                if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                    continue;
+                }
+                runTimers(*shard, now);
+                shard->batch.flush(shard->socket);
+                publishCounters(*shard, nowNs() - now);
+            }
+        }
+        // welcomes and ends sent while handling packets
+        shard->batch.flush(shard->socket);
+    }
+    close(timer);
+    close(epoll);
+#else
+    while (shard->alive.load(std::memory_order_relaxed)) {
+        long long now = nowNs();
+        receiveAll(*shard, now);
+        runTimers(*shard, now);
+        shard->batch.flush(shard->socket);
+        publishCounters(*shard, nowNs() - now);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+}
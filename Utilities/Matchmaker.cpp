@@ -0,0 +1,311 @@
+#include "../Includes/Matchmaker.hpp"
+#include <algorithm>
+#include <chrono>
+// Matchmaker.cpp holds logic for pairing players who want a match by skill and latency
+
+// most requests filed before the pairing thread looks at its other work
+static const int BATCH = 1024;
+
+// how often players who waited long are offered the neighbouring buckets
+static const long long WIDEN_PASS_NS = 100000000LL;
+
+// how long the pairing thread sleeps when there is nothing to do
+static const long long IDLE_SLEEP_NS = 50000LL;
+
+static const int LATENCY_LIMITS[Matchmaker::LATENCY_BANDS - 1] = { 30, 60, 100, 160 };
+
+static const int NONE = -1;
+
+// the histogram bucket of a duration: its bit length in microseconds
+static int histogramBucket(long long ns, int size)
+{
+    unsigned long long us = ns > 0 ? (unsigned long long)(ns / 1000) : 0;
+    int bucket = 0;
+    while (us > 0 && bucket < size - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// copies a histogram out and empties it
+static void takeHistogram(std::atomic<unsigned int>* histogram, unsigned int* counts, int size)
+{
+    for (int i = 0; i < size; i++) {
+        counts[i] = histogram[i].exchange(0, std::memory_order_relaxed);
+    }
+}
+
+// the upper bound (in microseconds) of the bucket the fraction-th value falls in
+static float percentile(const unsigned int* counts, int size, float fraction)
+{
+    unsigned long long total = 0;
+    for (int i = 0; i < size; i++) {
+        total += counts[i];
+    }
+    unsigned long long running = 0;
+    for (int i = 0; i < size && total > 0; i++) {
+        running += counts[i];
+        if (running >= (unsigned long long)(fraction * total)) {
+            return (float)(1ULL << i);
+        }
+    }
+    return 0.0f;
+}
+
+Matchmaker::Matchmaker()
+    : alive(false), submitted(0), rejected(0), paired(0), waitingCount(0), queueMaxNs(0)
+{
+    for (int i = 0; i < HISTOGRAM_SIZE; i++) {
+        queueHistogram[i].store(0, std::memory_order_relaxed);
+        waitHistogram[i].store(0, std::memory_order_relaxed);
+    }
+    freeList = NONE;
+    waitingPlayers = 0;
+    pairedCount = 0;
+    first.assign(SKILL_BUCKETS * LATENCY_BANDS, NONE);
+    last.assign(SKILL_BUCKETS * LATENCY_BANDS, NONE);
+}
+
+Matchmaker::~Matchmaker()
+{
+    stop();
+}
+
+void Matchmaker::start()
+{
+    if (alive.load()) {
+        return;
+    }
+    alive.store(true);
+    thread = std::thread(&Matchmaker::run, this);
+}
+
+void Matchmaker::stop()
+{
+    alive.store(false);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool Matchmaker::submit(const JoinRequest& request)
+{
+    if (!requests.push(request)) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool Matchmaker::nextPairing(Pairing* pairing)
+{
+    return pairings.pop(*pairing);
+}
+
+MatchmakerStats Matchmaker::stats()
+{
+    MatchmakerStats stats;
+    stats.submitted = submitted.load(std::memory_order_relaxed);
+    stats.rejected = rejected.load(std::memory_order_relaxed);
+    stats.paired = paired.load(std::memory_order_relaxed);
+    stats.waiting = waitingCount.load(std::memory_order_relaxed);
+    unsigned int counts[HISTOGRAM_SIZE];
+    takeHistogram(queueHistogram, counts, HISTOGRAM_SIZE);
+    stats.queueP50Us = percentile(counts, HISTOGRAM_SIZE, 0.5f);
+    stats.queueP99Us = percentile(counts, HISTOGRAM_SIZE, 0.99f);
+    stats.queueMaxUs = (float)queueMaxNs.exchange(0, std::memory_order_relaxed) / 1000.0f;
+    takeHistogram(waitHistogram, counts, HISTOGRAM_SIZE);
+    stats.waitP50Ms = percentile(counts, HISTOGRAM_SIZE, 0.5f) / 1000.0f;
+    stats.waitP99Ms = percentile(counts, HISTOGRAM_SIZE, 0.99f) / 1000.0f;
+    return stats;
+}
+
+long long Matchmaker::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Matchmaker::run()
+{
+    long long lastWiden = now();
+    while (alive.load(std::memory_order_relaxed)) {
+        long long time = now();
+        int filed = 0;
+        JoinRequest request;
+        long long worstQueue = 0;
+        while (filed < BATCH && requests.pop(request)) {
+            long long queued = time - request.submitted;
+            queueHistogram[histogramBucket(queued, HISTOGRAM_SIZE)].fetch_add(1, std::memory_order_relaxed);
+            if (queued > worstQueue) {
+                worstQueue = queued;
+            }
+            place(request, time);
+            filed++;
+        }
+        if (filed > 0) {
+            submitted.fetch_add(filed, std::memory_order_relaxed);
+            long long worst = queueMaxNs.load(std::memory_order_relaxed);
+            while (worstQueue > worst && !queueMaxNs.compare_exchange_weak(worst, worstQueue, std::memory_order_relaxed)) {
+            }
+        }
+
+        // whatever the reader had no room for last time goes first, to keep pairings in order
+        size_t sent = 0;
+        while (sent < overflow.size() && pairings.push(overflow[sent])) {
+            sent++;
+        }
+        overflow.erase(overflow.begin(), overflow.begin() + sent);
+
+        if (time - lastWiden >= WIDEN_PASS_NS) {
+            widen(time);
+            lastWiden = time;
+        }
+        waitingCount.store(waitingPlayers, std::memory_order_relaxed);
+        paired.store(pairedCount, std::memory_order_relaxed);
+
+        if (filed == 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(IDLE_SLEEP_NS));
+        }
+    }
+}
+
+int Matchmaker::bucketOf(const JoinRequest& request) const
+{
+    int skill = request.skill / SKILL_STEP;
+    if (skill < 0) {
+        skill = 0;
+    }
+    if (skill >= SKILL_BUCKETS) {
+        skill = SKILL_BUCKETS - 1;
+    }
+    int band = 0;
+    while (band < LATENCY_BANDS - 1 && request.latencyMs >= LATENCY_LIMITS[band]) {
+        band++;
+    }
+    return band * SKILL_BUCKETS + skill;
+}
+
+void Matchmaker::place(const JoinRequest& request, long long now)
+{
+    int bucket = bucketOf(request);
+    int partner = first[bucket];
+    if (partner != NONE) {
+        JoinRequest waiting = pool[partner].request;
+        removeWaiting(partner);
+        emit(waiting, request, now);
+        return;
+    }
+    addWaiting(request, bucket);
+}
+
+void Matchmaker::widen(long long now)
+{
+    for (int bucket = 0; bucket < SKILL_BUCKETS * LATENCY_BANDS; bucket++) {
+        int skill = bucket % SKILL_BUCKETS;
+        int band = bucket / SKILL_BUCKETS;
+        int index = first[bucket];
+        while (index != NONE) {
+            int next = pool[index].next;
+            long long waited = now - pool[index].request.submitted;
+            // the list is oldest first, so nobody after this one has waited long enough either
+            if (waited < WIDEN_MS * 1000000LL) {
+                break;
+            }
+            // past the far edge there is nothing more to reach, and the loops below run once per step of it
+            int reach = (int)std::min(waited / (WIDEN_MS * 1000000LL), (long long)(SKILL_BUCKETS - 1));
+            int bandReach = std::min(reach / 2, LATENCY_BANDS - 1);
+
+            // the closest bucket with someone in it: nearest skill first, then nearest latency
+            int partner = NONE;
+            for (int distance = 0; distance <= reach && partner == NONE; distance++) {
+                for (int bandDistance = 0; bandDistance <= bandReach && partner == NONE; bandDistance++) {
+                    if (distance == 0 && bandDistance == 0) {
+                        continue;
+                    }
+                    const int SIGNS[2] = { -1, 1 };
+                    for (int s = 0; s < 2 && partner == NONE; s++) {
+                        for (int b = 0; b < 2 && partner == NONE; b++) {
+                            int otherSkill = skill + SIGNS[s] * distance;
+                            int otherBand = band + SIGNS[b] * bandDistance;
+                            if (otherSkill < 0 || otherSkill >= SKILL_BUCKETS || otherBand < 0 || otherBand >= LATENCY_BANDS) {
+                                continue;
+                            }
+                            partner = first[otherBand * SKILL_BUCKETS + otherSkill];
+                        }
+                    }
+                }
+            }
+            if (partner != NONE) {
+                // partner is in another bucket, so next is still valid after both are taken out
+                JoinRequest a = pool[index].request;
+                JoinRequest b = pool[partner].request;
+                removeWaiting(index);
+                removeWaiting(partner);
+                emit(a, b, now);
+            }
+            index = next;
+        }
+    }
+}
+
+void Matchmaker::emit(const JoinRequest& a, const JoinRequest& b, long long now)
+{
+    Pairing pairing;
+    pairing.players[0] = a;
+    pairing.players[1] = b;
+    pairing.paired = now;
+    if (!overflow.empty() || !pairings.push(pairing)) {
+        overflow.push_back(pairing);
+    }
+    waitHistogram[histogramBucket(now - a.submitted, HISTOGRAM_SIZE)].fetch_add(1, std::memory_order_relaxed);
+    waitHistogram[histogramBucket(now - b.submitted, HISTOGRAM_SIZE)].fetch_add(1, std::memory_order_relaxed);
+    pairedCount++;
+}
+
+int Matchmaker::addWaiting(const JoinRequest& request, int bucket)
+{
+    int index;
+    if (freeList != NONE) {
+        index = freeList;
+        freeList = pool[index].next;
+    }
+    else {
+        index = (int)pool.size();
+        pool.push_back(Waiting());
+    }
+    Waiting& waiting = pool[index];
+    waiting.request = request;
+    waiting.bucket = bucket;
+    waiting.next = NONE;
+    waiting.prev = last[bucket];
+    if (last[bucket] != NONE) {
+        pool[last[bucket]].next = index;
+    }
+    else {
+        first[bucket] = index;
+    }
+    last[bucket] = index;
+    waitingPlayers++;
+    return index;
+}
+
+void Matchmaker::removeWaiting(int index)
+{
+    Waiting& waiting = pool[index];
+    if (waiting.prev != NONE) {
+        pool[waiting.prev].next = waiting.next;
+    }
+    else {
+        first[waiting.bucket] = waiting.next;
+    }
+    if (waiting.next != NONE) {
+        pool[waiting.next].prev = waiting.prev;
+    }
+    else {
+        last[waiting.bucket] = waiting.prev;
+    }
+    waiting.next = freeList;
+    freeList = index;
+    waitingPlayers--;
+}
@@ -0,0 +1,139 @@
+#include "../Includes/MultiMatchRenderer.hpp"
+#include "../Includes/Shader.hpp"
+#include "../Includes/Meshes.hpp"
+#include <glad/glad.h>
+#include <cmath>
+// MultiMatchRenderer.cpp holds logic for drawing a grid of matches with a single instanced draw call
+
+// sizes and positions of the objects in a match, these match the quads PongState draws
+static const glm::vec2 BAR_DIMS = glm::vec2(BAR_WIDTH, BAR_HEIGHT);
+static const glm::vec2 BALL_DIMS = glm::vec2(BALL_SIZE, BALL_SIZE);
+static const glm::vec2 DIGIT_DIMS = glm::vec2(DIGIT_SIZE, DIGIT_SIZE);
+static const glm::vec2 LEFT_SCORE_POS = glm::vec2(-0.4f, 0.7f);
+static const glm::vec2 RIGHT_SCORE_POS = glm::vec2(0.4f, 0.7f);
+
+// fraction of each cell the match takes up, the rest is a gap between cells
+static const float CELL_FILL = 0.94f;
+
+MultiMatchRenderer::MultiMatchRenderer(GpuResourceManager* resources, int maxMatches)
+{
+    this->maxMatches = maxMatches;
+    drawCalls = 0;
+    instanceCount = 0;
+    instances.resize((size_t)maxMatches * QUADS_PER_MATCH * INSTANCE_FLOATS);
+
+    Shader shader("Vertex_Shaders/instanced_shader.vs", "Fragment_Shaders/instanced_shader.fs");
+    program = OwnedProgram(resources, resources->adoptProgram(shader.ID));
+    scoreTexture = OwnedTexture(resources, resources->loadTexture("Textures/characters.bmp"));
+
+    // unit quad with its top left corner at the origin (same convention as the positions in the simulation)
+    float quad[8] = {
+        0.0f, -1.0f, // bottom left
+        1.0f, -1.0f, // bottom right
+        0.0f, 0.0f,  // top left
+        1.0f, 0.0f   // top right
+    };
+
+    quadVAO = OwnedVertexArray(resources, resources->createVertexArray());
+    glBindVertexArray(quadVAO.name());
+
+    quadVBO = OwnedBuffer(resources, resources->createBuffer(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW));
+    glEnableVertexAttribArray(0); //position
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)(0));
+
+    quadEBO = OwnedBuffer(resources, resources->createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(QUAD_INDICES), QUAD_INDICES, GL_STATIC_DRAW));
+
+    // per instance attributes advance once per quad instead of once per vertex
+    instanceVBO = OwnedBuffer(resources, resources->createBuffer(GL_ARRAY_BUFFER, instances.size() * sizeof(float), nullptr, GL_STREAM_DRAW));
+    GLsizei stride = INSTANCE_FLOATS * sizeof(float);
+    glEnableVertexAttribArray(1); //rect
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(0));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2); //texture rect
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3); //color
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+    glVertexAttribDivisor(3, 1);
+
+    glBindVertexArray(0);
+}
+
+void MultiMatchRenderer::pushQuad(glm::vec2 cellPos, glm::vec2 cellScale, glm::vec2 topLeft, glm::vec2 size, glm::vec4 texRect, glm::vec3 color)
+{
+    float* instance = instances.data() + (size_t)instanceCount * INSTANCE_FLOATS;
+    instance[0] = cellPos.x + topLeft.x * cellScale.x;
+    instance[1] = cellPos.y + topLeft.y * cellScale.y;
+    instance[2] = size.x * cellScale.x;
+    instance[3] = size.y * cellScale.y;
+    instance[4] = texRect.x;
+    instance[5] = texRect.y;
+    instance[6] = texRect.z;
+    instance[7] = texRect.w;
+    instance[8] = color.x;
+    instance[9] = color.y;
+    instance[10] = color.z;
+    instanceCount++;
+}
+
+void MultiMatchRenderer::draw(const PongSnapshot* snapshots, int count, int columns)
+{
+    if (count > maxMatches) {
+        count = maxMatches;
+    }
+    drawCalls = 0;
+    if (count <= 0 || columns <= 0) {
+        return;
+    }
+    int rows = (count + columns - 1) / columns;
+
+    // every cell maps the match's [-1, 1] square onto its own part of the screen
+    glm::vec2 cellSize = glm::vec2(2.0f / columns, 2.0f / rows);
+    glm::vec2 cellScale = cellSize * (0.5f * CELL_FILL);
+    glm::vec4 untextured = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 red = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 white = glm::vec3(1.0f, 1.0f, 1.0f);
+    glm::vec3 backdrop = glm::vec3(0.9f, 0.9f, 0.9f);
+
+    instanceCount = 0;
+    for (int i = 0; i < count; i++) {
+        const PongSnapshot& match = snapshots[i];
+        // center of the cell, filling rows from the top left of the screen
+        glm::vec2 cellPos = glm::vec2(-1.0f + (i % columns + 0.5f) * cellSize.x, 1.0f - (i / columns + 0.5f) * cellSize.y);
+
+        pushQuad(cellPos, cellScale, glm::vec2(-1.0f, 1.0f), glm::vec2(2.0f, 2.0f), untextured, backdrop);
+        pushQuad(cellPos, cellScale, match.leftBarPos, BAR_DIMS, untextured, red);
+        pushQuad(cellPos, cellScale, match.rightBarPos, BAR_DIMS, untextured, red);
+        pushQuad(cellPos, cellScale, match.ballPos, BALL_DIMS, untextured, red);
+
+        int digits[4] = { (match.leftScore / 10) % 10, match.leftScore % 10, (match.rightScore / 10) % 10, match.rightScore % 10 };
+        for (int d = 0; d < 4; d++) {
+            glm::vec2 digitPos = (d < 2 ? LEFT_SCORE_POS : RIGHT_SCORE_POS) + glm::vec2((d % 2) * DIGIT_DIMS.x, 0.0f);
+            glm::vec4 glyph = glm::vec4(DIGIT_GLYPHS.u[digits[d]], DIGIT_ROW, GLYPH_SIZE, GLYPH_SIZE);
+            pushQuad(cellPos, cellScale, digitPos, DIGIT_DIMS, glyph, white);
+        }
+    }
+
+    // orphan the old storage so we never wait on the gpu still reading last frame's instances
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO.name());
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)instanceCount * INSTANCE_FLOATS * sizeof(float), instances.data());
+
+    glUseProgram(program.name());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scoreTexture.name());
+    glBindVertexArray(quadVAO.name());
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, instanceCount);
+    glBindVertexArray(0);
+    drawCalls++;
+}
+
+void MultiMatchRenderer::destroy()
+{
+    instanceVBO.reset();
+    quadEBO.reset();
+    quadVBO.reset();
+    quadVAO.reset();
+    scoreTexture.reset();
+    program.reset();
+}
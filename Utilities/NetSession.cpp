@@ -0,0 +1,684 @@
+#include "../Includes/NetSession.hpp"
+#include "../Includes/ByteIO.hpp"
+#include "../Includes/StateHash.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+// NetSession.cpp holds logic for two player matches over udp with prediction and rollback
+
+// every packet starts with these two bytes and a type byte, anything else on the port is ignored
+static const unsigned short PACKET_MAGIC = 0x4E50;
+enum PacketType { PACKET_HELLO = 1, PACKET_WELCOME = 2, PACKET_INPUT = 3, PACKET_BYE = 4 };
+static const int HEADER_SIZE = 3;
+
+// most inputs one packet carries, a remote player missing more than this catches up over several packets
+static const int MAX_INPUTS_PER_PACKET = 100;
+
+// like SimThread, if we fall this far behind we skip ahead instead of fast forwarding
+static const int MAX_CATCHUP_TICKS = 5;
+
+// how often a joining player repeats its hello until the host answers
+static const long long HELLO_INTERVAL_NS = 100000000LL;
+
+// longest we sleep between looking at the socket
+static const long long POLL_NS = 1000000LL;
+
+// rollbackTick when no prediction has been found wrong
+static const unsigned int NO_ROLLBACK = 0xFFFFFFFFu;
+
+// ticks between steps of the lockstep input delay towards the remote player's request (growing is done at once)
+static const unsigned int ADAPT_INTERVAL = 30;
+
+// ticks ahead of the remote player we tolerate before slowing down, and the part of our lead we give back each tick
+static const float SYNC_THRESHOLD = 0.5f;
+static const float SYNC_GAIN = 1.0f / 16.0f;
+static const float MAX_SYNC_TICKS = 4.0f;
+
+// the smoothed tick advantage moves this much of the way to each new estimate
+static const float ADVANTAGE_GAIN = 1.0f / 8.0f;
+
+// wanted delay byte of a peer that has not measured enough yet
+static const unsigned char NO_DELAY_WANTED = 0xFF;
+
+NetSession::NetSession()
+    : alive(false)
+{
+    role = HOST;
+    input = nullptr;
+    seed = 0;
+    ballSpeed = 1.0f;
+    barSpeed = 5.0f;
+    maxScore = 10;
+    lockstep = false;
+    inputDelay = 0;
+    memset(&stats, 0, sizeof(stats));
+    stats.state = CONNECTING;
+    tick = 0;
+    nextTick = 0;
+    localSent = 0;
+    remoteConfirmed = 0;
+    remoteAcked = 0;
+    rollbackTick = NO_ROLLBACK;
+    endTick = 0;
+    confirmedInput = 0;
+    lastReceived = 0;
+    echoTime = 0;
+    echoReceived = 0;
+    nextHashTick = 1;
+    localChain = 0;
+    remoteHashTick = 0;
+    sequence = 0;
+    tickAdvantage = 0.0f;
+    remoteWantedDelay = -1;
+    lastAdapt = 0;
+    stallTick = NO_ROLLBACK;
+}
+
+NetSession::~NetSession()
+{
+    stop();
+}
+
+void NetSession::setInputQueue(InputQueue* input)
+{
+    this->input = input;
+}
+
+void NetSession::setLockstep(bool lockstep, int inputDelay)
+{
+    this->lockstep = lockstep;
+    if (inputDelay < 0) {
+        inputDelay = 0;
+    }
+    if (inputDelay > MAX_INPUT_DELAY) {
+        inputDelay = MAX_INPUT_DELAY;
+    }
+    this->inputDelay = inputDelay;
+}
+
+bool NetSession::start(Role role, unsigned short localPort, const char* remoteHost, unsigned short remotePort, const LinkConditions& conditions,
+    float ballSpeed, float barSpeed, int maxScore)
+{
+    if (alive.load()) {
+        return false;
+    }
+    this->role = role;
+    if (role == JOIN && !NetAddress::resolve(remoteHost, remotePort, &remote)) {
+        return false;
+    }
+    if (!socket.open(localPort)) {
+        return false;
+    }
+    // each side's packets get their own run of the seed
+    shim.configure(conditions, conditions.seed * 2 + (role == HOST ? 1u : 2u));
+
+    // the joining player's settings are replaced by the host's once it answers
+    this->ballSpeed = ballSpeed;
+    this->barSpeed = barSpeed;
+    this->maxScore = maxScore;
+    if (role == HOST) {
+        std::random_device device;
+        seed = device();
+    }
+    beginMatch();
+
+    memset(&stats, 0, sizeof(stats));
+    stats.state = CONNECTING;
+    stats.lockstep = lockstep ? 1 : 0;
+    stats.inputDelay = inputDelay;
+    statsBuffer.writeBuffer() = stats;
+    statsBuffer.publish();
+    snapshots.writeBuffer() = sim.takeSnapshot();
+    snapshots.publish();
+
+    alive.store(true);
+    thread = std::thread(&NetSession::run, this);
+    return true;
+}
+
+void NetSession::stop()
+{
+    alive.store(false);
+    if (thread.joinable()) {
+        thread.join();
+    }
+    socket.close();
+}
+
+bool NetSession::isLeftPlayer() const
+{
+    return role == HOST;
+}
+
+const PongSnapshot& NetSession::latestSnapshot()
+{
+    return snapshots.read();
+}
+
+const NetStats& NetSession::latestStats()
+{
+    return statsBuffer.read();
+}
+
+void NetSession::beginMatch()
+{
+    sim = PongSim();
+    sim.seed(seed);
+    sim.setGameParameters(ballSpeed, barSpeed, maxScore);
+    sim.setTimeDelta(1.0f / TICK_RATE);
+    sim.resetGame(true);
+
+    tick = 0;
+    memset(localInputs, 0, sizeof(localInputs));
+    memset(remoteInputs, 0, sizeof(remoteInputs));
+    memset(remoteTicks, 0, sizeof(remoteTicks));
+    memset(usedRemote, 0, sizeof(usedRemote));
+    remoteConfirmed = 0;
+    remoteAcked = 0;
+    rollbackTick = NO_ROLLBACK;
+    endTick = 0;
+    confirmedInput = 0;
+
+    // in lockstep the first inputDelay ticks have no input on either side, as if both players sent 0
+    unsigned int delayed = lockstep ? (unsigned int)inputDelay : 0;
+    for (unsigned int t = 0; t < delayed; t++) {
+        remoteTicks[t] = t + 1;
+    }
+    localSent = delayed;
+    remoteConfirmed = delayed;
+    remoteAcked = delayed;
+
+    memset(localHashes, 0, sizeof(localHashes));
+    memset(remoteHashes, 0, sizeof(remoteHashes));
+    nextHashTick = 1;
+    localChain = 0;
+    remoteHashTick = 0;
+
+    clock.reset();
+    jitter.reset();
+    sequence = 0;
+    tickAdvantage = 0.0f;
+    remoteWantedDelay = -1;
+    lastAdapt = 0;
+    stallTick = NO_ROLLBACK;
+}
+
+void NetSession::run()
+{
+    const long long period = 1000000000LL / TICK_RATE;
+    long long now = InputQueue::now();
+    nextTick = now;
+    long long lastHello = 0;
+    long long lastInputs = 0;
+    unsigned int publishedConfirmed = 0;
+    lastReceived = now;
+
+    while (alive.load(std::memory_order_relaxed)) {
+        now = InputQueue::now();
+        receive(now);
+
+        if (stats.state == CONNECTING) {
+            if (role == JOIN) {
+                if (now - lastHello >= HELLO_INTERVAL_NS) {
+                    sendControl(PACKET_HELLO, now);
+                    lastHello = now;
+                }
+                if (now - lastReceived > TIMEOUT_MS * 1000000LL) {
+                    std::cout << "FAILED::CONNECTING::NO_REPLY_FROM_HOST" << std::endl;
+                    stats.state = FAILED;
+                }
+            }
+            // the first tick is due as soon as the match starts
+            nextTick = now;
+        }
+        else if (stats.state == PLAYING) {
+            bool changed = false;
+            if (rollbackTick < tick) {
+                rollback();
+                changed = true;
+            }
+
+            int ticks = 0;
+            while (now >= nextTick && ticks < MAX_CATCHUP_TICKS) {
+                if (lockstep) {
+                    if (sim.gameStatus() != 0) {
+                        // nothing left to schedule, just keep the queue drained
+                        if (input != nullptr) {
+                            input->collectTick(nextTick - period, nextTick, sim.timeDelta);
+                        }
+                        nextTick += period;
+                        ticks++;
+                        continue;
+                    }
+                    adaptDelay();
+                    // inputs are scheduled inputDelay ticks ahead. A grown delay repeats this tick's direction over the extra
+                    // ticks, a shrunk one schedules nothing this tick and the key events wait for the next
+                    if (localSent <= tick + inputDelay) {
+                        TickInput local = input != nullptr ? input->collectTick(nextTick - period, nextTick, sim.timeDelta) : TickInput::constant(0);
+                        signed char direction = (signed char)local.finalDirection();
+                        while (localSent <= tick + inputDelay) {
+                            localInputs[localSent % RING] = direction;
+                            localSent++;
+                        }
+                    }
+                    // the tick is due but the remote input for it is not here yet. We keep it due and run it (and any
+                    // after it that are also late) as soon as the input arrives
+                    if (tick >= remoteConfirmed) {
+                        if (stallTick != tick) {
+                            stats.stalls++;
+                            stallTick = tick;
+                        }
+                        break;
+                    }
+                    simulate(tick);
+                    tick++;
+                    changed = true;
+                    nextTick += period + syncDelay(period);
+                    ticks++;
+                    continue;
+                }
+                TickInput local = input != nullptr ? input->collectTick(nextTick - period, nextTick, sim.timeDelta) : TickInput::constant(0);
+                // once the match looks over we wait for the remote input to confirm (or undo) it
+                if (sim.gameStatus() == 0) {
+                    if (tick < remoteConfirmed + MAX_PREDICTION) {
+                        // only the direction at the end of the tick is sent, so both ends step with exactly the same input
+                        localInputs[tick % RING] = (signed char)local.finalDirection();
+                        simulate(tick);
+                        tick++;
+                        localSent = tick;
+                        changed = true;
+                    }
+                    else {
+                        stats.stalls++;
+                    }
+                }
+                nextTick += period + syncDelay(period);
+                ticks++;
+            }
+            if (ticks == MAX_CATCHUP_TICKS && now >= nextTick) {
+                nextTick = now + period;
+            }
+            updateHashes();
+            // one packet per tick, even while stalled (a lockstep stall runs no ticks at all), so acknowledgements and
+            // round trip times keep flowing
+            if (ticks > 0 || now - lastInputs >= period) {
+                sendInputs(now);
+                lastInputs = now;
+            }
+            // newly confirmed inputs can confirm the end of the match without changing anything else
+            if (changed || remoteConfirmed != publishedConfirmed) {
+                publishedConfirmed = remoteConfirmed;
+                PongSnapshot& snapshot = snapshots.writeBuffer();
+                snapshot = sim.takeSnapshot();
+                if (endTick == 0 || remoteConfirmed < endTick) {
+                    snapshot.status = 0;
+                }
+                snapshots.publish();
+            }
+            if (now - lastReceived > TIMEOUT_MS * 1000000LL) {
+                std::cout << "FAILED::NETWORK::REMOTE_PLAYER_TIMED_OUT" << std::endl;
+                stats.state = DISCONNECTED;
+            }
+        }
+
+        shim.flush(socket, now);
+        stats.link = shim.counters();
+
+        stats.tick = tick;
+        stats.confirmedTick = remoteConfirmed;
+        stats.inputDelay = inputDelay;
+        stats.wantedDelay = remoteWantedDelay;
+        stats.clockOffsetMs = clock.synced() ? (float)clock.offset(now) / 1000000.0f : 0.0f;
+        stats.driftPpm = clock.driftPpm();
+        stats.transitMs = jitter.transitMs();
+        stats.jitterMs = jitter.jitterMs();
+        stats.lossPercent = jitter.lossPercent();
+        stats.tickAdvantage = tickAdvantage;
+        statsBuffer.writeBuffer() = stats;
+        statsBuffer.publish();
+
+        if (stats.state == DISCONNECTED || stats.state == FAILED) {
+            break;
+        }
+
+        long long wake = nextTick < now + POLL_NS ? nextTick : now + POLL_NS;
+        if (wake > now) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wake - now));
+        }
+    }
+
+    // let the remote player know straight away instead of waiting for the timeout
+    if (stats.state == PLAYING) {
+        unsigned char packet[HEADER_SIZE];
+        unsigned char* out = packet;
+        writeU16(out, PACKET_MAGIC);
+        *out++ = PACKET_BYE;
+        socket.send(remote, packet, HEADER_SIZE);
+    }
+}
+
+void NetSession::receive(long long now)
+{
+    unsigned char packet[UdpSocket::MAX_PACKET];
+    NetAddress from;
+    int length;
+    while ((length = socket.receive(&from, packet, sizeof(packet))) >= 0) {
+        const unsigned char* in = packet;
+        if (length < HEADER_SIZE || readU16(in) != PACKET_MAGIC) {
+            continue;
+        }
+        int type = *in++;
+
+        // the host takes whoever says hello first as its opponent
+        if (role == HOST && type == PACKET_HELLO && stats.state == CONNECTING) {
+            remote = from;
+            stats.state = PLAYING;
+            lastReceived = now;
+        }
+        if (from != remote) {
+            continue;
+        }
+        stats.packetsReceived++;
+        lastReceived = now;
+
+        if (type == PACKET_HELLO && role == HOST) {
+            // sent again every time, in case our welcome was lost
+            sendControl(PACKET_WELCOME, now);
+        }
+        else if (type == PACKET_WELCOME && role == JOIN && stats.state == CONNECTING && length >= HEADER_SIZE + 18) {
+            seed = readU32(in);
+            ballSpeed = readF32(in);
+            barSpeed = readF32(in);
+            maxScore = (int)readU32(in);
+            lockstep = *in++ != 0;
+            setLockstep(lockstep, *in++);
+            stats.lockstep = lockstep ? 1 : 0;
+            stats.inputDelay = inputDelay;
+            beginMatch();
+            stats.state = PLAYING;
+        }
+        else if (type == PACKET_INPUT && stats.state == PLAYING) {
+            readInputs(in, length - HEADER_SIZE, now);
+        }
+        else if (type == PACKET_BYE && stats.state == PLAYING) {
+            stats.state = DISCONNECTED;
+        }
+    }
+}
+
+void NetSession::sendControl(int type, long long now)
+{
+    unsigned char packet[HEADER_SIZE + 18];
+    unsigned char* out = packet;
+    writeU16(out, PACKET_MAGIC);
+    *out++ = (unsigned char)type;
+    if (type == PACKET_WELCOME) {
+        writeU32(out, seed);
+        writeF32(out, ballSpeed);
+        writeF32(out, barSpeed);
+        writeU32(out, (unsigned int)maxScore);
+        *out++ = lockstep ? 1 : 0;
+        *out++ = (unsigned char)inputDelay;
+    }
+    shim.send(socket, remote, packet, (int)(out - packet), now);
+    stats.packetsSent++;
+}
+
+void NetSession::sendInputs(long long now)
+{
+    // everything the remote player has not acknowledged yet, as far back as we still have it
+    unsigned int first = remoteAcked;
+    if (localSent > (unsigned int)RING && first < localSent - RING) {
+        first = localSent - RING;
+    }
+    unsigned int count = localSent > first ? localSent - first : 0;
+    if (count > (unsigned int)MAX_INPUTS_PER_PACKET) {
+        count = MAX_INPUTS_PER_PACKET;
+    }
+
+    unsigned char packet[UdpSocket::MAX_PACKET];
+    unsigned char* out = packet;
+    writeU16(out, PACKET_MAGIC);
+    *out++ = PACKET_INPUT;
+    writeU32(out, first);
+    *out++ = (unsigned char)count;
+    for (unsigned int i = 0; i < count; i++) {
+        *out++ = (unsigned char)localInputs[(first + i) % RING];
+    }
+    writeU32(out, remoteConfirmed);
+    // our clock, their clock echoed back and how long we held it, so the other end can work out the round trip
+    writeI64(out, now);
+    writeI64(out, echoTime);
+    writeI64(out, echoTime != 0 ? now - echoReceived : 0);
+    // our newest hash chain, with the acknowledgement it is the proof we simulated what we acknowledged the same way
+    TickHash& newest = localHashes[stats.lastHashTick % HASH_RING];
+    writeU32(out, newest.tick);
+    writeU32(out, (unsigned int)(newest.hash >> 32));
+    writeU32(out, (unsigned int)newest.hash);
+    // when our next tick is due so the other end can tell which of us is ahead, and the delay we would like its inputs sent with
+    writeU32(out, tick);
+    writeI64(out, nextTick);
+    writeU16(out, sequence++);
+    int wanted = NO_DELAY_WANTED;
+    if (lockstep && clock.synced() && jitter.ready()) {
+        wanted = jitter.targetTicks(1000000000LL / TICK_RATE);
+        if (wanted > MAX_INPUT_DELAY) {
+            wanted = MAX_INPUT_DELAY;
+        }
+    }
+    *out++ = (unsigned char)wanted;
+    shim.send(socket, remote, packet, (int)(out - packet), now);
+    stats.packetsSent++;
+}
+
+void NetSession::readInputs(const unsigned char* in, int length, long long now)
+{
+    if (length < 5) {
+        return;
+    }
+    unsigned int first = readU32(in);
+    int count = *in++;
+    if (length < 5 + count + 55) {
+        return;
+    }
+    const unsigned char* inputs = in;
+    in += count;
+    unsigned int ack = readU32(in);
+    long long sendTime = readI64(in);
+    long long echoed = readI64(in);
+    long long held = readI64(in);
+    unsigned int hashTick = readU32(in);
+    unsigned long long hash = (unsigned long long)readU32(in) << 32;
+    hash |= readU32(in);
+    unsigned int senderTick = readU32(in);
+    long long senderDue = readI64(in);
+    unsigned short packetSequence = readU16(in);
+    unsigned char wanted = *in++;
+
+    if (ack > remoteAcked) {
+        remoteAcked = ack;
+    }
+    for (int i = 0; i < count; i++) {
+        unsigned int t = first + i;
+        if (t < remoteConfirmed) {
+            continue;
+        }
+        // can only happen with a broken peer, the remote player never gets this far ahead of us
+        if (t >= remoteConfirmed + RING) {
+            break;
+        }
+        signed char value = (signed char)inputs[i];
+        int slot = t % RING;
+        remoteInputs[slot] = value;
+        remoteTicks[slot] = t + 1;
+        // we already simulated this tick with a guess, and guessed wrong
+        if (t < tick && usedRemote[slot] != value && t < rollbackTick) {
+            rollbackTick = t;
+        }
+    }
+    while (remoteTicks[remoteConfirmed % RING] == remoteConfirmed + 1) {
+        confirmedInput = remoteInputs[remoteConfirmed % RING];
+        remoteConfirmed++;
+    }
+
+    if (echoed != 0) {
+        stats.rttMs = (float)(now - echoed - held) / 1000000.0f;
+        // the remote player got our packet held nanoseconds before sending this one
+        clock.addSample(echoed, sendTime - held, sendTime, now);
+    }
+    if (clock.synced()) {
+        const long long period = 1000000000LL / TICK_RATE;
+        long long transit = now - clock.toLocal(sendTime);
+        jitter.packet(transit, packetSequence);
+        // when senderTick is due for the remote player and for us, on our clock. The later they are due there, the
+        // further ahead we are
+        long long remoteDue = clock.toLocal(senderDue);
+        long long ourDue = nextTick + ((long long)senderTick - (long long)tick) * period;
+        tickAdvantage += ((float)(remoteDue - ourDue) / (float)period - tickAdvantage) * ADVANTAGE_GAIN;
+    }
+    remoteWantedDelay = wanted == NO_DELAY_WANTED ? -1 : (int)wanted;
+    if (sendTime > echoTime) {
+        echoTime = sendTime;
+        echoReceived = now;
+    }
+
+    if (hashTick > remoteHashTick) {
+        remoteHashTick = hashTick;
+        TickHash& entry = remoteHashes[hashTick % HASH_RING];
+        entry.tick = hashTick;
+        entry.hash = hash;
+        compareHash(hashTick);
+    }
+}
+
+signed char NetSession::remoteInputFor(unsigned int t) const
+{
+    int slot = t % RING;
+    if (remoteTicks[slot] == t + 1) {
+        return remoteInputs[slot];
+    }
+    return confirmedInput;
+}
+
+void NetSession::simulate(unsigned int t)
+{
+    int slot = t % RING;
+    states.save(t, sim);
+    signed char remoteInput = remoteInputFor(t);
+    usedRemote[slot] = remoteInput;
+    // ticks after the end of a match (only reached while resimulating) leave it as it is
+    if (sim.gameStatus() != 0) {
+        return;
+    }
+    if (role == HOST) {
+        sim.step(localInputs[slot], remoteInput);
+    }
+    else {
+        sim.step(remoteInput, localInputs[slot]);
+    }
+    if (sim.gameStatus() != 0) {
+        endTick = t + 1;
+    }
+}
+
+void NetSession::rollback()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned int from = rollbackTick;
+    states.restore(from, &sim);
+    if (endTick > from) {
+        endTick = 0;
+    }
+    for (unsigned int t = from; t < tick; t++) {
+        simulate(t);
+    }
+    rollbackTick = NO_ROLLBACK;
+
+    float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.rollbacks++;
+    stats.lastResimTicks = tick - from;
+    stats.lastResimMs = ms;
+    if (stats.lastResimTicks > stats.maxResimTicks) {
+        stats.maxResimTicks = stats.lastResimTicks;
+    }
+    if (ms > stats.maxResimMs) {
+        stats.maxResimMs = ms;
+    }
+}
+
+void NetSession::adaptDelay()
+{
+    if (remoteWantedDelay < 0 || remoteWantedDelay == inputDelay) {
+        return;
+    }
+    // a delay too short stalls the remote player every tick, so it grows at once. Shrinking is done slowly, in case
+    // the quiet spell that made the remote player ask for less is short
+    if (remoteWantedDelay > inputDelay) {
+        inputDelay = remoteWantedDelay;
+        lastAdapt = tick;
+    }
+    else if (tick >= lastAdapt + ADAPT_INTERVAL) {
+        inputDelay--;
+        lastAdapt = tick;
+    }
+}
+
+long long NetSession::syncDelay(long long period) const
+{
+    if (!clock.synced() || tickAdvantage <= SYNC_THRESHOLD) {
+        return 0;
+    }
+    float ahead = tickAdvantage < MAX_SYNC_TICKS ? tickAdvantage : MAX_SYNC_TICKS;
+    return (long long)((float)period * ahead * SYNC_GAIN);
+}
+
+// updateHashes runs after every batch of ticks, so the states it still has to hash are at most this far behind
+static_assert(NetSession::MAX_PREDICTION + MAX_CATCHUP_TICKS < NetSession::RING, "hash chains need every settled state still in the ring");
+
+void NetSession::updateHashes()
+{
+    // the state at the start of a tick is final once we have simulated up to it with every input before it confirmed
+    unsigned int settled = tick < remoteConfirmed ? tick : remoteConfirmed;
+    while (nextHashTick <= settled) {
+        unsigned int t = nextHashTick;
+        PongSim state;
+        if (t == tick) {
+            state = sim;
+        }
+        else if (!states.restore(t, &state)) {
+            // the ring covers every tick we can be ahead of the settled one, a chain with a tick missing would never
+            // match again, so stop here rather than skip it
+            break;
+        }
+        nextHashTick++;
+        localChain = chainHash(localChain, state.stateHash());
+        TickHash& entry = localHashes[t % HASH_RING];
+        entry.tick = t;
+        entry.hash = localChain;
+        stats.lastHashTick = t;
+        stats.lastHash = entry.hash;
+        compareHash(t);
+    }
+}
+
+void NetSession::compareHash(unsigned int t)
+{
+    int slot = t % HASH_RING;
+    if (localHashes[slot].tick != t || remoteHashes[slot].tick != t) {
+        return;
+    }
+    stats.hashesChecked++;
+    if (localHashes[slot].hash == remoteHashes[slot].hash) {
+        if (t > stats.agreedTick) {
+            stats.agreedTick = t;
+        }
+    }
+    else {
+        if (stats.desyncs == 0) {
+            stats.firstDesyncTick = t;
+            std::cout << "FAILED::NETWORK::DESYNC::TICKS: " << stats.agreedTick + 1 << " TO " << t << std::endl;
+        }
+        stats.desyncs++;
+    }
+}
@@ -0,0 +1,499 @@
+#include "../Includes/PongSim.hpp"
+#include "../Includes/Meshes.hpp"
+#include "../Includes/ByteIO.hpp"
+#include "../Includes/StateHash.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+// PongSim.cpp holds the rules of the pong game (movement, collisions, AI, scoring) separately from any rendering
+
+PongSim::PongSim()
+{
+    // initializing the score
+    leftScore = 0;
+    rightScore = 0;
+
+    maxScore = 3;
+
+    // we start with default settings in the state
+    ballSpeedMultiplier = 1;
+    barSpeedMultiplier = 5;
+
+    timeDelta = 0.0f;
+    tick = 0;
+    lastHit = BAR_HIT_NONE;
+    lastHitDist = 0.0f;
+
+    // these match the bar and ball meshes in Meshes.hpp
+    barDims = glm::vec2(BAR_WIDTH, BAR_HEIGHT);
+    ballDims = glm::vec2(BALL_SIZE, BALL_SIZE);
+
+    // initializing positions as the top left vertex of each object with even distances
+    leftBarPos = glm::vec2(-0.95f,0.2f);
+    rightBarPos = glm::vec2(0.91f,0.2f);
+    ballPos = glm::vec2(-0.02f,0.02f);
+    ballLastPos = glm::vec2(-0.02f, 0.02f);
+
+    // same seed as a default constructed standard engine, so a match is repeatable unless it is reseeded
+    random.seed(1);
+
+    // randomize ball velocity vector direction to start
+    setBallInitialDirection();
+}
+
+int PongSim::step(int leftDirection)
+{
+    return step(leftDirection, aiDirection(false));
+}
+
+int PongSim::step(int leftDirection, int rightDirection)
+{
+    return step(TickInput::constant(leftDirection), rightDirection);
+}
+
+int PongSim::step(const TickInput& leftInput, int rightDirection)
+{
+    tick++;
+    handleMovement(leftInput);
+    moveBar(rightBarPos, rightDirection);
+    int isGoal = handleBallMovement();
+
+    if (isGoal) {
+        resetGame(false);
+    }
+    return isGoal;
+}
+
+// two 32 bit values in one word, the way they are in memory (bit patterns for floats, so -0 and 0 differ)
+static unsigned long long packWord(const void* low, const void* high)
+{
+    unsigned int halves[2];
+    memcpy(&halves[0], low, sizeof(unsigned int));
+    memcpy(&halves[1], high, sizeof(unsigned int));
+    return (unsigned long long)halves[0] | ((unsigned long long)halves[1] << 32);
+}
+
+unsigned long long PongSim::stateHash() const
+{
+    // fed one field at a time so padding between members never gets in
+    unsigned long long words[STATE_HASH_WORDS] = {
+        packWord(&barDims.x, &barDims.y),
+        packWord(&ballDims.x, &ballDims.y),
+        packWord(&leftBarPos.x, &leftBarPos.y),
+        packWord(&rightBarPos.x, &rightBarPos.y),
+        packWord(&ballPos.x, &ballPos.y),
+        packWord(&ballLastPos.x, &ballLastPos.y),
+        packWord(&ballVelocity.x, &ballVelocity.y),
+        packWord(&ballSpeedMultiplier, &barSpeedMultiplier),
+        packWord(&leftScore, &rightScore),
+        packWord(&maxScore, &timeDelta),
+        tick,
+        random.state,
+    };
+    return hashWords(words, STATE_HASH_WORDS);
+}
+
+void PongSim::writeState(unsigned char*& out) const
+{
+    const glm::vec2* vectors[] = { &leftBarPos, &rightBarPos, &ballPos, &ballLastPos, &ballVelocity };
+    for (const glm::vec2* vector : vectors) {
+        writeF32(out, vector->x);
+        writeF32(out, vector->y);
+    }
+    writeU8(out, (unsigned char)leftScore);
+    writeU8(out, (unsigned char)rightScore);
+    writeU32(out, (unsigned int)tick);
+    writeI64(out, (long long)random.state);
+}
+
+void PongSim::readState(const unsigned char*& in)
+{
+    glm::vec2* vectors[] = { &leftBarPos, &rightBarPos, &ballPos, &ballLastPos, &ballVelocity };
+    for (glm::vec2* vector : vectors) {
+        vector->x = readF32(in);
+        vector->y = readF32(in);
+    }
+    leftScore = readU8(in);
+    rightScore = readU8(in);
+    tick = readU32(in);
+    random.state = (unsigned long long)readI64(in);
+}
+
+// where ballPos and tick sit in writeState's layout
+static const int STATE_BALL_POS = 16;
+static const int STATE_TICK = 42;
+
+/*
+	writeState's floats in the order a keyframe holds them: what moves between keyframes (the bars' heights, ballLastPos,
+	ballVelocity) first, then what mostly holds still or is predicted (the bars' x, ballPos). The scores, tick and random
+	state follow as they are, so a keyframe ends in one run of zeros the compressor takes as a single match
+*/
+static const int KEYFRAME_FLOATS[] = { 4, 12, 24, 28, 36, 32, 0, 8, 16, 20 };
+static const int STATE_FLOATS = 10;
+
+// the keyframe order of a state in writeState's layout (or back)
+static void orderKeyframe(const unsigned char* state, unsigned char* ordered, bool back)
+{
+    for (int i = 0; i < STATE_FLOATS; i++) {
+        const unsigned char* from = back ? state + 4 * i : state + KEYFRAME_FLOATS[i];
+        unsigned char* to = back ? ordered + KEYFRAME_FLOATS[i] : ordered + 4 * i;
+        memcpy(to, from, 4);
+    }
+    memcpy(ordered + 4 * STATE_FLOATS, state + 4 * STATE_FLOATS, PongSim::STATE_BYTES - 4 * STATE_FLOATS);
+}
+
+// base with ballPos and tick replaced by what a state stepped on from it is expected to hold
+static void predictState(const unsigned char* base, unsigned int ticks, glm::vec2 ballPos, unsigned char* prediction)
+{
+    memcpy(prediction, base, PongSim::STATE_BYTES);
+    unsigned char* out = prediction + STATE_BALL_POS;
+    writeF32(out, ballPos.x);
+    writeF32(out, ballPos.y);
+    const unsigned char* in = base + STATE_TICK;
+    out = prediction + STATE_TICK;
+    writeU32(out, readU32(in) + ticks);
+}
+
+// where the ball is after a step without a bounce, the same expression handleBallMovement() moves it with
+static glm::vec2 movedBall(glm::vec2 ballLastPos, glm::vec2 ballVelocity, float timeDelta, float ballSpeedMultiplier)
+{
+    return glm::vec2(ballLastPos.x + ballVelocity.x * timeDelta * ballSpeedMultiplier,
+        ballLastPos.y + ballVelocity.y * timeDelta * ballSpeedMultiplier);
+}
+
+void PongSim::writeKeyframe(unsigned char*& out, const unsigned char* base, unsigned int ticks) const
+{
+    unsigned char state[STATE_BYTES];
+    unsigned char* end = state;
+    writeState(end);
+    unsigned char prediction[STATE_BYTES];
+    predictState(base, ticks, movedBall(ballLastPos, ballVelocity, timeDelta, ballSpeedMultiplier), prediction);
+    unsigned char residual[STATE_BYTES];
+    for (int i = 0; i < STATE_BYTES; i++) {
+        residual[i] = state[i] ^ prediction[i];
+    }
+    orderKeyframe(residual, out, false);
+    out += STATE_BYTES;
+}
+
+void PongSim::readKeyframe(const unsigned char*& in, const unsigned char* base, unsigned int ticks)
+{
+    unsigned char residual[STATE_BYTES];
+    orderKeyframe(in, residual, true);
+    unsigned char state[STATE_BYTES];
+    unsigned char prediction[STATE_BYTES];
+    predictState(base, ticks, glm::vec2(0.0f, 0.0f), prediction);
+    for (int i = 0; i < STATE_BYTES; i++) {
+        state[i] = residual[i] ^ prediction[i];
+    }
+    const unsigned char* read = state;
+    readState(read);
+    // ballPos is predicted from ballLastPos and ballVelocity, which are in place now
+    predictState(base, ticks, movedBall(ballLastPos, ballVelocity, timeDelta, ballSpeedMultiplier), prediction);
+    for (int i = STATE_BALL_POS; i < STATE_BALL_POS + 8; i++) {
+        state[i] = residual[i] ^ prediction[i];
+    }
+    read = state + STATE_BALL_POS;
+    ballPos.x = readF32(read);
+    ballPos.y = readF32(read);
+    in += STATE_BYTES;
+}
+
+PongSnapshot PongSim::takeSnapshot()
+{
+    PongSnapshot snapshot;
+    snapshot.leftBarPos = leftBarPos;
+    snapshot.rightBarPos = rightBarPos;
+    snapshot.ballPos = ballPos;
+    snapshot.leftScore = leftScore;
+    snapshot.rightScore = rightScore;
+    snapshot.status = gameStatus();
+    snapshot.tick = tick;
+    return snapshot;
+}
+
+int PongSim::gameStatus()
+{
+    if (leftScore == maxScore) {
+        return 1;
+    }
+    else if (rightScore == maxScore) {
+        return 2;
+    } 
+    return 0;
+}
+
+int PongSim::handleBallMovement()
+{
+   // update the balls state and account for collisions 
+    // each collision will make the ball faster in the collision component of the velocity!
+    ballLastPos.x = ballPos.x;
+    ballLastPos.y = ballPos.y;
+    lastHit = BAR_HIT_NONE;
+
+    ballPos.x += ballVelocity.x * timeDelta * ballSpeedMultiplier;
+    ballPos.y += ballVelocity.y * timeDelta * ballSpeedMultiplier;
+
+    // check for collisions and reset ball if necessary (after scoring)
+
+    // checking first for collisions with the boundary (recall that ballPos is the position of thet top left of the ball)
+    // for collisions, we reset the position to the boundary and reverse the component of the velocity based on the collision
+    if (ballPos.x <= -1.0f) {
+        // goal state! this is a goal for the right player (hit the left wall)
+        rightScore += 1;
+        return 1;
+    }
+    else if (ballPos.x + ballDims.x >= 1.0f) {
+        // goal state! this is a goal for the left player (hit the right wall)
+        leftScore += 1;
+        return 1;
+    }
+    else if (ballPos.y - ballDims.y <= -1.0f) {
+        // hit the bottom wall
+        ballPos.y = -1.0f + ballDims.y;
+        ballVelocity.y *= -1;
+    }
+    else if (ballPos.y >= 1.0f) {
+        // hit the top wall
+        ballPos.y = 1.0f;
+        ballVelocity.y *= -1;
+    }
+
+    // check for collision with any bars
+
+    // check collision with left bar
+    if ((ballPos.x >= leftBarPos.x && ballPos.x <= leftBarPos.x + barDims.x) &&
+         (ballPos.y >= leftBarPos.y-barDims.y && ballPos.y  <= leftBarPos.y)) {
+            
+        // we have a collision with the left bar, we have to determine which components to reverse
+        // we can determine this by checking the last position of the ball (which must be outside the bounding box) 
+        if (ballLastPos.y > leftBarPos.y && ballLastPos.x < leftBarPos.x + barDims.x) {
+            // collision with the top of the bar
+            ballPos.y = leftBarPos.y;
+            ballVelocity.y *= -1;
+        }
+        else if (ballLastPos.y > leftBarPos.y - barDims.y && ballLastPos.x > leftBarPos.x + barDims.x) {
+            // collision with the side of the bar
+            ballPos.x = leftBarPos.x + barDims.x;
+            
+            // we adjust the y velocity based on where on the paddle the ball collides
+            float hitDist = (leftBarPos.y - barDims.y / 2) - ballPos.y;
+            // getting a float between 0 and 1
+            hitDist /= barDims.y / 2;
+            ballVelocity.y = ballVelocity.x * hitDist;
+
+            ballVelocity.x *= -1;
+            lastHit = BAR_HIT_LEFT;
+            lastHitDist = hitDist;
+            
+            
+        }
+        else if (ballLastPos.y < leftBarPos.y - barDims.y && ballLastPos.x > leftBarPos.x){
+            // collision with the bottom of the bar
+            ballPos.y = leftBarPos.y - barDims.y;
+            ballVelocity.y *= -1;
+        }
+        else if (ballLastPos.y > leftBarPos.y && ballLastPos.x > leftBarPos.x + barDims.x) {
+            // top right corner collision
+            ballPos.y = leftBarPos.y;
+            ballPos.x = leftBarPos.x + barDims.x;
+            ballVelocity *= -1;
+            lastHit = BAR_HIT_LEFT;
+            lastHitDist = -1.0f;
+        }
+        else if (ballLastPos.y < leftBarPos.y - barDims.y && ballLastPos.x > leftBarPos.x + barDims.x) {
+            // bottom right corner collision
+            ballPos.x = leftBarPos.x + barDims.x;
+            ballPos.y = leftBarPos.y - barDims.y;
+            ballVelocity *= -1;
+            lastHit = BAR_HIT_LEFT;
+            lastHitDist = 1.0f;
+        }
+    }
+
+    // check collision with right bar
+
+    // need to move the ball slightly, since we only record the top left of the ball
+    glm::vec2 modifiedBallPos = glm::vec2(0.0f, 0.0f);
+    modifiedBallPos.x = ballPos.x + ballDims.x;
+    modifiedBallPos.y = ballPos.y;
+    if ((modifiedBallPos.x >= rightBarPos.x && modifiedBallPos.x <= rightBarPos.x + barDims.x) &&
+         (modifiedBallPos.y >= rightBarPos.y-barDims.y && modifiedBallPos.y  <= rightBarPos.y)) {
+        
+        // need to move the ball slightly for right collision, since we only record the top left of the ball
+        glm::vec2 modifiedLastBallPos = glm::vec2(0.0f, 0.0f);
+        modifiedLastBallPos.x = ballLastPos.x + ballDims.x;
+        modifiedLastBallPos.y = ballLastPos.y;
+        // we have a collision with the right bar, we have to determine which components to reverse
+        // we can determine this by checking the last position of the ball (which must be outside the bounding box) 
+        if (modifiedLastBallPos.y > rightBarPos.y && modifiedLastBallPos.x > rightBarPos.x ) {
+            // collision with the top of the bar
+            ballPos.y = rightBarPos.y;
+            ballVelocity.y *= -1;
+        }
+        else if (modifiedLastBallPos.y > rightBarPos.y - barDims.y && modifiedLastBallPos.x < rightBarPos.x ) {
+            // collision with the side of the bar
+            ballPos.x = rightBarPos.x - ballDims.x;
+
+            // we adjust the y velocity based on where on the paddle the ball collides
+            float hitDist = (rightBarPos.y - barDims.y / 2) - ballPos.y;
+            // getting a float between 0 and 1 and negating since we are on the opposite side
+            hitDist /=  - barDims.y / 2;
+            ballVelocity.y = ballVelocity.x * hitDist;
+
+            ballVelocity.x *= -1;
+            lastHit = BAR_HIT_RIGHT;
+            lastHitDist = hitDist;
+
+            
+        }
+        else if (modifiedLastBallPos.y < rightBarPos.y - barDims.y && modifiedLastBallPos.x > rightBarPos.x){
+            // collision with the bottom of the bar
+            ballPos.y = rightBarPos.y - barDims.y;
+            ballVelocity.y *= -1;
+        }
+        else if (modifiedLastBallPos.y > rightBarPos.y && modifiedLastBallPos.x < rightBarPos.x) {
+            // top left corner collision
+            ballPos.y = rightBarPos.y;
+            ballPos.x = rightBarPos.x - ballDims.x;
+            ballVelocity *= -1;
+            lastHit = BAR_HIT_RIGHT;
+            lastHitDist = 1.0f;
+        }
+        else if (modifiedLastBallPos.y < rightBarPos.y - barDims.y && modifiedLastBallPos.x < rightBarPos.x) {
+            // bottom left corner collision
+            ballPos.x = rightBarPos.x - ballDims.x;
+            ballPos.y = rightBarPos.y - barDims.y;
+            ballVelocity *= -1;
+            lastHit = BAR_HIT_RIGHT;
+            lastHitDist = -1.0f;
+        }
+        
+    } 
+    
+    return 0;
+}
+
+void PongSim::handleAIMovement()
+{
+    moveBar(rightBarPos, aiDirection(false));
+}
+
+int PongSim::aiDirection(bool leftBar)
+{
+    // we just need to move the bar up or down just the right amount to hit the ball based on its trajectory
+    // this AI is simple, it will not take into account the complex future (ball bouncing off walls etc.)
+    // this AI should not have access to the balls velocity vector, but it can "observe" changes in position of the ball    
+    glm::vec2 ballTrajectory = ballPos - ballLastPos;
+    glm::vec2 barPos = leftBar ? leftBarPos : rightBarPos;
+
+    // how many timesteps will it take for the ball approximately to reach the bar?
+    float remainingDistance, approachSpeed;
+    if (leftBar) {
+        remainingDistance = ballPos.x - (barPos.x + barDims.x);
+        approachSpeed = -ballTrajectory.x / timeDelta;
+    }
+    else {
+        remainingDistance = barPos.x - (ballPos.x + ballDims.x);
+        approachSpeed = ballTrajectory.x / timeDelta;
+    }
+    float numTimesteps = remainingDistance / approachSpeed;
+    
+    // will we be in a good position for the bar to collide with the ball?
+    float estimatedY = ballPos.y + (ballTrajectory.y * numTimesteps);
+
+    if (estimatedY > barPos.y) {
+        // we move up
+        return 1;
+    }
+    else if (estimatedY < barPos.y - barDims.y) {
+        // we move down
+        return -1;
+    }
+    return 0;
+}
+
+void PongSim::resetGame(bool totalReset) {
+    // initializing positions as the top left vertex of each object with even distances
+    leftBarPos = glm::vec2(-0.95f,0.2f);
+    rightBarPos = glm::vec2(0.91f,0.2f);
+    ballPos = glm::vec2(-0.02f,0.02f);
+    ballLastPos = glm::vec2(-0.02f, 0.02f);
+
+    if (totalReset) {
+        // reset the score also
+        leftScore = 0;
+        rightScore = 0;
+        tick = 0;
+    }
+    
+    // reset ball velocity
+    setBallInitialDirection();
+
+}
+
+void PongSim::handleMovement(int direction)
+{
+    moveBar(leftBarPos, direction);
+}
+
+void PongSim::handleMovement(const TickInput& input)
+{
+    // each direction holds from its offset until the next change (or the end of the tick)
+    int direction = input.direction;
+    float start = 0.0f;
+    for (int i = 0; i < input.changeCount; i++) {
+        float end = std::min(std::max(input.changeOffsets[i], start), timeDelta);
+        moveBar(leftBarPos, direction, end - start);
+        direction = input.changes[i];
+        start = end;
+    }
+    moveBar(leftBarPos, direction, timeDelta - start);
+}
+
+void PongSim::moveBar(glm::vec2& barPos, int direction)
+{
+    moveBar(barPos, direction, timeDelta);
+}
+
+void PongSim::moveBar(glm::vec2& barPos, int direction, float seconds)
+{
+    if (direction > 0) {
+        // move the bar up, we should not move it above the top of the screen!
+        barPos.y = std::min(1.0f, barPos.y + seconds * barSpeedMultiplier);
+    }
+    else if (direction < 0) {
+        // move the bar down and the bottom of the bar should not go below the screen!
+        barPos.y = std::max(-1.0f+barDims.y, barPos.y - seconds * barSpeedMultiplier); 
+    }
+}
+
+void PongSim::setTimeDelta(float timeDelta)
+{
+    this->timeDelta = timeDelta;
+}
+
+void PongSim::setGameParameters(float ballSpeed, float barSpeed, int maxScore)
+{
+    this->maxScore = maxScore;
+    // logarithmic scaling so that the ball doesnt get obscenely fast
+    this->ballSpeedMultiplier = log(1+ballSpeed)/log(3.3) ;
+    this->barSpeedMultiplier = barSpeed;
+}
+
+void PongSim::setBallInitialDirection()
+{
+    ballVelocity.x = ballSpeedMultiplier;
+    ballVelocity.y = ballSpeedMultiplier * glm::cos(sampleRandom());
+
+    // determining sign randomly	
+    if (sampleRandom() > 0.5) {
+        ballVelocity.x *= -1;
+    }
+    if (sampleRandom() > 0.5) {
+        ballVelocity.y *= -1;
+    }
+    
+    //printf("init ball velocity: %f ----- %f \n", ballVelocity.x, ballVelocity.y);
+}
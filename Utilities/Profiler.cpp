@@ -0,0 +1,250 @@
+#include "../Includes/Profiler.hpp"
+#include <glad/glad.h>
+#include <imgui.h>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+// Profiler.cpp holds logic for timing frames and drawing the performance overlay
+
+// names of the phases in the overlay and the csv header
+static const char* PHASE_NAMES[Profiler::PHASE_COUNT] = { "events", "sim", "ai", "draw", "imgui", "swap" };
+
+// we reserve room for this many captured frames up front so capturing does not allocate every frame (5 minutes at 60fps)
+static const size_t CAPTURE_RESERVE = 60 * 60 * 5;
+
+Profiler::Profiler()
+{
+    visible = false;
+    capturing = false;
+    active = false;
+    frameCount = 0;
+    historyIndex = 0;
+    queryRunning = false;
+    queriesReady = false;
+    lastGpuMs = 0.0f;
+    resources = nullptr;
+    memset(&current, 0, sizeof(current));
+    memset(&last, 0, sizeof(last));
+    simMeasuring.store(false);
+    memset(phaseHistory, 0, sizeof(phaseHistory));
+    memset(gpuHistory, 0, sizeof(gpuHistory));
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        simNanos[i].store(0);
+    }
+    for (int i = 0; i < QUERY_RING; i++) {
+        queries[i] = 0;
+        queryFrame[i] = 0;
+        queryPending[i] = false;
+    }
+}
+
+void Profiler::initQueries()
+{
+    glGenQueries(QUERY_RING, queries);
+    queriesReady = true;
+}
+
+void Profiler::destroyQueries()
+{
+    if (queriesReady) {
+        glDeleteQueries(QUERY_RING, queries);
+        queriesReady = false;
+    }
+}
+
+void Profiler::beginFrame()
+{
+    frameCount++;
+    active = visible || capturing;
+    simMeasuring.store(active, std::memory_order_relaxed);
+    if (!active) {
+        return;
+    }
+
+    memset(&current, 0, sizeof(current));
+    current.frame = frameCount;
+    current.gpuMs = -1.0f;
+
+    // only one GL_TIME_ELAPSED query can run at a time, and we skip a frame rather than reuse a query still in flight
+    int slot = (int)(frameCount % QUERY_RING);
+    if (queriesReady && !queryPending[slot]) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[slot]);
+        queryFrame[slot] = frameCount;
+        queryRunning = true;
+    }
+}
+
+void Profiler::beginPhase(Phase phase)
+{
+    if (!active) {
+        return;
+    }
+    phaseStart[phase] = clock::now();
+}
+
+void Profiler::endPhase(Phase phase)
+{
+    if (!active) {
+        return;
+    }
+    current.phaseMs[phase] += std::chrono::duration<float, std::milli>(clock::now() - phaseStart[phase]).count();
+}
+
+void Profiler::addSimTime(Phase phase, unsigned long long ns)
+{
+    // the simulation thread calls this every tick, so it must stay cheap even when nothing is being measured
+    if (!measuringSim()) {
+        return;
+    }
+    simNanos[phase].fetch_add(ns, std::memory_order_relaxed);
+}
+
+void Profiler::setRenderCounts(unsigned int drawCalls, unsigned int stateChanges)
+{
+    current.drawCalls = drawCalls;
+    current.stateChanges = stateChanges;
+}
+
+void Profiler::endGpuWork()
+{
+    if (!active || !queryRunning) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[frameCount % QUERY_RING] = true;
+    queryRunning = false;
+}
+
+void Profiler::endFrame()
+{
+    if (!active) {
+        return;
+    }
+    // whatever the simulation thread did since the last frame counts towards this one
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        unsigned long long nanos = simNanos[i].exchange(0, std::memory_order_relaxed);
+        current.phaseMs[i] += (float)(nanos / 1e6);
+    }
+
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        phaseHistory[i][historyIndex] = current.phaseMs[i];
+    }
+    historyIndex = (historyIndex + 1) % HISTORY;
+    last = current;
+
+    if (capturing) {
+        if (capture.capacity() == 0) {
+            capture.reserve(CAPTURE_RESERVE);
+        }
+        capture.push_back(current);
+    }
+
+    collectQueries();
+}
+
+void Profiler::collectQueries()
+{
+    if (!queriesReady) {
+        return;
+    }
+    for (int i = 0; i < QUERY_RING; i++) {
+        if (!queryPending[i]) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+        queryPending[i] = false;
+
+        float ms = nanoseconds / 1000000.0f;
+        lastGpuMs = ms;
+        // the graph is approximate by a few frames, the capture gets the result on the exact frame it measured
+        gpuHistory[(historyIndex + HISTORY - 1) % HISTORY] = ms;
+        unsigned long long age = frameCount - queryFrame[i];
+        if (age < capture.size()) {
+            FrameRecord& record = capture[capture.size() - 1 - age];
+            if (record.frame == queryFrame[i]) {
+                record.gpuMs = ms;
+            }
+        }
+    }
+}
+
+void Profiler::setResources(const GpuResourceManager* resources)
+{
+    this->resources = resources;
+}
+
+void Profiler::drawOverlay()
+{
+    if (!visible) {
+        return;
+    }
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    ImGui::Begin("Performance (F3)", &visible, ImGuiWindowFlags_AlwaysAutoResize);
+
+    int newest = (historyIndex + HISTORY - 1) % HISTORY;
+    float total = 0.0f;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        total += last.phaseMs[i];
+    }
+    ImGui::Text("cpu %.3f ms   gpu %.3f ms", total, lastGpuMs);
+    ImGui::Text("draw calls %u   state changes %u", last.drawCalls, last.stateChanges);
+    if (resources != nullptr) {
+        // these should stay flat while the game runs, anything that keeps growing is a leak
+        ImGui::Separator();
+        for (int i = 0; i < GPU_RESOURCE_TYPES; i++) {
+            GpuResourceType type = (GpuResourceType)i;
+            ImGui::Text("%-14s %4zu  %8.1f KB", GpuResourceManager::typeName(type), resources->liveCount(type), resources->liveBytes(type) / 1024.0);
+        }
+        ImGui::Text("pending deletes %zu", resources->pendingCount());
+    }
+    ImGui::Separator();
+
+    char overlay[32];
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        snprintf(overlay, sizeof(overlay), "%.3f ms", phaseHistory[i][newest]);
+        ImGui::PlotHistogram(PHASE_NAMES[i], phaseHistory[i], HISTORY, historyIndex, overlay, 0.0f, FLT_MAX, ImVec2(240, 40));
+    }
+    snprintf(overlay, sizeof(overlay), "%.3f ms", lastGpuMs);
+    ImGui::PlotHistogram("gpu", gpuHistory, HISTORY, historyIndex, overlay, 0.0f, FLT_MAX, ImVec2(240, 40));
+    ImGui::Separator();
+
+    ImGui::Checkbox("capture", &capturing);
+    ImGui::SameLine();
+    ImGui::Text("%zu frames", capture.size());
+    if (ImGui::Button("Dump CSV")) {
+        dumpCSV("profile.csv");
+    }
+    ImGui::End();
+}
+
+bool Profiler::dumpCSV(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        std::cout << "FAILED::PROFILER::WRITING::CSV: " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "frame");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        fprintf(file, ",%s_ms", PHASE_NAMES[i]);
+    }
+    fprintf(file, ",gpu_ms,draw_calls,state_changes\n");
+    for (size_t i = 0; i < capture.size(); i++) {
+        const FrameRecord& record = capture[i];
+        fprintf(file, "%llu", record.frame);
+        for (int j = 0; j < PHASE_COUNT; j++) {
+            fprintf(file, ",%.4f", record.phaseMs[j]);
+        }
+        fprintf(file, ",%.4f,%u,%u\n", record.gpuMs, record.drawCalls, record.stateChanges);
+    }
+    fclose(file);
+    capture.clear();
+    return true;
+}
@@ -0,0 +1,153 @@
+#include "../Includes/RenderCommands.hpp"
+#include "../Includes/GpuResources.hpp"
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+// RenderCommands.cpp holds logic for recording, sorting and executing draw commands
+
+RenderCommandList::RenderCommandList()
+{
+    count = 0;
+}
+
+void RenderCommandList::clear()
+{
+    count = 0;
+}
+
+bool RenderCommandList::draw(unsigned int program, unsigned int vertexArray, unsigned int texture, glm::vec2 translation, glm::vec2 textureShift, int indexCount, int layer)
+{
+    if (count == CAPACITY) {
+        return false;
+    }
+    RenderCommand& command = commands[count];
+    // layer | program | texture | vertex array | recording order, 12 bits each except the layer
+    command.sortKey = ((unsigned long long)(layer & 0xF) << 60)
+        | ((unsigned long long)(program & 0xFFF) << 48)
+        | ((unsigned long long)(texture & 0xFFF) << 36)
+        | ((unsigned long long)(vertexArray & 0xFFF) << 24)
+        | (unsigned long long)count;
+    command.program = program;
+    command.vertexArray = vertexArray;
+    command.texture = texture;
+    command.translation = translation;
+    command.textureShift = textureShift;
+    command.indexCount = indexCount;
+    count++;
+    return true;
+}
+
+void RenderCommandList::sort()
+{
+    // insertion sort: the list is tiny and usually already sorted from the last frame's recording order
+    for (int i = 1; i < count; i++) {
+        RenderCommand command = commands[i];
+        int j = i - 1;
+        while (j >= 0 && commands[j].sortKey > command.sortKey) {
+            commands[j + 1] = commands[j];
+            j--;
+        }
+        commands[j + 1] = command;
+    }
+}
+
+GLRenderBackend::GLRenderBackend()
+{
+    programCount = 0;
+    resources = nullptr;
+    programDeletions = 0;
+}
+
+void GLRenderBackend::setResources(const GpuResourceManager* resources)
+{
+    this->resources = resources;
+    programCount = 0;
+    programDeletions = resources != nullptr ? resources->deletedCount(GPU_PROGRAM) : 0;
+}
+
+const GLRenderBackend::ProgramUniforms& GLRenderBackend::lookup(unsigned int program)
+{
+    for (int i = 0; i < programCount; i++) {
+        if (uniforms[i].program == program) {
+            return uniforms[i];
+        }
+    }
+    // table full: reuse the last slot rather than fail, it just means looking the locations up again
+    int slot = programCount < MAX_PROGRAMS ? programCount++ : MAX_PROGRAMS - 1;
+    uniforms[slot].program = program;
+    uniforms[slot].transformation = glGetUniformLocation(program, "transformation");
+    uniforms[slot].textureShift = glGetUniformLocation(program, "textureShift");
+    return uniforms[slot];
+}
+
+void GLRenderBackend::execute(const RenderCommandList& list)
+{
+    drawCalls = 0;
+    stateChanges = 0;
+
+    // a deleted program's name may belong to a new program now, with other locations
+    if (resources != nullptr && resources->deletedCount(GPU_PROGRAM) != programDeletions) {
+        programDeletions = resources->deletedCount(GPU_PROGRAM);
+        programCount = 0;
+    }
+
+    // anything (ImGui in particular) may have changed state since the last list, so the first command always binds
+    unsigned int currentProgram = 0, currentVertexArray = 0, currentTexture = 0;
+    const ProgramUniforms* programUniforms = nullptr;
+    for (int i = 0; i < list.count; i++) {
+        const RenderCommand& command = list.commands[i];
+        if (command.program != currentProgram) {
+            glUseProgram(command.program);
+            programUniforms = &lookup(command.program);
+            currentProgram = command.program;
+            stateChanges++;
+        }
+        if (command.texture != 0 && command.texture != currentTexture) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, command.texture);
+            currentTexture = command.texture;
+            stateChanges++;
+        }
+        if (command.vertexArray != currentVertexArray) {
+            glBindVertexArray(command.vertexArray);
+            currentVertexArray = command.vertexArray;
+            stateChanges++;
+        }
+
+        // instance data
+        glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(command.translation, 0.0f));
+        glUniformMatrix4fv(programUniforms->transformation, 1, GL_FALSE, glm::value_ptr(translation));
+        if (programUniforms->textureShift != -1) {
+            glUniform2f(programUniforms->textureShift, command.textureShift.x, command.textureShift.y);
+        }
+
+        glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0);
+        drawCalls++;
+    }
+    glBindVertexArray(0);
+}
+
+void NullRenderBackend::execute(const RenderCommandList& list)
+{
+    drawCalls = 0;
+    stateChanges = 0;
+
+    // same bookkeeping as the opengl backend, without the opengl
+    unsigned int currentProgram = 0, currentVertexArray = 0, currentTexture = 0;
+    for (int i = 0; i < list.count; i++) {
+        const RenderCommand& command = list.commands[i];
+        if (command.program != currentProgram) {
+            currentProgram = command.program;
+            stateChanges++;
+        }
+        if (command.texture != 0 && command.texture != currentTexture) {
+            currentTexture = command.texture;
+            stateChanges++;
+        }
+        if (command.vertexArray != currentVertexArray) {
+            currentVertexArray = command.vertexArray;
+            stateChanges++;
+        }
+        drawCalls++;
+    }
+}
@@ -0,0 +1,908 @@
+#include "../Includes/Replay.hpp"
+#include "../Includes/ByteIO.hpp"
+#include "../Includes/BlockCodec.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+// Replay.cpp holds logic for writing a match's input to a replay file and stepping a match through one
+
+// how long the writer thread sleeps when there is nothing to write
+static const int WRITER_SLEEP_MS = 10;
+
+// how a block's records are stored
+static const int CODEC_STORED = 0;
+static const int CODEC_BLOCK = 1;
+
+// bytes reserved for a block up front, about what one holds
+static const size_t BLOCK_RESERVE = 4096;
+
+// a block claiming more records than this is damaged, not long
+static const unsigned long long BLOCK_MAX_BYTES = 1ull << 26;
+
+// bytes after a record's varint, by the varint
+static size_t recordBodyBytes(unsigned long long value)
+{
+    int kind = (int)(value & 3);
+    int event = (int)((value >> 2) & 3);
+    if (kind == REPLAY_CHANGE) {
+        return 1;
+    }
+    if (kind == REPLAY_EVENT && event == REPLAY_SETTINGS) {
+        return 9;
+    }
+    if (kind == REPLAY_EVENT && event == REPLAY_KEYFRAME) {
+        return 1 + PongSim::STATE_BYTES;
+    }
+    if (kind == REPLAY_EVENT && event == REPLAY_RESULT) {
+        return 10;
+    }
+    if (kind == REPLAY_MARK && event == REPLAY_HASH) {
+        return 2;
+    }
+    return 0;
+}
+
+// the offset an offset byte stands for, the same expression on both sides so the floats match bit for bit
+static float offsetOf(int steps, float timeDelta)
+{
+    return (float)steps / 256.0f * timeDelta;
+}
+
+void startReplayMatch(PongSim& sim, const ReplayHeader& header)
+{
+    sim = PongSim();
+    sim.seed(header.seed);
+    sim.setGameParameters(header.ballSpeed, header.barSpeed, header.maxScore);
+    sim.setTimeDelta(1.0f / header.tickRate);
+    sim.resetGame(true);
+}
+
+// the state a match with these settings starts from, what the first keyframe of every block is coded against
+static void startingState(const ReplayHeader& header, unsigned char* state)
+{
+    PongSim sim;
+    startReplayMatch(sim, header);
+    sim.writeState(state);
+}
+
+bool listReplays(const char* directory, std::vector<std::string>* paths)
+{
+    const std::string extension = ".replay";
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA found;
+    HANDLE search = FindFirstFileA((std::string(directory) + "\\*" + extension).c_str(), &found);
+    if (search == INVALID_HANDLE_VALUE) {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+    do {
+        if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            names.push_back(found.cFileName);
+        }
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+#else
+    DIR* listing = opendir(directory);
+    if (listing == nullptr) {
+        return false;
+    }
+    while (dirent* entry = readdir(listing)) {
+        std::string name = entry->d_name;
+        if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(listing);
+#endif
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names) {
+        paths->push_back(std::string(directory) + "/" + name);
+    }
+    return true;
+}
+
+ReplayWriter::ReplayWriter()
+    : alive(false)
+{
+    file = nullptr;
+    compress = true;
+    hashTicks = REPLAY_HASH_TICKS;
+    ended = false;
+    finalTicks = 0;
+    written = 0;
+    block = nullptr;
+    begun = false;
+    tick = lastRecordTick = byteCount = 0;
+    keyframeBaseTick = 0;
+    direction = 0;
+    timeDelta = 0.0f;
+    ballSpeed = barSpeed = 0.0f;
+    maxScore = 0;
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    finish();
+}
+
+bool ReplayWriter::open(const char* path)
+{
+    if (file != nullptr) {
+        return false;
+    }
+    file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    ended = false;
+    written = 0;
+    index.clear();
+    alive.store(true);
+    thread = std::thread(&ReplayWriter::run, this);
+    return true;
+}
+
+void ReplayWriter::setCompression(bool compress)
+{
+    if (!begun) {
+        this->compress = compress;
+    }
+}
+
+void ReplayWriter::setHashInterval(int ticks)
+{
+    if (!begun) {
+        hashTicks = ticks;
+    }
+}
+
+void ReplayWriter::begin(const ReplayHeader& header)
+{
+    if (file == nullptr || begun) {
+        return;
+    }
+    block = new Block();
+    block->header = true;
+    block->firstTick = 0;
+    unsigned char bytes[REPLAY_HEADER_SIZE];
+    unsigned char* out = bytes;
+    writeU32(out, REPLAY_MAGIC);
+    writeU8(out, (unsigned char)REPLAY_VERSION);
+    writeU16(out, (unsigned short)header.tickRate);
+    writeU32(out, header.seed);
+    writeF32(out, header.ballSpeed);
+    writeF32(out, header.barSpeed);
+    writeU8(out, (unsigned char)header.maxScore);
+    append(bytes, out);
+
+    begun = true;
+    tick = lastRecordTick = 0;
+    direction = 0;
+    timeDelta = 1.0f / header.tickRate;
+    ballSpeed = header.ballSpeed;
+    barSpeed = header.barSpeed;
+    maxScore = header.maxScore;
+    opening = header;
+    startingState(header, startState);
+    closeBlock();
+}
+
+bool ReplayWriter::started() const
+{
+    return begun;
+}
+
+void ReplayWriter::append(const unsigned char* bytes, const unsigned char* end)
+{
+    block->bytes.insert(block->bytes.end(), bytes, end);
+    byteCount += end - bytes;
+}
+
+void ReplayWriter::writeRecord(int kind, int value)
+{
+    unsigned char bytes[VARINT_MAX_BYTES];
+    unsigned char* out = bytes;
+    writeVarint(out, ((tick - lastRecordTick) << 4) | ((unsigned long long)value << 2) | (unsigned long long)kind);
+    append(bytes, out);
+    lastRecordTick = tick;
+}
+
+void ReplayWriter::settings(float ballSpeed, float barSpeed, int maxScore)
+{
+    if (!begun || (ballSpeed == this->ballSpeed && barSpeed == this->barSpeed && maxScore == this->maxScore)) {
+        return;
+    }
+    this->ballSpeed = ballSpeed;
+    this->barSpeed = barSpeed;
+    this->maxScore = maxScore;
+    writeSettings();
+}
+
+void ReplayWriter::writeSettings()
+{
+    writeRecord(REPLAY_EVENT, REPLAY_SETTINGS);
+    unsigned char bytes[9];
+    unsigned char* out = bytes;
+    writeF32(out, ballSpeed);
+    writeF32(out, barSpeed);
+    writeU8(out, (unsigned char)maxScore);
+    append(bytes, out);
+}
+
+void ReplayWriter::reset()
+{
+    if (begun) {
+        writeRecord(REPLAY_EVENT, REPLAY_RESET);
+    }
+}
+
+void ReplayWriter::recordTick(TickInput& input, const PongSim& sim)
+{
+    if (!begun) {
+        return;
+    }
+    if (tick > 0 && tick % REPLAY_KEYFRAME_TICKS == 0) {
+        if ((tick / REPLAY_KEYFRAME_TICKS) % REPLAY_BLOCK_KEYFRAMES == 0) {
+            // the block so far goes to disk now, so a crash keeps the recording up to here
+            closeBlock();
+        }
+        else {
+            // a block the queue had no room for can go now
+            handOver();
+        }
+        block->keyframeTicks.push_back((unsigned int)tick);
+        writeRecord(REPLAY_EVENT, REPLAY_KEYFRAME);
+        unsigned char bytes[1 + PongSim::STATE_BYTES];
+        unsigned char* out = bytes;
+        writeU8(out, (unsigned char)(direction + 1));
+        sim.writeKeyframe(out, keyframeBase, (unsigned int)(tick - keyframeBaseTick));
+        append(bytes, out);
+        // the next keyframe in the block is coded against this one
+        unsigned char* base = keyframeBase;
+        sim.writeState(base);
+        keyframeBaseTick = tick;
+    }
+    // a keyframe checks the whole state already
+    else if (hashTicks > 0 && tick % hashTicks == 0) {
+        writeRecord(REPLAY_MARK, REPLAY_HASH);
+        unsigned char bytes[2];
+        unsigned char* out = bytes;
+        writeU16(out, (unsigned short)sim.stateHash());
+        append(bytes, out);
+    }
+    if (input.direction != direction) {
+        writeRecord(REPLAY_DIRECTION, input.direction + 1);
+    }
+    for (int i = 0; i < input.changeCount; i++) {
+        // a change right at the start would have been the tick's direction, so steps run from 1 to 255
+        int steps = (int)(input.changeOffsets[i] / timeDelta * 256.0f + 0.5f);
+        steps = steps < 1 ? 1 : (steps > 255 ? 255 : steps);
+        input.changeOffsets[i] = offsetOf(steps, timeDelta);
+        writeRecord(REPLAY_CHANGE, input.changes[i] + 1);
+        unsigned char offset = (unsigned char)steps;
+        append(&offset, &offset + 1);
+    }
+    direction = input.finalDirection();
+    tick++;
+}
+
+void ReplayWriter::result(const PongSim& sim)
+{
+    if (!begun) {
+        return;
+    }
+    writeRecord(REPLAY_EVENT, REPLAY_RESULT);
+    unsigned char bytes[10];
+    unsigned char* out = bytes;
+    writeU8(out, (unsigned char)sim.leftScore);
+    writeU8(out, (unsigned char)sim.rightScore);
+    writeI64(out, (long long)sim.stateHash());
+    append(bytes, out);
+}
+
+void ReplayWriter::closeBlock()
+{
+    if (block->header || !block->bytes.empty()) {
+        waiting.push_back(block);
+        block = new Block();
+        block->header = false;
+        block->bytes.reserve(BLOCK_RESERVE);
+    }
+    // the first record of a block counts its ticks from here, so the block reads on its own
+    block->firstTick = (unsigned int)tick;
+    lastRecordTick = tick;
+    memcpy(keyframeBase, startState, sizeof(keyframeBase));
+    keyframeBaseTick = 0;
+    // keyframes leave the settings out, so a block read on its own has to start from the ones in force
+    if (ballSpeed != opening.ballSpeed || barSpeed != opening.barSpeed || maxScore != opening.maxScore) {
+        writeSettings();
+    }
+    handOver();
+}
+
+void ReplayWriter::handOver()
+{
+    size_t handed = 0;
+    while (handed < waiting.size() && full.push(waiting[handed])) {
+        handed++;
+    }
+    // whatever the writer thread is too far behind to take waits for the next keyframe
+    waiting.erase(waiting.begin(), waiting.begin() + handed);
+}
+
+void ReplayWriter::finish()
+{
+    if (file == nullptr) {
+        return;
+    }
+    if (begun) {
+        writeRecord(REPLAY_MARK, REPLAY_END);
+        closeBlock();
+        ended = true;
+        finalTicks = tick;
+    }
+    while (!waiting.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        handOver();
+    }
+    delete block;
+    block = nullptr;
+    alive.store(false, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+    }
+    fclose(file);
+    file = nullptr;
+    begun = false;
+}
+
+unsigned long long ReplayWriter::ticks() const
+{
+    return tick;
+}
+
+unsigned long long ReplayWriter::bytes() const
+{
+    return byteCount;
+}
+
+unsigned long long ReplayWriter::fileBytes() const
+{
+    return written;
+}
+
+void ReplayWriter::writeBlock(const Block& finished)
+{
+    if (finished.header) {
+        fwrite(finished.bytes.data(), 1, finished.bytes.size(), file);
+        written += finished.bytes.size();
+        return;
+    }
+    for (unsigned int keyframeTick : finished.keyframeTicks) {
+        ReplayKeyframe keyframe = { keyframeTick, (unsigned int)written };
+        index.push_back(keyframe);
+    }
+    packed.clear();
+    if (compress) {
+        compressBlock(finished.bytes.data(), finished.bytes.size(), &packed);
+    }
+    // a block the codec could not shrink is stored as it is
+    bool stored = !compress || packed.size() >= finished.bytes.size();
+    const unsigned char* payload = stored ? finished.bytes.data() : packed.data();
+    size_t payloadSize = stored ? finished.bytes.size() : packed.size();
+
+    unsigned char header[1 + 3 * VARINT_MAX_BYTES + 4];
+    unsigned char* out = header;
+    writeU8(out, (unsigned char)(stored ? CODEC_STORED : CODEC_BLOCK));
+    writeVarint(out, finished.firstTick);
+    writeVarint(out, finished.bytes.size());
+    writeVarint(out, payloadSize);
+    // the header too, a first tick that changed would move every record in the block
+    unsigned int checksum = blockChecksum(header, out - header);
+    writeU32(out, blockChecksum(finished.bytes.data(), finished.bytes.size(), checksum));
+    fwrite(header, 1, out - header, file);
+    fwrite(payload, 1, payloadSize, file);
+    written += (out - header) + payloadSize;
+}
+
+void ReplayWriter::run()
+{
+    while (true) {
+        // checked before draining, so whatever was handed over before finish() is still written
+        bool stopping = !alive.load(std::memory_order_acquire);
+        Block* finished;
+        bool wrote = false;
+        while (full.pop(finished)) {
+            writeBlock(*finished);
+            delete finished;
+            wrote = true;
+        }
+        if (stopping) {
+            if (ended) {
+                // the index goes after the last block, so it knows where every block went
+                std::vector<unsigned char> trailer(index.size() * 8 + REPLAY_TRAILER_SIZE);
+                unsigned char* out = trailer.data();
+                for (const ReplayKeyframe& keyframe : index) {
+                    writeU32(out, keyframe.tick);
+                    writeU32(out, keyframe.offset);
+                }
+                writeU32(out, (unsigned int)written);
+                writeU32(out, (unsigned int)index.size());
+                writeU32(out, (unsigned int)finalTicks);
+                writeU32(out, REPLAY_INDEX_MAGIC);
+                fwrite(trailer.data(), 1, trailer.size(), file);
+                written += trailer.size();
+            }
+            fflush(file);
+            break;
+        }
+        if (wrote) {
+            fflush(file);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_SLEEP_MS));
+    }
+}
+
+ReplayReader::ReplayReader()
+{
+    data = nullptr;
+    dataSize = 0;
+    blockLoaded = false;
+    blockOffset = nextBlock = 0;
+    blockFirstTick = blockLastTick = 0;
+    keyframeBaseTick = 0;
+    records = nullptr;
+    recordsSize = 0;
+    info.tickRate = 60;
+    info.seed = 0;
+    info.ballSpeed = 1.0f;
+    info.barSpeed = 5.0f;
+    info.maxScore = 10;
+    totalTicks = 0;
+    playing = nullptr;
+    position = 0;
+    current = nextRecord = recordValue = lastRecord = 0;
+    recordBody = 0;
+    haveRecord = ended = finished = false;
+    mismatch = haveResult = damagedBlock = false;
+    firstMismatch = lastMatch = 0;
+    stored.leftScore = stored.rightScore = 0;
+    stored.stateHash = 0;
+    direction = 0;
+}
+
+bool ReplayReader::open(const char* path)
+{
+    keyframes.clear();
+    totalTicks = 0;
+    playing = nullptr;
+    blockLoaded = false;
+    damagedBlock = false;
+    if (!file.open(path) || file.size() < (size_t)REPLAY_HEADER_SIZE) {
+        file.close();
+        return false;
+    }
+    data = file.data();
+    dataSize = file.size();
+    const unsigned char* in = data;
+    if (readU32(in) != REPLAY_MAGIC || readU8(in) != REPLAY_VERSION) {
+        file.close();
+        return false;
+    }
+    info.tickRate = readU16(in);
+    info.seed = readU32(in);
+    info.ballSpeed = readF32(in);
+    info.barSpeed = readF32(in);
+    info.maxScore = readU8(in);
+    if (info.tickRate <= 0) {
+        file.close();
+        return false;
+    }
+    startingState(info, startState);
+    if (!readIndex()) {
+        scanBlocks();
+    }
+    return true;
+}
+
+bool ReplayReader::readIndex()
+{
+    if (dataSize < (size_t)(REPLAY_HEADER_SIZE + REPLAY_TRAILER_SIZE)) {
+        return false;
+    }
+    const unsigned char* in = data + dataSize - REPLAY_TRAILER_SIZE;
+    size_t indexOffset = readU32(in);
+    size_t count = readU32(in);
+    unsigned long long ticks = readU32(in);
+    if (readU32(in) != REPLAY_INDEX_MAGIC || indexOffset < (size_t)REPLAY_HEADER_SIZE ||
+        indexOffset + count * 8 + REPLAY_TRAILER_SIZE != dataSize) {
+        return false;
+    }
+    in = data + indexOffset;
+    keyframes.resize(count);
+    for (ReplayKeyframe& keyframe : keyframes) {
+        keyframe.tick = readU32(in);
+        keyframe.offset = readU32(in);
+        if (keyframe.offset < (unsigned int)REPLAY_HEADER_SIZE || keyframe.offset >= indexOffset) {
+            keyframes.clear();
+            return false;
+        }
+    }
+    dataSize = indexOffset;
+    totalTicks = ticks;
+    return true;
+}
+
+bool ReplayReader::loadBlock(size_t offset)
+{
+    blockLoaded = false;
+    if (offset >= dataSize) {
+        return false;
+    }
+    const unsigned char* in = data + offset;
+    const unsigned char* end = data + dataSize;
+    int codec = readU8(in);
+    unsigned long long firstTick, rawSize, storedSize;
+    if (!readVarint(in, end, &firstTick) || !readVarint(in, end, &rawSize) || !readVarint(in, end, &storedSize) ||
+        (size_t)(end - in) < 4 || storedSize > (unsigned long long)(end - in) - 4 || rawSize > BLOCK_MAX_BYTES) {
+        return false;
+    }
+    size_t headerSize = in - (data + offset);
+    unsigned int checksum = readU32(in);
+    // the whole block is here from now on, so failing to read it means it is damaged rather than cut short
+    if (codec == CODEC_STORED && rawSize == storedSize) {
+        records = in;
+    }
+    else if (codec == CODEC_BLOCK) {
+        blockBuffer.resize((size_t)rawSize);
+        if (!decompressBlock(in, (size_t)storedSize, blockBuffer.data(), (size_t)rawSize)) {
+            damagedBlock = true;
+            return false;
+        }
+        records = blockBuffer.data();
+    }
+    else {
+        damagedBlock = true;
+        return false;
+    }
+    if (blockChecksum(records, (size_t)rawSize, blockChecksum(data + offset, headerSize)) != checksum) {
+        damagedBlock = true;
+        return false;
+    }
+    recordsSize = (size_t)rawSize;
+    blockOffset = offset;
+    nextBlock = (in - data) + (size_t)storedSize;
+    blockFirstTick = firstTick;
+    memcpy(keyframeBase, startState, sizeof(keyframeBase));
+    keyframeBaseTick = 0;
+    // a block closes on the keyframe that opens the next one, so none of its records can be later than that
+    blockLastTick = firstTick + REPLAY_KEYFRAME_TICKS * REPLAY_BLOCK_KEYFRAMES;
+    const unsigned char* next = data + nextBlock;
+    unsigned long long nextFirstTick;
+    if (nextBlock < dataSize && readU8(next) <= CODEC_BLOCK && readVarint(next, end, &nextFirstTick) &&
+        nextFirstTick < blockLastTick) {
+        blockLastTick = nextFirstTick;
+    }
+    // nor than the end of the match, if the index says where that is
+    if (totalTicks > 0 && totalTicks < blockLastTick) {
+        blockLastTick = totalTicks;
+    }
+    position = 0;
+    blockLoaded = true;
+    return true;
+}
+
+void ReplayReader::scanBlocks()
+{
+    unsigned long long tick = 0;
+    size_t offset = REPLAY_HEADER_SIZE;
+    bool over = false;
+    while (!over && loadBlock(offset)) {
+        offset = nextBlock;
+        const unsigned char* in = records;
+        const unsigned char* end = records + recordsSize;
+        tick = blockFirstTick;
+        unsigned long long value;
+        while (readVarint(in, end, &value)) {
+            unsigned long long recordTick = tick + (value >> 4);
+            size_t body = recordBodyBytes(value);
+            if (body > (size_t)(end - in)) {
+                break;
+            }
+            if (recordTick > blockLastTick) {
+                // a damaged delta, the file is no good from here on
+                over = true;
+                break;
+            }
+            tick = recordTick;
+            if ((value & 3) == REPLAY_MARK && ((value >> 2) & 3) == REPLAY_END) {
+                over = true;
+                break;
+            }
+            if ((value & 3) == REPLAY_EVENT && ((value >> 2) & 3) == REPLAY_KEYFRAME) {
+                ReplayKeyframe keyframe = { (unsigned int)tick, (unsigned int)blockOffset };
+                keyframes.push_back(keyframe);
+            }
+            in += body;
+        }
+    }
+    blockLoaded = false;
+    // a cut short file stops before the tick of its last record, the same as step() does
+    totalTicks = tick;
+}
+
+const ReplayHeader& ReplayReader::header() const
+{
+    return info;
+}
+
+void ReplayReader::start(PongSim& sim)
+{
+    startReplayMatch(sim, info);
+    blockLoaded = false;
+    nextBlock = REPLAY_HEADER_SIZE;
+    current = 0;
+    lastRecord = 0;
+    ended = finished = false;
+    mismatch = haveResult = false;
+    firstMismatch = lastMatch = 0;
+    playing = &sim;
+    direction = 0;
+    peekRecord();
+}
+
+bool ReplayReader::restore(PongSim& sim, const ReplayKeyframe& keyframe)
+{
+    // seeking back and forth inside one block only decompresses it once
+    if (!(blockLoaded && blockOffset == keyframe.offset) && !loadBlock(keyframe.offset)) {
+        return false;
+    }
+    // walk the block's records up to the keyframe
+    const unsigned char* in = records;
+    const unsigned char* end = records + recordsSize;
+    unsigned long long tick = blockFirstTick;
+    unsigned long long value;
+    // the settings in force at the keyframe are the header's, unless the block says otherwise, and every keyframe
+    // is coded against the one before it in the block
+    startReplayMatch(sim, info);
+    memcpy(keyframeBase, startState, sizeof(keyframeBase));
+    keyframeBaseTick = 0;
+    while (true) {
+        if (!readVarint(in, end, &value)) {
+            return false;
+        }
+        tick += value >> 4;
+        size_t body = recordBodyBytes(value);
+        if (body > (size_t)(end - in) || tick > keyframe.tick) {
+            return false;
+        }
+        if ((value & 3) == REPLAY_EVENT && ((value >> 2) & 3) == REPLAY_KEYFRAME) {
+            const unsigned char* state = in + 1;
+            sim.readKeyframe(state, keyframeBase, (unsigned int)(tick - keyframeBaseTick));
+            unsigned char* base = keyframeBase;
+            sim.writeState(base);
+            keyframeBaseTick = tick;
+            if (tick == keyframe.tick) {
+                break;
+            }
+        }
+        if ((value & 3) == REPLAY_EVENT && ((value >> 2) & 3) == REPLAY_SETTINGS) {
+            const unsigned char* settings = in;
+            float ballSpeed = readF32(settings);
+            float barSpeed = readF32(settings);
+            int maxScore = readU8(settings);
+            sim.setGameParameters(ballSpeed, barSpeed, maxScore);
+        }
+        in += body;
+    }
+    direction = readU8(in) - 1;
+    position = (in - records) + PongSim::STATE_BYTES;
+    current = lastRecord = keyframe.tick;
+    ended = finished = false;
+    // the match is right by construction up to here, whatever was found before the jump no longer applies
+    mismatch = haveResult = false;
+    firstMismatch = 0;
+    lastMatch = keyframe.tick;
+    playing = &sim;
+    peekRecord();
+    return true;
+}
+
+void ReplayReader::peekRecord()
+{
+    while (!blockLoaded || position >= recordsSize) {
+        // this block is done, the next one counts its ticks from its own first tick
+        if (!loadBlock(nextBlock)) {
+            haveRecord = false;
+            return;
+        }
+        lastRecord = blockFirstTick;
+    }
+    const unsigned char* in = records + position;
+    haveRecord = readVarint(in, records + recordsSize, &recordValue);
+    if (haveRecord) {
+        nextRecord = lastRecord + (recordValue >> 4);
+        recordBody = in - records;
+        // a record whose body was cut off does not count
+        haveRecord = recordBodyBytes(recordValue) <= recordsSize - recordBody;
+        if (haveRecord && nextRecord > blockLastTick) {
+            // a damaged delta would have us play on for ever towards it
+            damagedBlock = true;
+            haveRecord = false;
+        }
+    }
+}
+
+bool ReplayReader::step(PongSim& sim)
+{
+    if (ended) {
+        return false;
+    }
+    TickInput input = TickInput::constant(direction);
+    while (haveRecord && nextRecord == current) {
+        int kind = (int)(recordValue & 3);
+        int value = (int)((recordValue >> 2) & 3);
+        const unsigned char* in = records + recordBody;
+        if (kind == REPLAY_MARK && value == REPLAY_END) {
+            ended = finished = true;
+            return false;
+        }
+        if (kind == REPLAY_MARK && value == REPLAY_HASH) {
+            // the low bits of the hash of the state this tick starts from
+            check((sim.stateHash() & 0xFFFF) == readU16(in));
+        }
+        else if (kind == REPLAY_MARK) {
+            // no writer makes other marks, the block decoded to something it never held
+            damagedBlock = true;
+            ended = true;
+            return false;
+        }
+        else if (kind == REPLAY_CHANGE) {
+            float offset = offsetOf(readU8(in), sim.timeDelta);
+            if (input.changeCount < TickInput::MAX_CHANGES) {
+                input.changeOffsets[input.changeCount] = offset;
+                input.changes[input.changeCount] = value - 1;
+                input.changeCount++;
+            }
+        }
+        else if (kind == REPLAY_DIRECTION) {
+            input.direction = value - 1;
+        }
+        else if (value == REPLAY_SETTINGS) {
+            float ballSpeed = readF32(in);
+            float barSpeed = readF32(in);
+            int maxScore = readU8(in);
+            sim.setGameParameters(ballSpeed, barSpeed, maxScore);
+        }
+        else if (value == REPLAY_RESET) {
+            sim.resetGame(true);
+        }
+        else if (value == REPLAY_KEYFRAME) {
+            // playing through a keyframe changes nothing, it only checks we got to the same state: coded against the
+            // same base, the same state gives the same bytes
+            unsigned char state[PongSim::STATE_BYTES];
+            unsigned char* out = state;
+            sim.writeKeyframe(out, keyframeBase, (unsigned int)(current - keyframeBaseTick));
+            int storedDirection = readU8(in) - 1;
+            check(storedDirection == direction && memcmp(state, in, PongSim::STATE_BYTES) == 0);
+            out = keyframeBase;
+            sim.writeState(out);
+            keyframeBaseTick = current;
+        }
+        else if (value == REPLAY_RESULT) {
+            stored.leftScore = readU8(in);
+            stored.rightScore = readU8(in);
+            stored.stateHash = (unsigned long long)readI64(in);
+            haveResult = true;
+            check(sim.leftScore == stored.leftScore && sim.rightScore == stored.rightScore && sim.stateHash() == stored.stateHash);
+        }
+        position = recordBody + recordBodyBytes(recordValue);
+        lastRecord = nextRecord;
+        peekRecord();
+    }
+    // cut short: play up to the last whole record
+    if (!haveRecord || nextRecord < current) {
+        ended = true;
+        return false;
+    }
+    sim.step(input, sim.aiDirection(false));
+    direction = input.finalDirection();
+    current++;
+    return true;
+}
+
+bool ReplayReader::seek(PongSim& sim, unsigned long long tick)
+{
+    // the last keyframe at or before tick
+    size_t low = 0, high = keyframes.size();
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (keyframes[middle].tick <= tick) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    // carrying on from where we are beats restoring a keyframe we have already passed
+    bool ahead = playing == &sim && current <= tick && (low == 0 || keyframes[low - 1].tick <= current);
+    if (!ahead) {
+        if (low == 0) {
+            start(sim);
+        }
+        else if (!restore(sim, keyframes[low - 1])) {
+            // a keyframe that is not where the index says, the long way still gets there
+            start(sim);
+        }
+    }
+    while (current < tick) {
+        if (!step(sim)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReplayReader::check(bool same)
+{
+    if (same && !mismatch) {
+        lastMatch = current;
+    }
+    else if (!same && !mismatch) {
+        mismatch = true;
+        firstMismatch = current;
+    }
+}
+
+unsigned long long ReplayReader::tick() const
+{
+    return current;
+}
+
+unsigned long long ReplayReader::length() const
+{
+    return totalTicks;
+}
+
+const std::vector<ReplayKeyframe>& ReplayReader::index() const
+{
+    return keyframes;
+}
+
+bool ReplayReader::complete() const
+{
+    return finished;
+}
+
+bool ReplayReader::damaged() const
+{
+    return damagedBlock;
+}
+
+bool ReplayReader::diverged() const
+{
+    return mismatch;
+}
+
+unsigned long long ReplayReader::divergedTick() const
+{
+    return firstMismatch;
+}
+
+unsigned long long ReplayReader::verifiedTick() const
+{
+    return lastMatch;
+}
+
+bool ReplayReader::storedResult(ReplayResult* result) const
+{
+    if (haveResult) {
+        *result = stored;
+    }
+    return haveResult;
+}
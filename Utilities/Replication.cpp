@@ -0,0 +1,171 @@
+#include "../Includes/Replication.hpp"
+#include "../Includes/BitStream.hpp"
+// Replication.cpp holds logic for quantizing match state and bit packing it as deltas
+
+// how many bits a changed position's zigzagged delta is written in, by size class (the last class is the plain value)
+static const int DELTA_BITS[4] = { 5, 8, 11, POSITION_BITS };
+
+static const unsigned int POSITION_MAX = (1u << POSITION_BITS) - 1;
+
+// scores are sent whole, all of the u8 a ReplicatedState holds them in, so no max score can wrap them
+static const int SCORE_BITS = 8;
+
+static unsigned short quantizePosition(float value)
+{
+    float scaled = (value + POSITION_RANGE) / (2.0f * POSITION_RANGE) * POSITION_MAX + 0.5f;
+    if (scaled <= 0.0f) {
+        return 0;
+    }
+    if (scaled >= (float)POSITION_MAX) {
+        return (unsigned short)POSITION_MAX;
+    }
+    return (unsigned short)scaled;
+}
+
+float dequantizePosition(unsigned short value)
+{
+    return (float)value / POSITION_MAX * (2.0f * POSITION_RANGE) - POSITION_RANGE;
+}
+
+ReplicatedState replicate(const PongSim& sim)
+{
+    ReplicatedState state;
+    state.tick = (unsigned int)sim.tick;
+    state.leftBar = quantizePosition(sim.leftBarPos.y);
+    state.rightBar = quantizePosition(sim.rightBarPos.y);
+    state.ballX = quantizePosition(sim.ballPos.x);
+    state.ballY = quantizePosition(sim.ballPos.y);
+    state.leftScore = (unsigned char)sim.leftScore;
+    state.rightScore = (unsigned char)sim.rightScore;
+    return state;
+}
+
+static void writePosition(BitWriter& writer, unsigned short base, unsigned short value)
+{
+    if (value == base) {
+        writer.writeBit(false);
+        return;
+    }
+    writer.writeBit(true);
+    // zigzag so small changes either way are small numbers
+    int delta = (int)value - (int)base;
+    unsigned int zigzag = delta >= 0 ? (unsigned int)delta << 1 : ((unsigned int)(-delta) << 1) - 1;
+    for (int size = 0; size < 3; size++) {
+        if (zigzag < (1u << DELTA_BITS[size])) {
+            writer.write(size, 2);
+            writer.write(zigzag, DELTA_BITS[size]);
+            return;
+        }
+    }
+    writer.write(3, 2);
+    writer.write(value, POSITION_BITS);
+}
+
+static unsigned short readPosition(BitReader& reader, unsigned short base)
+{
+    if (!reader.readBit()) {
+        return base;
+    }
+    int size = (int)reader.read(2);
+    unsigned int bits = reader.read(DELTA_BITS[size]);
+    if (size == 3) {
+        return (unsigned short)bits;
+    }
+    int delta = (bits & 1) ? -(int)((bits + 1) >> 1) : (int)(bits >> 1);
+    return (unsigned short)(((int)base + delta) & POSITION_MAX);
+}
+
+int encodeState(const ReplicatedState* base, const ReplicatedState& state, unsigned char* out)
+{
+    BitWriter writer(out, REPLICATION_MAX_BYTES);
+    if (base == nullptr) {
+        // full state: everything as is
+        writer.writeBit(false);
+        writer.write(state.tick, 32);
+        writer.write(state.leftBar, POSITION_BITS);
+        writer.write(state.rightBar, POSITION_BITS);
+        writer.write(state.ballX, POSITION_BITS);
+        writer.write(state.ballY, POSITION_BITS);
+        writer.write(state.leftScore, SCORE_BITS);
+        writer.write(state.rightScore, SCORE_BITS);
+        return writer.finish();
+    }
+
+    // the base is named by the low bits of its tick, the receiver works out the rest from what it has
+    writer.writeBit(true);
+    writer.write(base->tick & 0xFF, 8);
+    writer.write(state.tick - base->tick, 5);
+    writePosition(writer, base->leftBar, state.leftBar);
+    writePosition(writer, base->rightBar, state.rightBar);
+    writePosition(writer, base->ballX, state.ballX);
+    writePosition(writer, base->ballY, state.ballY);
+    bool scored = state.leftScore != base->leftScore || state.rightScore != base->rightScore;
+    writer.writeBit(scored);
+    if (scored) {
+        writer.write(state.leftScore, SCORE_BITS);
+        writer.write(state.rightScore, SCORE_BITS);
+    }
+    return writer.finish();
+}
+
+ReplicationReceiver::ReplicationReceiver()
+{
+    reset();
+}
+
+void ReplicationReceiver::reset()
+{
+    history = StateRing<ReplicatedState, REPLICATION_HISTORY>();
+    newest = 0;
+    any = false;
+}
+
+bool ReplicationReceiver::receive(const unsigned char* data, int length, ReplicatedState* state)
+{
+    BitReader reader(data, length);
+    ReplicatedState decoded;
+    if (!reader.readBit()) {
+        decoded.tick = reader.read(32);
+        decoded.leftBar = (unsigned short)reader.read(POSITION_BITS);
+        decoded.rightBar = (unsigned short)reader.read(POSITION_BITS);
+        decoded.ballX = (unsigned short)reader.read(POSITION_BITS);
+        decoded.ballY = (unsigned short)reader.read(POSITION_BITS);
+        decoded.leftScore = (unsigned char)reader.read(SCORE_BITS);
+        decoded.rightScore = (unsigned char)reader.read(SCORE_BITS);
+    }
+    else {
+        if (!any) {
+            return false;
+        }
+        // the base is the newest tick we could have acknowledged with these low bits
+        unsigned int low = reader.read(8);
+        unsigned int baseTick = newest - ((newest - low) & 0xFF);
+        unsigned int offset = reader.read(5);
+        ReplicatedState base;
+        if (offset == 0 || !history.restore(baseTick, &base)) {
+            return false;
+        }
+        decoded.tick = baseTick + offset;
+        decoded.leftBar = readPosition(reader, base.leftBar);
+        decoded.rightBar = readPosition(reader, base.rightBar);
+        decoded.ballX = readPosition(reader, base.ballX);
+        decoded.ballY = readPosition(reader, base.ballY);
+        decoded.leftScore = base.leftScore;
+        decoded.rightScore = base.rightScore;
+        if (reader.readBit()) {
+            decoded.leftScore = (unsigned char)reader.read(SCORE_BITS);
+            decoded.rightScore = (unsigned char)reader.read(SCORE_BITS);
+        }
+    }
+    if (reader.overflowed()) {
+        return false;
+    }
+
+    history.save(decoded.tick, decoded);
+    if (!any || decoded.tick > newest) {
+        newest = decoded.tick;
+        any = true;
+    }
+    *state = decoded;
+    return true;
+}
@@ -0,0 +1,168 @@
+#include "../Includes/SimThread.hpp"
+#include <chrono>
+#include <random>
+#include <thread>
+// SimThread.cpp holds logic for stepping the simulation at a fixed tick on its own thread
+
+// if we fall further behind than this many ticks (debugger, machine hiccup), we skip ahead instead of fast forwarding
+static const int MAX_CATCHUP_TICKS = 5;
+
+SimThread::SimThread(int tickRate)
+    : alive(false), running(false), resetRequested(false),
+      ballSpeed(1.0f), barSpeed(5.0f), maxScore(10)
+{
+    this->tickRate = tickRate;
+    profiler = nullptr;
+    input = nullptr;
+    recorder = nullptr;
+}
+
+SimThread::~SimThread()
+{
+    stop();
+}
+
+void SimThread::setProfiler(Profiler* profiler)
+{
+    this->profiler = profiler;
+}
+
+void SimThread::start()
+{
+    if (alive.load()) {
+        return;
+    }
+    // make sure there is something to draw before the first tick lands
+    snapshots.writeBuffer() = sim.takeSnapshot();
+    snapshots.publish();
+
+    alive.store(true);
+    thread = std::thread(&SimThread::run, this);
+}
+
+void SimThread::stop()
+{
+    alive.store(false);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SimThread::setInputQueue(InputQueue* input)
+{
+    this->input = input;
+}
+
+void SimThread::setRunning(bool running)
+{
+    this->running.store(running, std::memory_order_relaxed);
+}
+
+void SimThread::requestReset()
+{
+    resetRequested.store(true, std::memory_order_release);
+}
+
+void SimThread::setGameParameters(float ballSpeed, float barSpeed, int maxScore)
+{
+    this->ballSpeed.store(ballSpeed, std::memory_order_relaxed);
+    this->barSpeed.store(barSpeed, std::memory_order_relaxed);
+    this->maxScore.store(maxScore, std::memory_order_relaxed);
+}
+
+void SimThread::setRecorder(ReplayWriter* recorder)
+{
+    this->recorder = recorder;
+}
+
+void SimThread::finishRecording()
+{
+    if (recorder != nullptr) {
+        recorder->result(sim);
+        recorder->finish();
+    }
+}
+
+const PongSnapshot& SimThread::latestSnapshot()
+{
+    return snapshots.read();
+}
+
+void SimThread::run()
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / tickRate));
+    sim.setTimeDelta(1.0f / tickRate);
+
+    clock::time_point nextTick = clock::now();
+    while (alive.load(std::memory_order_relaxed)) {
+        // run every tick that is due, so the simulation keeps a fixed rate even if a sleep overshoots
+        int ticks = 0;
+        while (clock::now() >= nextTick && ticks < MAX_CATCHUP_TICKS) {
+            // a tick due at nextTick simulates the period leading up to it
+            long long tickEnd = std::chrono::duration_cast<std::chrono::nanoseconds>(nextTick.time_since_epoch()).count();
+            long long tickStart = std::chrono::duration_cast<std::chrono::nanoseconds>((nextTick - period).time_since_epoch()).count();
+            tick(tickStart, tickEnd);
+            nextTick += period;
+            ticks++;
+        }
+        if (ticks == MAX_CATCHUP_TICKS && clock::now() >= nextTick) {
+            nextTick = clock::now() + period;
+        }
+        if (ticks > 0) {
+            snapshots.writeBuffer() = sim.takeSnapshot();
+            snapshots.publish();
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void SimThread::tick(long long tickStart, long long tickEnd)
+{
+    float currentBallSpeed = ballSpeed.load(std::memory_order_relaxed);
+    float currentBarSpeed = barSpeed.load(std::memory_order_relaxed);
+    int currentMaxScore = maxScore.load(std::memory_order_relaxed);
+
+    if (recorder != nullptr && !recorder->started()) {
+        // a replay can only reproduce a match it saw set up, so start one from a seed it knows
+        ReplayHeader header = { tickRate, std::random_device()(), currentBallSpeed, currentBarSpeed, currentMaxScore };
+        startReplayMatch(sim, header);
+        recorder->begin(header);
+    }
+
+    sim.setGameParameters(currentBallSpeed, currentBarSpeed, currentMaxScore);
+    // before the reset, which serves the ball with the new ball speed
+    if (recorder != nullptr) {
+        recorder->settings(currentBallSpeed, currentBarSpeed, currentMaxScore);
+    }
+
+    if (resetRequested.exchange(false, std::memory_order_acquire)) {
+        sim.resetGame(true);
+        if (recorder != nullptr) {
+            recorder->reset();
+        }
+    }
+
+    // input is taken off the queue even while paused, so a key released in the menu is not replayed later
+    TickInput leftInput = input != nullptr ? input->collectTick(tickStart, tickEnd, sim.timeDelta) : TickInput::constant(0);
+
+    // once somebody has won we stop stepping until the match is reset
+    if (running.load(std::memory_order_relaxed) && sim.gameStatus() == 0) {
+        if (recorder != nullptr) {
+            recorder->recordTick(leftInput, sim);
+        }
+        if (profiler != nullptr && profiler->measuringSim()) {
+            // time the AI's decision separately from the rest of the step
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            int aiDirection = sim.aiDirection(false);
+            std::chrono::steady_clock::time_point decided = std::chrono::steady_clock::now();
+            sim.step(leftInput, aiDirection);
+            std::chrono::steady_clock::time_point stepped = std::chrono::steady_clock::now();
+            profiler->addSimTime(Profiler::AI, std::chrono::duration_cast<std::chrono::nanoseconds>(decided - start).count());
+            profiler->addSimTime(Profiler::SIM, std::chrono::duration_cast<std::chrono::nanoseconds>(stepped - decided).count());
+        }
+        else {
+            sim.step(leftInput, sim.aiDirection(false));
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "../Includes/StateHash.hpp"
+#if STATE_HASH_SIMD
+#include <emmintrin.h>
+#endif
+// StateHash.cpp holds logic for hashing simulation state with four multiply accumulate lanes
+
+// xored into the words before they are multiplied, so a word of zeros still moves the lanes (digits of pi)
+static const unsigned long long SECRET[STATE_HASH_MAX_WORDS] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL,
+};
+
+static const unsigned long long PRIME_1 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long PRIME_3 = 0x165667B19E3779F9ULL;
+static const unsigned long long PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+
+static unsigned long long rotateLeft(unsigned long long value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// every input bit reaches every output bit (the murmur3 finalizer)
+static unsigned long long avalanche(unsigned long long hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static unsigned long long mergeLanes(const unsigned long long* lanes, int count)
+{
+    unsigned long long hash = (lanes[0] ^ rotateLeft(lanes[1], 17)) * PRIME_1 + (lanes[2] ^ rotateLeft(lanes[3], 41)) * PRIME_2;
+    return avalanche(hash ^ (unsigned long long)count * PRIME_3);
+}
+
+// a word whose keyed half is zero adds nothing to its own lane, but still reaches the one next to it
+static unsigned long long accumulate(unsigned long long word, unsigned long long secret, unsigned long long neighbour)
+{
+    unsigned long long keyed = word ^ secret;
+    return (keyed & 0xFFFFFFFFULL) * (keyed >> 32) + neighbour;
+}
+
+unsigned long long hashWordsScalar(const unsigned long long* words, int count)
+{
+    // four named lanes rather than an array, so they stay in registers
+    unsigned long long lane0 = PRIME_1, lane1 = PRIME_2, lane2 = PRIME_3, lane3 = PRIME_4;
+    for (int i = 0; i < count; i += STATE_HASH_LANES) {
+        lane0 += accumulate(words[i], SECRET[i], words[i + 1]);
+        lane1 += accumulate(words[i + 1], SECRET[i + 1], words[i]);
+        lane2 += accumulate(words[i + 2], SECRET[i + 2], words[i + 3]);
+        lane3 += accumulate(words[i + 3], SECRET[i + 3], words[i + 2]);
+    }
+    unsigned long long lanes[STATE_HASH_LANES] = { lane0, lane1, lane2, lane3 };
+    return mergeLanes(lanes, count);
+}
+
+#if STATE_HASH_SIMD
+// _mm_mul_epu32 multiplies the low halves of both 64 bit lanes, so move the high halves down beside them
+static __m128i accumulatePair(__m128i lanes, const unsigned long long* words, const unsigned long long* secret)
+{
+    __m128i data = _mm_loadu_si128((const __m128i*)words);
+    __m128i keyed = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)secret));
+    __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(3, 3, 1, 1)));
+    __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm_add_epi64(lanes, _mm_add_epi64(product, swapped));
+}
+
+unsigned long long hashWords(const unsigned long long* words, int count)
+{
+    // lanes 0 and 1 in low, 2 and 3 in high, written out like the scalar lanes so neither leaves its register
+    __m128i low = _mm_set_epi64x((long long)PRIME_2, (long long)PRIME_1);
+    __m128i high = _mm_set_epi64x((long long)PRIME_4, (long long)PRIME_3);
+    for (int i = 0; i < count; i += STATE_HASH_LANES) {
+        low = accumulatePair(low, words + i, SECRET + i);
+        high = accumulatePair(high, words + i + 2, SECRET + i + 2);
+    }
+    unsigned long long lanes[STATE_HASH_LANES];
+    _mm_storeu_si128((__m128i*)lanes, low);
+    _mm_storeu_si128((__m128i*)(lanes + 2), high);
+    return mergeLanes(lanes, count);
+}
+#else
+unsigned long long hashWords(const unsigned long long* words, int count)
+{
+    return hashWordsScalar(words, count);
+}
+#endif
+
+unsigned long long chainHash(unsigned long long chain, unsigned long long hash)
+{
+    return avalanche(rotateLeft(chain, 23) * PRIME_1 ^ hash);
+}
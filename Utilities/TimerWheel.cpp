@@ -0,0 +1,150 @@
+#include "../Includes/TimerWheel.hpp"
+// TimerWheel.cpp holds logic for scheduling huge numbers of timers in constant time
+
+static const int NONE = -1;
+
+TimerWheel::TimerWheel(unsigned long long start)
+{
+    freeList = NONE;
+    count = 0;
+    current = start;
+    for (int i = 0; i < LEVELS * SLOTS; i++) {
+        heads[i] = NONE;
+    }
+}
+
+unsigned long long TimerWheel::schedule(unsigned long long when, unsigned long long data)
+{
+    int index;
+    if (freeList != NONE) {
+        index = freeList;
+        freeList = timers[index].next;
+    }
+    else {
+        index = (int)timers.size();
+        Timer timer;
+        timer.generation = 0;
+        timers.push_back(timer);
+    }
+    Timer& timer = timers[index];
+    timer.when = when;
+    timer.data = data;
+    insert(index);
+    count++;
+    return ((unsigned long long)timer.generation << 32) | (unsigned int)index;
+}
+
+bool TimerWheel::cancel(unsigned long long handle)
+{
+    int index = (int)(handle & 0xFFFFFFFFu);
+    if (index < 0 || index >= (int)timers.size()) {
+        return false;
+    }
+    Timer& timer = timers[index];
+    if (timer.slot == NONE || timer.generation != (unsigned int)(handle >> 32)) {
+        return false;
+    }
+    unlink(index);
+    timer.slot = NONE;
+    timer.generation++;
+    timer.next = freeList;
+    freeList = index;
+    count--;
+    return true;
+}
+
+void TimerWheel::advance(unsigned long long now, std::vector<ExpiredTimer>& fired)
+{
+    while (current <= now) {
+        int slot = (int)(current & (SLOTS - 1));
+        // level 0 wrapped around: bring the next stretch down from each level whose own slot came up
+        if (slot == 0) {
+            for (int level = 1; level < LEVELS; level++) {
+                cascade(level);
+                if (((current >> (level * SLOT_BITS)) & (SLOTS - 1)) != 0) {
+                    break;
+                }
+            }
+        }
+
+        // everything in a level 0 slot is due now
+        int index = heads[slot];
+        heads[slot] = NONE;
+        while (index != NONE) {
+            Timer& timer = timers[index];
+            int next = timer.next;
+            ExpiredTimer expired;
+            expired.when = timer.when;
+            expired.data = timer.data;
+            fired.push_back(expired);
+            timer.slot = NONE;
+            timer.generation++;
+            timer.next = freeList;
+            freeList = index;
+            count--;
+            index = next;
+        }
+        current++;
+    }
+}
+
+unsigned long long TimerWheel::time() const
+{
+    return current;
+}
+
+int TimerWheel::pending() const
+{
+    return count;
+}
+
+void TimerWheel::insert(int index)
+{
+    Timer& timer = timers[index];
+    // overdue timers go off on the next slot we look at
+    unsigned long long when = timer.when > current ? timer.when : current;
+    unsigned long long delta = when - current;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1ULL << ((level + 1) * SLOT_BITS))) {
+        level++;
+    }
+    // past the far end of the wheel: park in the last slot it reaches, and try again when that is cascaded
+    if (delta >= (1ULL << (LEVELS * SLOT_BITS))) {
+        when = current + (1ULL << (LEVELS * SLOT_BITS)) - 1;
+    }
+    int slot = level * SLOTS + (int)((when >> (level * SLOT_BITS)) & (SLOTS - 1));
+
+    timer.slot = slot;
+    timer.prev = NONE;
+    timer.next = heads[slot];
+    if (heads[slot] != NONE) {
+        timers[heads[slot]].prev = index;
+    }
+    heads[slot] = index;
+}
+
+void TimerWheel::unlink(int index)
+{
+    Timer& timer = timers[index];
+    if (timer.prev != NONE) {
+        timers[timer.prev].next = timer.next;
+    }
+    else {
+        heads[timer.slot] = timer.next;
+    }
+    if (timer.next != NONE) {
+        timers[timer.next].prev = timer.prev;
+    }
+}
+
+void TimerWheel::cascade(int level)
+{
+    int slot = level * SLOTS + (int)((current >> (level * SLOT_BITS)) & (SLOTS - 1));
+    int index = heads[slot];
+    heads[slot] = NONE;
+    while (index != NONE) {
+        int next = timers[index].next;
+        insert(index);
+        index = next;
+    }
+}
@@ -0,0 +1,358 @@
+#include "../Includes/UdpSocket.hpp"
+#include "../Includes/SharedPacket.hpp"
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef int socklen_t;
+static const long long INVALID_HANDLE = (long long)INVALID_SOCKET;
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+static const long long INVALID_HANDLE = -1;
+#endif
+// UdpSocket.cpp holds logic for sending and receiving datagrams without blocking
+
+bool NetAddress::resolve(const char* host, unsigned short port, NetAddress* address)
+{
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr) {
+        std::cout << "FAILED::RESOLVING::HOST: " << host << std::endl;
+        return false;
+    }
+    const sockaddr_in* resolved = (const sockaddr_in*)result->ai_addr;
+    address->ip = ntohl(resolved->sin_addr.s_addr);
+    address->port = port;
+    freeaddrinfo(result);
+    return true;
+}
+
+UdpSocket::UdpSocket()
+{
+    handle = INVALID_HANDLE;
+    port = 0;
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+bool UdpSocket::startup()
+{
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        std::cout << "FAILED::STARTING::WINSOCK" << std::endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+void UdpSocket::shutdown()
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool UdpSocket::open(unsigned short port, bool sharePort)
+{
+    close();
+#ifdef _WIN32
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        std::cout << "FAILED::CREATING::SOCKET" << std::endl;
+        return false;
+    }
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) {
+        std::cout << "FAILED::CREATING::SOCKET" << std::endl;
+        return false;
+    }
+#endif
+    handle = (long long)s;
+
+#ifdef SO_REUSEPORT
+    if (sharePort) {
+        int enable = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+    }
+#else
+    (void)sharePort;
+#endif
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (bind(s, (const sockaddr*)&local, sizeof(local)) != 0) {
+        std::cout << "FAILED::BINDING::SOCKET::PORT: " << port << std::endl;
+        close();
+        return false;
+    }
+
+    // never block, the caller polls
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    // find out which port we actually got (port 0 asks for any free one)
+    sockaddr_in bound;
+    socklen_t length = sizeof(bound);
+    getsockname(s, (sockaddr*)&bound, &length);
+    this->port = ntohs(bound.sin_port);
+    return true;
+}
+
+void UdpSocket::close()
+{
+    if (handle == INVALID_HANDLE) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket((SOCKET)handle);
+#else
+    ::close((int)handle);
+#endif
+    handle = INVALID_HANDLE;
+    port = 0;
+}
+
+bool UdpSocket::isOpen() const
+{
+    return handle != INVALID_HANDLE;
+}
+
+unsigned short UdpSocket::localPort() const
+{
+    return port;
+}
+
+bool UdpSocket::send(const NetAddress& to, const void* data, int length)
+{
+    if (handle == INVALID_HANDLE) {
+        return false;
+    }
+    sockaddr_in remote;
+    memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_addr.s_addr = htonl(to.ip);
+    remote.sin_port = htons(to.port);
+#ifdef _WIN32
+    int sent = sendto((SOCKET)handle, (const char*)data, length, 0, (const sockaddr*)&remote, sizeof(remote));
+#else
+    int sent = (int)sendto((int)handle, data, length, 0, (const sockaddr*)&remote, sizeof(remote));
+#endif
+    return sent == length;
+}
+
+long long UdpSocket::nativeHandle() const
+{
+    return handle;
+}
+
+int UdpSocket::receive(NetAddress* from, void* data, int capacity)
+{
+    if (handle == INVALID_HANDLE) {
+        return -1;
+    }
+    sockaddr_in remote;
+    socklen_t length = sizeof(remote);
+#ifdef _WIN32
+    int received = recvfrom((SOCKET)handle, (char*)data, capacity, 0, (sockaddr*)&remote, &length);
+#else
+    int received = (int)recvfrom((int)handle, data, capacity, 0, (sockaddr*)&remote, &length);
+#endif
+    // would block, or an error such as a port unreachable reply on windows: either way there is nothing to read
+    if (received < 0) {
+        return -1;
+    }
+    if (from != nullptr) {
+        from->ip = ntohl(remote.sin_addr.s_addr);
+        from->port = ntohs(remote.sin_port);
+    }
+    return received;
+}
+
+#ifdef __linux__
+struct DatagramBatch::Headers {
+    mmsghdr in[SIZE];
+    iovec inVectors[SIZE];
+    sockaddr_in inAddresses[SIZE];
+    mmsghdr out[SIZE];
+    iovec outVectors[SIZE];
+    sockaddr_in outAddresses[SIZE];
+};
+#else
+struct DatagramBatch::Headers {
+};
+#endif
+
+DatagramBatch::DatagramBatch()
+{
+    headers = new Headers();
+    inData = new unsigned char[SIZE * UdpSocket::MAX_PACKET];
+    outData = new unsigned char[SIZE * UdpSocket::MAX_PACKET];
+    outCount = 0;
+    memset(inLengths, 0, sizeof(inLengths));
+    memset(outLengths, 0, sizeof(outLengths));
+    memset(outShared, 0, sizeof(outShared));
+#ifdef __linux__
+    // the headers point at the same buffers unless a shared packet is queued, only lengths and addresses change per call
+    memset(headers, 0, sizeof(Headers));
+    for (int i = 0; i < SIZE; i++) {
+        headers->inVectors[i].iov_base = inData + i * UdpSocket::MAX_PACKET;
+        headers->inVectors[i].iov_len = UdpSocket::MAX_PACKET;
+        headers->in[i].msg_hdr.msg_iov = &headers->inVectors[i];
+        headers->in[i].msg_hdr.msg_iovlen = 1;
+        headers->in[i].msg_hdr.msg_name = &headers->inAddresses[i];
+        headers->out[i].msg_hdr.msg_iov = &headers->outVectors[i];
+        headers->out[i].msg_hdr.msg_iovlen = 1;
+        headers->out[i].msg_hdr.msg_name = &headers->outAddresses[i];
+        headers->outVectors[i].iov_base = outData + i * UdpSocket::MAX_PACKET;
+    }
+#endif
+}
+
+DatagramBatch::~DatagramBatch()
+{
+    for (int i = 0; i < outCount; i++) {
+        if (outShared[i] != nullptr) {
+            outShared[i]->release();
+        }
+    }
+    delete headers;
+    delete[] inData;
+    delete[] outData;
+}
+
+int DatagramBatch::receive(UdpSocket& socket)
+{
+    if (!socket.isOpen()) {
+        return 0;
+    }
+#ifdef __linux__
+    for (int i = 0; i < SIZE; i++) {
+        headers->in[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+    int count = recvmmsg((int)socket.nativeHandle(), headers->in, SIZE, MSG_DONTWAIT, nullptr);
+    if (count <= 0) {
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        inLengths[i] = (int)headers->in[i].msg_len;
+        inFrom[i].ip = ntohl(headers->inAddresses[i].sin_addr.s_addr);
+        inFrom[i].port = ntohs(headers->inAddresses[i].sin_port);
+    }
+    return count;
+#else
+    int count = 0;
+    while (count < SIZE) {
+        int length = socket.receive(&inFrom[count], inData + count * UdpSocket::MAX_PACKET, UdpSocket::MAX_PACKET);
+        if (length < 0) {
+            break;
+        }
+        inLengths[count++] = length;
+    }
+    return count;
+#endif
+}
+
+const unsigned char* DatagramBatch::data(int i) const
+{
+    return inData + i * UdpSocket::MAX_PACKET;
+}
+
+int DatagramBatch::length(int i) const
+{
+    return inLengths[i];
+}
+
+const NetAddress& DatagramBatch::from(int i) const
+{
+    return inFrom[i];
+}
+
+void DatagramBatch::queue(UdpSocket& socket, const NetAddress& to, const unsigned char* data, int length)
+{
+    if (outCount == SIZE) {
+        flush(socket);
+    }
+    memcpy(outData + outCount * UdpSocket::MAX_PACKET, data, length);
+    outLengths[outCount] = length;
+    outTo[outCount] = to;
+    outShared[outCount] = nullptr;
+    outCount++;
+}
+
+void DatagramBatch::queueShared(UdpSocket& socket, const NetAddress& to, SharedPacket* packet)
+{
+    if (outCount == SIZE) {
+        flush(socket);
+    }
+    packet->retain();
+    outLengths[outCount] = packet->length();
+    outTo[outCount] = to;
+    outShared[outCount] = packet;
+    outCount++;
+}
+
+void DatagramBatch::flush(UdpSocket& socket)
+{
+    if (outCount == 0) {
+        return;
+    }
+#ifdef __linux__
+    for (int i = 0; i < outCount; i++) {
+        sockaddr_in& address = headers->outAddresses[i];
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(outTo[i].ip);
+        address.sin_port = htons(outTo[i].port);
+        headers->out[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        headers->outVectors[i].iov_base = outShared[i] != nullptr ? (void*)outShared[i]->data() : (void*)(outData + i * UdpSocket::MAX_PACKET);
+        headers->outVectors[i].iov_len = outLengths[i];
+    }
+    // sendmmsg can stop partway, carry on from there until it sends nothing more
+    int sent = 0;
+    while (sent < outCount) {
+        int result = sendmmsg((int)socket.nativeHandle(), headers->out + sent, outCount - sent, MSG_DONTWAIT);
+        if (result <= 0) {
+            break;
+        }
+        sent += result;
+    }
+#else
+    for (int i = 0; i < outCount; i++) {
+        socket.send(outTo[i], outShared[i] != nullptr ? outShared[i]->data() : outData + i * UdpSocket::MAX_PACKET, outLengths[i]);
+    }
+#endif
+    for (int i = 0; i < outCount; i++) {
+        if (outShared[i] != nullptr) {
+            outShared[i]->release();
+            outShared[i] = nullptr;
+        }
+    }
+    outCount = 0;
+}
+
+int DatagramBatch::queued() const
+{
+    return outCount;
+}
@@ -0,0 +1,188 @@
+#include "../Includes/VideoExport.hpp"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <iostream>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+// VideoExport.cpp holds logic for rendering matches offscreen and writing them out as raw video frames
+
+VideoExporter::VideoExporter(GpuResourceManager* resources, int width, int height, int fps, Format format)
+{
+    this->resources = resources;
+    this->width = width;
+    this->height = height;
+    this->fps = fps;
+    this->format = format;
+    framesWritten = 0;
+    framesQueued = 0;
+    out = nullptr;
+}
+
+bool VideoExporter::open(const char* path)
+{
+    if (path[0] == '-' && path[1] == '\0') {
+        out = stdout;
+#ifdef _WIN32
+        // stdout is opened in text mode on windows, which would mangle the frames
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    }
+    else {
+        out = fopen(path, "wb");
+    }
+    if (out == nullptr) {
+        std::cerr << "FAILED::OPENING::EXPORT::FILE: " << path << std::endl;
+        return false;
+    }
+
+    // offscreen render target at the export resolution (independent of the window size)
+    fbo = OwnedFramebuffer(resources, resources->createFramebuffer());
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo.name());
+    colorBuffer = OwnedRenderbuffer(resources, resources->createRenderbuffer(GL_RGBA8, width, height, 4));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer.name());
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "FAILED::EXPORT::FRAMEBUFFER::INCOMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // stream read since we read each frame back exactly once
+    for (int i = 0; i < 2; i++) {
+        pbos[i] = OwnedBuffer(resources, resources->createBuffer(GL_PIXEL_PACK_BUFFER, (size_t)width * height * 4, nullptr, GL_STREAM_READ));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    frame.resize((size_t)width * height * 3);
+
+    if (format == Y4M) {
+        fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+    }
+    return true;
+}
+
+void VideoExporter::beginFrame()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo.name());
+    glViewport(0, 0, width, height);
+    // same white background as the game window
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void VideoExporter::endFrame()
+{
+    // queue the copy of this frame into one pixel buffer, glReadPixels returns without waiting since a buffer is bound
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.name());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[framesQueued % 2].name());
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    framesQueued++;
+
+    // the other buffer holds the previous frame, which has had a whole frame of time to arrive
+    if (framesQueued > 1) {
+        writePending(pbos[framesQueued % 2].name());
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void VideoExporter::writePending(unsigned int pbo)
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)width * height * 4, GL_MAP_READ_BIT);
+    if (pixels == nullptr) {
+        std::cerr << "FAILED::EXPORT::MAPPING::PIXEL::BUFFER" << std::endl;
+        return;
+    }
+
+    size_t planeSize = (size_t)width * height;
+    unsigned char* yPlane = frame.data();
+    unsigned char* uPlane = yPlane + planeSize;
+    unsigned char* vPlane = uPlane + planeSize;
+    for (int row = 0; row < height; row++) {
+        // opengl rows go bottom to top, video rows go top to bottom
+        const unsigned char* src = pixels + (size_t)(height - 1 - row) * width * 4;
+        size_t dst = (size_t)row * width;
+        for (int col = 0; col < width; col++, src += 4) {
+            int r = src[0], g = src[1], b = src[2];
+            if (format == Y4M) {
+                // bt.601 studio range in fixed point
+                yPlane[dst + col] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                uPlane[dst + col] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                vPlane[dst + col] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+            else {
+                unsigned char* rgb = frame.data() + (dst + col) * 3;
+                rgb[0] = (unsigned char)r;
+                rgb[1] = (unsigned char)g;
+                rgb[2] = (unsigned char)b;
+            }
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+    if (format == Y4M) {
+        fputs("FRAME\n", out);
+    }
+    fwrite(frame.data(), 1, frame.size(), out);
+    framesWritten++;
+}
+
+void VideoExporter::close()
+{
+    // the most recent frame is still sitting in its pixel buffer
+    if (framesQueued > 0) {
+        writePending(pbos[(framesQueued - 1) % 2].name());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    framesQueued = 0;
+
+    pbos[0].reset();
+    pbos[1].reset();
+    colorBuffer.reset();
+    fbo.reset();
+
+    if (out != nullptr) {
+        fflush(out);
+        if (out != stdout) {
+            fclose(out);
+        }
+        out = nullptr;
+    }
+}
+
+int exportMatch(PongState* pong, VideoExporter* exporter, const char* path, float maxSeconds)
+{
+    if (!exporter->open(path)) {
+        exporter->close();
+        return -1;
+    }
+
+    // fixed timestep so the exported match plays back at the right speed no matter how fast we render
+    PongSim sim;
+    sim.resetGame(true);
+    sim.setTimeDelta(1.0f / exporter->fps);
+    long long maxFrames = (long long)(maxSeconds * exporter->fps);
+
+    double start = glfwGetTime();
+    for (long long i = 0; i < maxFrames && sim.gameStatus() == 0; i++) {
+        sim.step(sim.aiDirection(true));
+
+        exporter->beginFrame();
+        pong->draw(sim.takeSnapshot());
+        exporter->endFrame();
+    }
+    exporter->close();
+    double elapsed = glfwGetTime() - start;
+
+    // report on stderr since stdout might be the video stream
+    double matchSeconds = (double)exporter->framesWritten / exporter->fps;
+    fprintf(stderr, "exported %lld frames (%.1fs of match) in %.2fs, %.1fx real time\n",
+        exporter->framesWritten, matchSeconds, elapsed, elapsed > 0 ? matchSeconds / elapsed : 0.0);
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include "../Includes/glHelpers.hpp"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "../Includes/stb_image.h"
+#include <iostream>
 
 /*
     Function to adjust the window of opengl as a callback
@@ -10,3 +12,46 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height){
     glViewport(0, 0, width, height);
 }
 
+
+/*
+    Function to load an rgb image into a mipmapped 2d texture
+*/
+unsigned int loadTexture(const char* path, size_t* bytes){
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // set the texture wrapping/filtering options (on the currently bound texture object)
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // loading our texture
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, nrChannels;
+    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
+
+    if (data == nullptr) {
+        // we failed to load the texture
+        std::cout << "FAILED::LOADING::TEXTURE!" << std::endl;
+        if (bytes != nullptr) {
+            *bytes = 0;
+        }
+        // an empty texture would look like a working one to the caller
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+
+    // generating texture and mipmap based on loaded image
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    if (bytes != nullptr) {
+        // the mip chain adds about a third on top of the base level
+        *bytes = (size_t)width * height * 3 * 4 / 3;
+    }
+
+    // we can free the data, we have the mipmaps generated
+    stbi_image_free(data);
+    return texture;
+}
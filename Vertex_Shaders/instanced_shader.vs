@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec2 aPos;
+// per instance: top left corner and size of the quad in normalized coordinates
+layout (location = 1) in vec4 aRect;
+// per instance: texture coordinates of the bottom left corner and size, size of zero means untextured
+layout (location = 2) in vec4 aTexRect;
+layout (location = 3) in vec3 aColor;
+
+out vec3 ourColor;
+out vec2 TexCoord;
+out float textured;
+
+void main()
+{
+    // aPos is a unit quad with its top left corner at the origin, hanging down to y = -1
+    gl_Position = vec4(aRect.xy + aPos * aRect.zw, 0.0, 1.0);
+    ourColor = aColor;
+    TexCoord = aTexRect.xy + vec2(aPos.x, aPos.y + 1.0) * aTexRect.zw;
+    textured = aTexRect.z > 0.0 ? 1.0 : 0.0;
+}
@@ -0,0 +1,103 @@
+// holds logic for the UI of the multiplayer connection window and the network match status
+/*
+	Before a match we need
+	1) whether we host or join (the host plays the left bar)
+	2) the address to join and the ports to use
+	3) optional extra delay, jitter, loss, reordering, duplicates and a bandwidth cap on our packets, to try the game on a bad connection
+	4) for the host, rollback or lockstep with some input delay
+	During the match we show how the connection is doing, how much rolling back it costs us and whether both ends agree
+*/
+
+#include "imgui.h"
+#include "../Includes/MultiplayerMenu.hpp"
+
+// builds the UI view for setting up a network match
+int buildMultiplayerMenu(MultiplayerSettings* settings) {
+	int choice = 0;
+	ImGui::Begin("Multi-Player");
+
+	ImGui::RadioButton("host", &settings->role, 0);
+	ImGui::SameLine();
+	ImGui::RadioButton("join", &settings->role, 1);
+
+	ImGui::InputInt("local port:", &settings->localPort);
+	if (settings->role == 1) {
+		ImGui::InputText("host address:", settings->host, sizeof(settings->host));
+		ImGui::InputInt("host port:", &settings->remotePort);
+	}
+	else {
+		ImGui::Checkbox("lockstep", &settings->lockstep);
+		if (settings->lockstep) {
+			ImGui::SliderInt("starting input delay (ticks):", &settings->inputDelay, 0, NetSession::MAX_INPUT_DELAY);
+		}
+	}
+
+	ImGui::Text("simulated network (our packets only):");
+	LinkConditions& link = settings->link;
+	ImGui::SliderInt("delay ms:", &link.delayMs, 0, 250);
+	ImGui::SliderInt("jitter ms:", &link.jitterMs, 0, 100);
+	ImGui::RadioButton("uniform", &link.delayShape, DELAY_UNIFORM);
+	ImGui::SameLine();
+	ImGui::RadioButton("normal", &link.delayShape, DELAY_NORMAL);
+	ImGui::SameLine();
+	ImGui::RadioButton("spiky", &link.delayShape, DELAY_PARETO);
+	ImGui::SliderFloat("loss %:", &link.lossPercent, 0.0f, 50.0f, "%.1f");
+	ImGui::SliderFloat("loss burst (packets):", &link.lossBurst, 1.0f, 20.0f, "%.1f");
+	ImGui::SliderFloat("reorder %:", &link.reorderPercent, 0.0f, 50.0f, "%.1f");
+	ImGui::SliderFloat("duplicate %:", &link.duplicatePercent, 0.0f, 50.0f, "%.1f");
+	ImGui::SliderInt("bandwidth kbit/s (0 no cap):", &link.bandwidthKbps, 0, 2000);
+	int seed = (int)link.seed;
+	if (ImGui::InputInt("network seed:", &seed)) {
+		link.seed = (unsigned int)seed;
+	}
+
+	if (ImGui::Button(settings->role == 0 ? "Host" : "Join")) {
+		choice = 1;
+	}
+	else if (ImGui::Button("Back")) {
+		choice = -1;
+	}
+
+	ImGui::End();
+	return choice;
+}
+
+// builds the UI view for the connection while a network match is running
+bool buildNetStatus(const NetStats& stats) {
+	ImGui::Begin("Connection");
+
+	switch (stats.state) {
+	case NetSession::CONNECTING:
+		ImGui::Text("waiting for the other player...");
+		break;
+	case NetSession::PLAYING:
+		if (stats.lockstep) {
+			ImGui::Text("lockstep, input delay %d ticks (other player asks for %d)", stats.inputDelay, stats.wantedDelay);
+		}
+		ImGui::Text("round trip: %.1f ms", stats.rttMs);
+		ImGui::Text("their packets: %.1f ms one way, %.1f ms jitter, %.1f%% lost", stats.transitMs, stats.jitterMs, stats.lossPercent);
+		ImGui::Text("our simulated network: %u sent, %u lost, %u over the cap, %u reordered, %u duplicated", stats.link.sent,
+			stats.link.lost, stats.link.queueDrops, stats.link.reordered, stats.link.duplicated);
+		ImGui::Text("their clock: %+.3f ms, drifting %+.1f ppm, we are %+.2f ticks ahead", stats.clockOffsetMs, stats.driftPpm, stats.tickAdvantage);
+		ImGui::Text("tick %u, remote input up to %u", stats.tick, stats.confirmedTick);
+		ImGui::Text("rollbacks: %u (last %u ticks in %.3f ms)", stats.rollbacks, stats.lastResimTicks, stats.lastResimMs);
+		ImGui::Text("longest rollback: %u ticks, slowest %.3f ms", stats.maxResimTicks, stats.maxResimMs);
+		ImGui::Text("stalled ticks: %u", stats.stalls);
+		ImGui::Text("packets sent %u, received %u", stats.packetsSent, stats.packetsReceived);
+		ImGui::Text("every tick agreed up to tick %u (%u hash chains matched)", stats.agreedTick, stats.hashesChecked - stats.desyncs);
+		if (stats.desyncs > 0) {
+			ImGui::Text("DESYNC: somewhere in ticks %u to %u (%u chains differed)", stats.agreedTick + 1, stats.firstDesyncTick, stats.desyncs);
+		}
+		break;
+	case NetSession::DISCONNECTED:
+		ImGui::Text("the other player has left");
+		break;
+	default:
+		ImGui::Text("could not connect");
+		break;
+	}
+
+	bool leave = ImGui::Button("Leave");
+	ImGui::End();
+	return leave;
+}
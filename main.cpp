@@ -20,6 +20,28 @@
 #include "Includes/MainMenu.hpp"
 // including our pong logic
 #include "Includes/Pong.hpp"
+// offscreen match to video export
+#include "Includes/VideoExport.hpp"
+// simulation thread that publishes snapshots for us to draw
+#include "Includes/SimThread.hpp"
+// performance overlay
+#include "Includes/Profiler.hpp"
+// grid of matches for spectating
+#include "Includes/MultiMatchRenderer.hpp"
+// owner of every opengl object we create
+#include "Includes/GpuResources.hpp"
+// timestamped key events for the simulation
+#include "Includes/InputQueue.hpp"
+// input to photon latency measurement
+#include "Includes/LatencyHarness.hpp"
+// two player matches over the network
+#include "Includes/NetSession.hpp"
+#include "Includes/MultiplayerMenu.hpp"
+// recording single player matches
+#include "Includes/Replay.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
 
 glm::mat4 create_transform() {
    // identity matrix (no translation)
@@ -34,8 +56,122 @@ glm::mat4 create_transform() {
     return trans;
 }
 
-int main()
+/*
+    Command line options for running something other than the game
+    --export <file>  write a match to file as video instead of playing ("-" streams to stdout)
+    --seconds <n>    maximum length of match time to export (default 60)
+    --fps <n>        frames per second of the export (default 60)
+    --size <w>x<h>   resolution of the export (default 800x600)
+    --rgb            write raw rgb24 frames instead of y4m
+    --grid <n>       spectate an n by n grid of AI matches
+    --latency <n>    measure input to photon latency with n key presses per configuration (results in latency.csv)
+    --record <file>  play as usual, recording the single player match's input to a replay file
+*/
+struct LaunchOptions {
+    const char* path = nullptr;
+    float seconds = 60.0f;
+    int fps = 60;
+    int width = 800;
+    int height = 600;
+    VideoExporter::Format format = VideoExporter::Y4M;
+    int gridSize = 0;
+    int latencyTrials = 0;
+    const char* replayPath = nullptr;
+};
+
+LaunchOptions parse_launch_options(int argc, char** argv) {
+    LaunchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--export") && i + 1 < argc) {
+            options.path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            options.seconds = (float)atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--fps") && i + 1 < argc) {
+            options.fps = std::max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+        }
+        else if (!strcmp(argv[i], "--rgb")) {
+            options.format = VideoExporter::RAW_RGB;
+        }
+        else if (!strcmp(argv[i], "--grid") && i + 1 < argc) {
+            options.gridSize = std::max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--latency") && i + 1 < argc) {
+            options.latencyTrials = std::max(1, atoi(argv[++i]));
+        }
+        else if (!strcmp(argv[i], "--record") && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        }
+    }
+    return options;
+}
+
+/*
+    Spectator view: runs gridSize * gridSize AI matches and draws them all at once until the window is closed
+    Finished matches restart straight away
+*/
+int run_grid(GLFWwindow* window, GpuResourceManager* resources, int gridSize) {
+    int count = gridSize * gridSize;
+    std::vector<PongSim> matches(count);
+    std::vector<PongSnapshot> snapshots(count);
+    for (int i = 0; i < count; i++) {
+        matches[i].seed(i + 1);
+        matches[i].setGameParameters(1.0f, 5.0f, 10);
+        matches[i].resetGame(true);
+    }
+    MultiMatchRenderer renderer(resources, count);
+
+    double lastTime = glfwGetTime();
+    double fpsTime = lastTime;
+    int frames = 0;
+    while (!glfwWindowShouldClose(window)) {
+        glfwPollEvents();
+
+        // step with the real frame time, capped so a stall does not throw the balls through the bars
+        double currTime = glfwGetTime();
+        float timeDelta = (float)std::min(currTime - lastTime, 1.0 / 30.0);
+        lastTime = currTime;
+        for (int i = 0; i < count; i++) {
+            PongSim& match = matches[i];
+            match.setTimeDelta(timeDelta);
+            match.step(match.aiDirection(true));
+            if (match.gameStatus() != 0) {
+                match.resetGame(true);
+            }
+            snapshots[i] = match.takeSnapshot();
+        }
+
+        int display_w, display_h;
+        glfwGetFramebufferSize(window, &display_w, &display_h);
+        glViewport(0, 0, display_w, display_h);
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer.draw(snapshots.data(), count, gridSize);
+        glfwSwapBuffers(window);
+        resources->endFrame();
+
+        // frame rate in the title bar, once a second
+        frames++;
+        if (currTime - fpsTime >= 1.0) {
+            char title[64];
+            snprintf(title, sizeof(title), "Pong - %d matches - %.1f FPS", count, frames / (currTime - fpsTime));
+            glfwSetWindowTitle(window, title);
+            frames = 0;
+            fpsTime = currTime;
+        }
+    }
+    renderer.destroy();
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
+    LaunchOptions launchOptions = parse_launch_options(argc, argv);
+
     if (!glfwInit()){
         printf("failed to initialize glfw context!\n");
     }
@@ -45,6 +181,10 @@ int main()
     glfwWindowHint(GLFW_OPENGL_PROFILE,GLFW_OPENGL_CORE_PROFILE);
     // for mac osx glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
+    if (launchOptions.path != nullptr) {
+        // exporting renders offscreen, so we only need the window for its opengl context
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
     
     GLFWwindow* window = glfwCreateWindow(800, 600, "Pong", NULL, NULL);
     if (window == NULL){
@@ -59,9 +199,54 @@ int main()
         return -1;
     }    
 
+    // every opengl object is created through this, so at exit we can check that nothing was leaked
+    GpuResourceManager* resources = new GpuResourceManager();
+
+    if (launchOptions.path != nullptr) {
+        // no vsync, we want to export as fast as the gpu allows
+        glfwSwapInterval(0);
+        PongState* exportPong = new PongState(resources);
+        VideoExporter exporter(resources, launchOptions.width, launchOptions.height, launchOptions.fps, launchOptions.format);
+        int result = exportMatch(exportPong, &exporter, launchOptions.path, launchOptions.seconds);
+        exportPong->destroyState();
+        delete exportPong;
+        resources->flush();
+        resources->reportLeaks();
+        delete resources;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return result;
+    }
+
     glViewport(0, 0, 800, 600);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
+    if (launchOptions.latencyTrials > 0) {
+        int result = runLatencySweep(window, resources, launchOptions.latencyTrials, "latency.csv");
+        resources->flush();
+        resources->reportLeaks();
+        delete resources;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return result;
+    }
+
+    if (launchOptions.gridSize > 0) {
+        int result = run_grid(window, resources, launchOptions.gridSize);
+        resources->flush();
+        resources->reportLeaks();
+        delete resources;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return result;
+    }
+
+    // the player's key presses go through the key callback into this queue as they happen, instead of being polled once a frame
+    // the callback is set before ImGui installs its own, so ImGui passes the events on to it
+    InputQueue* inputQueue = new InputQueue();
+    glfwSetWindowUserPointer(window, inputQueue);
+    glfwSetKeyCallback(window, input_key_callback);
+
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -97,31 +282,69 @@ int main()
     ImVec4 clear_color = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
 
     // setup our pong state
-    PongState* pong = new PongState();
-
-    // passing pointer to our pong state to the glfw window (so we can reference it in callbacks)
-    //glfwSetWindowUserPointer(window, pong);
+    PongState* pong = new PongState(resources);
+
+    // performance overlay, toggled with F3
+    Profiler* profiler = new Profiler();
+    profiler->initQueries();
+    profiler->setResources(resources);
+    bool profilerKeyDown = false;
+
+    // the match is stepped on its own thread at a fixed tick, we only draw the snapshots it publishes
+    SimThread* simThread = new SimThread(120);
+    simThread->setProfiler(profiler);
+    simThread->setInputQueue(inputQueue);
+    ReplayWriter* recorder = nullptr;
+    if (launchOptions.replayPath != nullptr) {
+        recorder = new ReplayWriter();
+        if (recorder->open(launchOptions.replayPath)) {
+            simThread->setRecorder(recorder);
+        }
+        else {
+            std::cout << "Failed to create replay file " << launchOptions.replayPath << std::endl;
+            delete recorder;
+            recorder = nullptr;
+        }
+    }
+    simThread->start();
 
-    // setting callback needed to handle user input to move the left pong paddle
-    //glfwSetKeyCallback(window, bar_outer_callback_handler);
+    // whether we have reset the simulation for the match we are currently showing
+    bool matchStarted = false;
+    // set from leaving a finished match until the sim thread has taken the reset, the snapshot still shows the old result until then
+    bool resetPending = false;
 
-    // keeping track of time
-    double time = -1;
+    // network match, only while one is being set up or played
+    UdpSocket::startup();
+    NetSession* netSession = nullptr;
+    MultiplayerSettings netSettings = { 0, "127.0.0.1", 27015, 27015, { 0, 0, 0.0f, DELAY_UNIFORM, 1.0f, 0.0f, 0.0f, 0, 0 }, false, 3 };
 
     //render loop
     while(!glfwWindowShouldClose(window)){
         
-        
+        profiler->beginFrame();
+
+        profiler->beginPhase(Profiler::EVENTS);
+        // key events land in the input queue from inside here
         glfwPollEvents();    
 
+        // F3 shows or hides the performance overlay
+        bool f3Down = glfwGetKey(window, GLFW_KEY_F3) != GLFW_RELEASE;
+        if (f3Down && !profilerKeyDown) {
+            profiler->visible = !profiler->visible;
+        }
+        profilerKeyDown = f3Down;
+        profiler->endPhase(Profiler::EVENTS);
         
 
         // Start the Dear ImGui frame
+        profiler->beginPhase(Profiler::IMGUI);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         buildMenu(&gameState, &ballSpeed, &barSpeed, &maxScore);
+        profiler->drawOverlay();
+        profiler->endPhase(Profiler::IMGUI);
         /*
         buildMenu();
 
@@ -167,67 +390,157 @@ int main()
         glViewport(0, 0, display_w, display_h);
         glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
-        if (gameState != 0) {
+
+        // the match only advances while we are in the game
+        simThread->setRunning(gameState == 1);
+        const PongSnapshot& snapshot = simThread->latestSnapshot();
+        if (gameState == 1) {
             // then we are in the game
             
 
             // set the values for the gameplay
-            pong->setGameParameters(ballSpeed, barSpeed, maxScore);
+            simThread->setGameParameters(ballSpeed, barSpeed, maxScore);
             //printf("ball speed: %f ---- barSpeed: %f ---- maxScore: %d \n", ballSpeed, barSpeed, maxScore);
 
             
 
 			if (gameStatus == 0) {
-				// handling time based update of state
-				double curr_time = glfwGetTime();
-				if (time == -1) {
-                    pong->resetGame(true);
-					time = curr_time-0.00001;
+				if (!matchStarted) {
+                    simThread->requestReset();
+					matchStarted = true;
+					resetPending = true;
 				}
-				pong->setTimeDelta(curr_time - time);
-				time = curr_time;
-				pong->draw(window);
+				profiler->beginPhase(Profiler::DRAW);
+				pong->draw(snapshot);
+				profiler->setRenderCounts(pong->drawCalls, pong->stateChanges);
+				profiler->endPhase(Profiler::DRAW);
 			}
 			else if (gameStatus == 1) {
-                time = -1;
+                matchStarted = false;
 				ImGui::Begin("You have Won! :)");
 				if (ImGui::Button("Replay")) {
-				    pong->resetGame(true);
+				    // the next frame starts the match again, which resets it
+				    gameStatus = 0;
+				    resetPending = true;
 				}
 				else if (ImGui::Button("Return to Menu")) {
-                    // set the menu state
-                    pong->resetGame(true);
+                    // set the menu state, the match is reset once we are back in the game
+                    gameStatus = 0;
+                    resetPending = true;
                     gameState = 0;
 				}
 				ImGui::End();
 			}
 			else {
-                time = -1;
+                matchStarted = false;
 				ImGui::Begin("You have Lost! :(");
 				if (ImGui::Button("Replay")) {
-                    pong->resetGame(true);
+                    // the next frame starts the match again, which resets it
+                    gameStatus = 0;
+                    resetPending = true;
 				}
 				else if (ImGui::Button("Return to Menu")) {
-                    // set the menu state
-                    pong->resetGame(true);
+                    // set the menu state, the match is reset once we are back in the game
+                    gameStatus = 0;
+                    resetPending = true;
                     gameState = 0;
 				}
 				ImGui::End(); 
 			}
 
-            gameStatus = pong->gameStatus();
+            if (!resetPending || snapshot.status == 0) {
+                resetPending = false;
+                gameStatus = snapshot.status;
+            }
+        }
+        else if (gameState == 2) {
+            if (netSession == nullptr) {
+                int choice = buildMultiplayerMenu(&netSettings);
+                if (choice == 1) {
+                    // the network thread reads the input queue now, so the single player simulation waits until we are back
+                    simThread->stop();
+                    netSession = new NetSession();
+                    netSession->setInputQueue(inputQueue);
+                    netSession->setLockstep(netSettings.lockstep, netSettings.inputDelay);
+                    NetSession::Role role = netSettings.role == 0 ? NetSession::HOST : NetSession::JOIN;
+                    if (!netSession->start(role, (unsigned short)netSettings.localPort, netSettings.host, (unsigned short)netSettings.remotePort,
+                        netSettings.link, ballSpeed, barSpeed, maxScore)) {
+                        delete netSession;
+                        netSession = nullptr;
+                        simThread->start();
+                    }
+                }
+                else if (choice == -1) {
+                    gameState = 0;
+                }
+            }
+            else {
+                bool leave = buildNetStatus(netSession->latestStats());
+                if (netSession->latestStats().state == NetSession::PLAYING) {
+                    const PongSnapshot& netSnapshot = netSession->latestSnapshot();
+                    profiler->beginPhase(Profiler::DRAW);
+                    pong->draw(netSnapshot);
+                    profiler->setRenderCounts(pong->drawCalls, pong->stateChanges);
+                    profiler->endPhase(Profiler::DRAW);
+
+                    // the host plays the left bar, so a left win is only our win if we are hosting
+                    if (netSnapshot.status != 0) {
+                        bool won = (netSnapshot.status == 1) == netSession->isLeftPlayer();
+                        ImGui::Begin(won ? "You have Won! :)" : "You have Lost! :(");
+                        if (ImGui::Button("Return to Menu")) {
+                            leave = true;
+                        }
+                        ImGui::End();
+                    }
+                }
+                if (leave) {
+                    netSession->stop();
+                    delete netSession;
+                    netSession = nullptr;
+                    simThread->start();
+                    gameState = 0;
+                }
+            }
         }
         
 
+        profiler->beginPhase(Profiler::IMGUI);
         ImGui::Render();
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler->endPhase(Profiler::IMGUI);
+        profiler->endGpuWork();
 
+        profiler->beginPhase(Profiler::SWAP);
         glfwSwapBuffers(window);
+        profiler->endPhase(Profiler::SWAP);
+
+        // objects released a few frames ago are no longer in use by the gpu
+        resources->endFrame();
 
+        profiler->endFrame();
     }
     
      // Cleanup
+    if (netSession != nullptr) {
+        netSession->stop();
+        delete netSession;
+    }
+    UdpSocket::shutdown();
+    simThread->stop();
+    simThread->finishRecording();
+    delete simThread;
+    delete recorder;
+    glfwSetWindowUserPointer(window, nullptr);
+    delete inputQueue;
+    profiler->destroyQueries();
+    delete profiler;
+    pong->destroyState();
+    delete pong;
+    // nothing is in flight any more, delete whatever is still waiting and report anything never released
+    resources->flush();
+    resources->reportLeaks();
+    delete resources;
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();